@@ -0,0 +1,51 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> s_allocationCount{ 0 };
+
+uint64_t AllocationCounter::GetCount() {
+    return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+// The array, nothrow and sized variants forward to these by default.
+
+void* operator new(size_t size) {
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = malloc(size == 0 ? 1 : size))
+        return memory;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, (size_t)alignment);
+#else
+    // aligned_alloc needs the size to be a multiple of the alignment.
+    size_t alignedSize = ((size == 0 ? 1 : size) + (size_t)alignment - 1) & ~((size_t)alignment - 1);
+    void* memory = aligned_alloc((size_t)alignment, alignedSize);
+#endif
+
+    if (memory)
+        return memory;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Counts the calls to the global operator new of the benchmark executable. The operators are replaced in AllocationCounter.cpp,
+/// so allocations made by the engine, the standard library and the Vulkan loader (if it uses operator new) are all counted.
+/// </summary>
+namespace AllocationCounter {
+    /// <returns>Number of allocations since the start of the program.</returns>
+    uint64_t GetCount();
+}
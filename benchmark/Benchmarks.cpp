@@ -0,0 +1,10 @@
+#include "Benchmarks.h"
+
+std::vector<Benchmark> GetBenchmarks() {
+    return {
+        { "pipeline_cache", BenchmarkPipelineCache },
+        { "serialization", BenchmarkSerialization },
+        { "file_io", BenchmarkFileIo },
+        { "transform_storage", BenchmarkTransformStorage },
+    };
+}
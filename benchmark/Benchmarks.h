@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+/// <summary>
+/// Compares an engine path with the one it replaced, or with itself under different settings, and logs the results.
+/// Returns EXIT_FAILURE if it couldn't run or the paths didn't produce the same data.
+/// </summary>
+struct Benchmark {
+    const char* name;
+    std::function<int()> run;
+};
+
+/// <returns>pipeline_cache, serialization, file_io and transform_storage.</returns>
+std::vector<Benchmark> GetBenchmarks();
+
+int BenchmarkPipelineCache();
+int BenchmarkSerialization();
+int BenchmarkFileIo();
+int BenchmarkTransformStorage();
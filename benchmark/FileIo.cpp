@@ -0,0 +1,89 @@
+#include "Benchmarks.h"
+#include "Fixtures.h"
+
+#include <ILog.h>
+
+#include <tools/File.h>
+#include <tools/Timer.h>
+
+#include <filesystem>
+#include <random>
+#include <span>
+#include <string>
+
+/// <summary>
+/// Writes and reads 1000 small files, the size of shaders and configs, with the string based Tools::ReadFile and Tools::WriteFile,
+/// with a reused buffer and with Tools::ReadFiles, and logs the time of each.
+/// </summary>
+int BenchmarkFileIo() {
+    constexpr uint32_t FILE_COUNT = 1000;
+    constexpr uint32_t ITERATION_COUNT = 5;
+    const std::string directory = "shaders/cache/BenchmarkFiles";
+
+    std::filesystem::create_directories(directory);
+
+    std::mt19937 random{ RANDOM_SEED };
+    std::uniform_int_distribution<size_t> sizeDistribution{ 512, 16 * 1024 };
+
+    std::vector<std::string> filenames{};
+    std::vector<std::string> contents{};
+    for (uint32_t i = 0; i < FILE_COUNT; i++) {
+        filenames.push_back(directory + "/" + std::to_string(i) + ".hlsl");
+        contents.push_back(std::string(sizeDistribution(random), (char)('a' + i % 26)));
+    }
+
+    IRun::Tools::IoFlags writeFlags = IRun::Tools::IoFlags::Create | IRun::Tools::IoFlags::Binary | IRun::Tools::IoFlags::Discard;
+
+    IRun::Tools::Timer<IRun::Tools::Milliseconds> timer{};
+    double stringWriteTime = 0.0, spanWriteTime = 0.0, stringReadTime = 0.0, bufferReadTime = 0.0, batchReadTime = 0.0;
+    size_t bytesRead = 0;
+
+    std::vector<uint8_t> buffer{};
+    std::vector<std::vector<uint8_t>> buffers{};
+
+    for (uint32_t iteration = 0; iteration < ITERATION_COUNT; iteration++) {
+        timer.Start();
+        for (uint32_t i = 0; i < FILE_COUNT; i++)
+            IRun::Tools::WriteFile(filenames[i], std::vector<char>{ contents[i].begin(), contents[i].end() }, writeFlags);
+        stringWriteTime += timer.Stop();
+
+        timer.Start();
+        for (uint32_t i = 0; i < FILE_COUNT; i++)
+            IRun::Tools::WriteFile(filenames[i], std::span<const uint8_t>{ (const uint8_t*)contents[i].data(), contents[i].size() }, writeFlags);
+        spanWriteTime += timer.Stop();
+
+        timer.Start();
+        for (uint32_t i = 0; i < FILE_COUNT; i++)
+            bytesRead += IRun::Tools::ReadFile(filenames[i], IRun::Tools::IoFlags::Binary).size();
+        stringReadTime += timer.Stop();
+
+        timer.Start();
+        for (uint32_t i = 0; i < FILE_COUNT; i++) {
+            IRun::Tools::ReadFile(filenames[i], buffer);
+            bytesRead += buffer.size();
+        }
+        bufferReadTime += timer.Stop();
+
+        timer.Start();
+        std::vector<IRun::ErrorCode> results = IRun::Tools::ReadFiles(filenames, buffers);
+        batchReadTime += timer.Stop();
+
+        for (uint32_t i = 0; i < FILE_COUNT; i++) {
+            if (results[i] != IRun::ErrorCode::Success || buffers[i].size() != contents[i].size()) {
+                I_LOG_ERROR("File benchmark read something other than it wrote to %s!", filenames[i].c_str());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+
+    I_LOG_INFO("File benchmark, %u files, %u iterations (%zu KB read):", FILE_COUNT, ITERATION_COUNT, bytesRead / 1024);
+    I_LOG_INFO("    Write, copied into a vector: %.3f ms", stringWriteTime / ITERATION_COUNT);
+    I_LOG_INFO("    Write, span:                 %.3f ms", spanWriteTime / ITERATION_COUNT);
+    I_LOG_INFO("    Read, new string per file:   %.3f ms", stringReadTime / ITERATION_COUNT);
+    I_LOG_INFO("    Read, reused buffer:         %.3f ms", bufferReadTime / ITERATION_COUNT);
+    I_LOG_INFO("    Read, ReadFiles batch:       %.3f ms", batchReadTime / ITERATION_COUNT);
+
+    return EXIT_SUCCESS;
+}
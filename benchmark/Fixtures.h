@@ -0,0 +1,40 @@
+#pragma once
+
+#include <ecs/Components.h>
+
+#include <cmath>
+#include <vector>
+
+// Shared by the scenarios and the benchmarks, so every workload draws and stores the same quad.
+
+inline const std::vector<IRun::Vertex> QUAD_VERTEX_DATA = {
+    { { -0.5f, -0.5f,  0.0f }, { 0.0f, 1.0f } },  // Top Left:     0
+    { {  0.5f, -0.5f,  0.0f }, { 1.0f, 1.0f } },  // Top Right:    1
+    { {  0.5f,  0.5f,  0.0f }, { 1.0f, 0.0f } },  // Bottom Right: 2
+    { { -0.5f,  0.5f,  0.0f }, { 0.0f, 0.0f } },  // Bottom Left:  3
+};
+
+inline const std::vector<uint32_t> QUAD_INDEX_DATA = {
+    0, 1, 2, // Top Left
+    2, 3, 0  // Bottom Right
+};
+
+inline const IRun::ECS::Shader QUAD_SHADER = {
+    "shaders/vert.hlsl",
+    "shaders/frag.hlsl",
+    IRun::ShaderLanguage::HLSL
+};
+
+inline constexpr uint32_t RANDOM_SEED = 1234;
+
+/// <returns>The transform of the i-th quad of a quadCount grid that fills the view of the benchmark camera.</returns>
+inline IRun::ECS::Transform QuadTransform(uint32_t i, uint32_t quadCount) {
+    uint32_t gridSize = (uint32_t)ceilf(sqrtf((float)quadCount));
+    float spacing = 10.0f / (float)gridSize;
+
+    return {
+        { (float)(i % gridSize) * spacing - 5.0f, (float)(i / gridSize) * spacing - 5.0f, 0.0f },
+        { spacing * 0.8f, spacing * 0.8f, 1.0f },
+        { 0.0f, 0.0f, 0.0f }
+    };
+}
@@ -0,0 +1,141 @@
+#include <ILog.h>
+
+#include <renderer/camera/Camera3D.h>
+
+#include "Benchmarks.h"
+#include "Report.h"
+#include "Scenarios.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+// Runs the scenarios on a headless renderer and writes their results as json.
+//
+// Usage: Benchmarks [--frames N] [--warmup N] [--quads N] [--shaders N] [--threads N] [--scenario name] [--repeat N]
+//                   [--output results.json] [--baseline baseline.json] [--threshold percent] [--time-threshold percent]
+//        Benchmarks --benchmark name|all
+//
+// --benchmark runs the Cpu only benchmarks instead of the scenarios and only logs their results.
+// --repeat runs every scenario N times (1 by default) and reports the median of every measurement.
+// With --baseline the exit code is EXIT_FAILURE if the allocations, Vulkan commands or draw calls per frame of any scenario
+// went up by more than --threshold percent (1 by default), so a build can fail on it. Those are counted, so they don't change
+// with the machine or its load. Cpu time is only compared with --time-threshold, use it with --repeat on a quiet machine.
+// The renderer is headless, so it also runs on a software driver without a display, for example lavapipe by pointing
+// VK_DRIVER_FILES (VK_ICD_FILENAMES on older loaders) at its icd json.
+int main(int argc, char** argv) {
+    BenchmarkOptions options{};
+    std::string output = "benchmark_results.json", baseline{}, scenarioFilter{}, benchmarkFilter{};
+    double thresholdPercent = 1.0;
+    std::optional<double> timeThresholdPercent{};
+    uint32_t repeatCount = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            I_LOG_ERROR("Missing value of %s", arg.c_str());
+            return EXIT_FAILURE;
+        }
+
+        std::string value = argv[++i];
+
+        if (arg == "--frames")
+            options.frames = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--warmup")
+            options.warmupFrames = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--quads")
+            options.quadCount = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--shaders")
+            options.shaderCount = std::max((uint32_t)strtoul(value.c_str(), nullptr, 10), 1u);
+        else if (arg == "--threads")
+            options.recordingThreads = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--scenario")
+            scenarioFilter = value;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--baseline")
+            baseline = value;
+        else if (arg == "--repeat")
+            repeatCount = std::max((uint32_t)strtoul(value.c_str(), nullptr, 10), 1u);
+        else if (arg == "--threshold")
+            thresholdPercent = strtod(value.c_str(), nullptr);
+        else if (arg == "--time-threshold")
+            timeThresholdPercent = strtod(value.c_str(), nullptr);
+        else if (arg == "--benchmark")
+            benchmarkFilter = value;
+        else {
+            I_LOG_ERROR("Unknown argument %s", arg.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!benchmarkFilter.empty()) {
+        int result = EXIT_SUCCESS;
+
+        for (const Benchmark& benchmark : GetBenchmarks()) {
+            if (benchmarkFilter != "all" && benchmarkFilter != benchmark.name)
+                continue;
+
+            if (benchmark.run() != EXIT_SUCCESS)
+                result = EXIT_FAILURE;
+        }
+
+        return result;
+    }
+
+    IRun::Camera3D camera{ 90.0f, (float)BENCHMARK_WIDTH / (float)BENCHMARK_HEIGHT, glm::vec2{ 0.1f, 100.0f }, glm::vec3{ 0.0f, 0.0f, 6.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f } };
+
+    IRun::ECS::Helper helper{};
+
+    IRun::Vk::Renderer renderer{ camera, helper, BENCHMARK_WIDTH, BENCHMARK_HEIGHT };
+
+    if (options.recordingThreads > 0)
+        renderer.SetRecordingThreadCount(options.recordingThreads);
+
+    std::string device = renderer.GetDeviceProperties().deviceName;
+    I_LOG_INFO("Benchmarking on %s, %u frames after %u warmup frames, median of %u runs:", device.c_str(), options.frames, options.warmupFrames, repeatCount);
+
+    ScenarioContext context{ renderer, helper, options };
+    std::vector<ScenarioResult> results{};
+
+    for (const Scenario& scenario : GetScenarios()) {
+        if (!scenarioFilter.empty() && scenarioFilter != scenario.name)
+            continue;
+
+        std::vector<ScenarioResult> runs{};
+        for (uint32_t run = 0; run < repeatCount; run++)
+            runs.push_back(scenario.run(context));
+
+        ScenarioResult result = MedianOfRuns(runs);
+
+        I_LOG_INFO("    %-16s %8.3f ms (p95 %8.3f ms), %10.1f allocations, %10.1f Vulkan commands, %6u draw calls",
+            result.name.c_str(), result.cpuMsPerFrame, result.cpuMsP95, result.allocationsPerFrame, result.vulkanCommandsPerFrame, result.drawCalls);
+
+        results.push_back(result);
+    }
+
+    renderer.Destroy();
+
+    if (!WriteReport(output, device, results))
+        return EXIT_FAILURE;
+
+    if (baseline.empty())
+        return EXIT_SUCCESS;
+
+    std::vector<ScenarioResult> baselineResults{};
+    if (!ReadReport(baseline, baselineResults))
+        return EXIT_FAILURE;
+
+    uint32_t regressionCount = CompareReports(baselineResults, results, thresholdPercent, timeThresholdPercent);
+
+    if (regressionCount > 0) {
+        I_LOG_ERROR("%u regressions against %s", regressionCount, baseline.c_str());
+        return EXIT_FAILURE;
+    }
+
+    I_LOG_INFO("No regressions against %s", baseline.c_str());
+
+    return EXIT_SUCCESS;
+}
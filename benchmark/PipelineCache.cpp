@@ -0,0 +1,124 @@
+#include "Benchmarks.h"
+#include "Fixtures.h"
+
+#include <ILog.h>
+
+#include <renderer/vulkan/PipelineCache.h>
+#include <tools/MappedFile.h>
+#include <tools/Timer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+// Legacy pipeline cache format, kept here to compare against: magic, size, std::hash of a string copy, device ids, uuid and the data.
+static constexpr size_t LEGACY_HEADER_SIZE = 4 + 8 + 8 + 4 + 4 + 4 + VK_UUID_SIZE;
+
+static size_t LegacyHash(const uint8_t* header, const uint8_t* data, size_t dataSize) {
+    // The legacy format built a string of every header field and the whole data to hash it.
+    std::string string = std::string{ header, header + 4 } + std::string{ header + 4, header + 12 } + std::string{ header + 20, header + LEGACY_HEADER_SIZE } + std::string{ data, data + dataSize };
+    return std::hash<std::string>()(string);
+}
+
+static void LegacySaveCache(const std::string& filename, const std::vector<uint8_t>& vulkanData) {
+    size_t dataSize = vulkanData.size();
+
+    // Copy of the data without the Vulkan header, then a copy with the IRun header.
+    std::vector<uint8_t> dataWithoutHeader(vulkanData.begin(), vulkanData.end());
+    std::vector<uint8_t> file(LEGACY_HEADER_SIZE + dataSize);
+    memcpy(file.data() + 4, &dataSize, 8);
+    size_t hash = LegacyHash(file.data(), dataWithoutHeader.data(), dataSize);
+    memcpy(file.data() + 12, &hash, 8);
+    memcpy(file.data() + LEGACY_HEADER_SIZE, dataWithoutHeader.data(), dataSize);
+
+    std::ofstream stream{ filename, std::ios::trunc | std::ios::binary };
+    stream.write((const char*)file.data(), file.size());
+}
+
+// Returns the size of the data that would be passed to vkCreatePipelineCache.
+static size_t LegacyRetrieveCache(const std::string& filename) {
+    std::ifstream stream{ filename, std::ios::binary | std::ios::ate };
+    std::vector<uint8_t> file((size_t)stream.tellg());
+    stream.seekg(std::ios_base::beg);
+    stream.read((char*)file.data(), file.size());
+
+    size_t dataSize = 0, hash = 0;
+    memcpy(&dataSize, file.data() + 4, 8);
+    memcpy(&hash, file.data() + 12, 8);
+
+    std::vector<uint8_t> dataWithoutHeader(file.begin() + LEGACY_HEADER_SIZE, file.begin() + LEGACY_HEADER_SIZE + dataSize);
+
+    if (LegacyHash(file.data(), dataWithoutHeader.data(), dataSize) != hash)
+        return 0;
+
+    // Converted back to the Vulkan format in a third buffer.
+    std::vector<uint8_t> vulkanData(dataWithoutHeader.begin(), dataWithoutHeader.end());
+    return vulkanData.size();
+}
+
+/// <summary>
+/// Saves and loads a 50 MB pipeline cache in the legacy format and in the current memory mapped format and logs the time of both.
+/// vkCreatePipelineCache is left out, both formats give it the same data.
+/// </summary>
+int BenchmarkPipelineCache() {
+    constexpr size_t CACHE_SIZE = 50 * 1024 * 1024;
+    constexpr uint32_t ITERATION_COUNT = 10;
+    const std::string legacyFilename = "shaders/cache/BenchmarkLegacyPipelineCache.bin";
+    const std::string filename = "shaders/cache/BenchmarkPipelineCache.bin";
+
+    std::filesystem::create_directories("shaders/cache");
+
+    std::vector<uint8_t> vulkanData(CACHE_SIZE);
+    std::mt19937_64 random{ RANDOM_SEED };
+    for (size_t i = 0; i + 8 <= vulkanData.size(); i += 8) {
+        uint64_t value = random();
+        memcpy(vulkanData.data() + i, &value, 8);
+    }
+
+    VkPhysicalDeviceProperties properties{};
+    properties.vendorID = 0x10DE;
+    properties.deviceID = 0x2684;
+    properties.driverVersion = 1;
+
+    IRun::Tools::Timer<IRun::Tools::Milliseconds> timer{};
+    double legacySaveTime = 0.0, legacyLoadTime = 0.0, saveTime = 0.0, loadTime = 0.0;
+
+    for (uint32_t i = 0; i < ITERATION_COUNT; i++) {
+        timer.Start();
+        LegacySaveCache(legacyFilename, vulkanData);
+        legacySaveTime += timer.Stop();
+
+        timer.Start();
+        size_t legacySize = LegacyRetrieveCache(legacyFilename);
+        legacyLoadTime += timer.Stop();
+
+        timer.Start();
+        IRun::Vk::PipelineCache::WriteCacheFile(filename, properties, vulkanData.data(), vulkanData.size());
+        saveTime += timer.Stop();
+
+        timer.Start();
+        IRun::Tools::MappedFile file{};
+        std::pair<const uint8_t*, size_t> data{};
+        IRun::ErrorCode err = IRun::Vk::PipelineCache::MapCacheFile(filename, properties, file, data);
+        file.Destroy();
+        loadTime += timer.Stop();
+
+        if (legacySize != CACHE_SIZE || err != IRun::ErrorCode::Success || data.second != CACHE_SIZE) {
+            I_LOG_ERROR("Pipeline cache benchmark failed to load a cache it saved!");
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::filesystem::remove(legacyFilename);
+    std::filesystem::remove(filename);
+
+    I_LOG_INFO("Pipeline cache benchmark, %zu MB, %u iterations:", CACHE_SIZE / (1024 * 1024), ITERATION_COUNT);
+    I_LOG_INFO("    Legacy: save %.3f ms, load %.3f ms", legacySaveTime / ITERATION_COUNT, legacyLoadTime / ITERATION_COUNT);
+    I_LOG_INFO("    Mapped: save %.3f ms, load %.3f ms", saveTime / ITERATION_COUNT, loadTime / ITERATION_COUNT);
+    I_LOG_INFO("    %.1fx faster load", legacyLoadTime / std::max(loadTime, 0.001));
+
+    return EXIT_SUCCESS;
+}
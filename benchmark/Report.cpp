@@ -0,0 +1,158 @@
+#include "Report.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+template<typename Type>
+static Type Median(const std::vector<ScenarioResult>& runs, Type ScenarioResult::* measurement) {
+    std::vector<Type> values{};
+    for (const ScenarioResult& run : runs)
+        values.push_back(run.*measurement);
+
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+ScenarioResult MedianOfRuns(const std::vector<ScenarioResult>& runs) {
+    ScenarioResult result = runs[0];
+    result.runs = (uint32_t)runs.size();
+    result.cpuMsPerFrame = Median(runs, &ScenarioResult::cpuMsPerFrame);
+    result.cpuMsP95 = Median(runs, &ScenarioResult::cpuMsP95);
+    result.allocationsPerFrame = Median(runs, &ScenarioResult::allocationsPerFrame);
+    result.vulkanCommandsPerFrame = Median(runs, &ScenarioResult::vulkanCommandsPerFrame);
+    result.drawCalls = Median(runs, &ScenarioResult::drawCalls);
+
+    return result;
+}
+
+bool WriteReport(const std::string& filename, const std::string& device, const std::vector<ScenarioResult>& results) {
+    std::ofstream file{ filename, std::ios::trunc };
+
+    if (!file.is_open()) {
+        I_LOG_ERROR("Failed to open benchmark report: %s", filename.c_str());
+        return false;
+    }
+
+    file << "{\n";
+    file << "    \"device\": \"" << device << "\",\n";
+    file << "    \"scenarios\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const ScenarioResult& result = results[i];
+
+        char line[512]{};
+        snprintf(line, sizeof(line),
+            "        { \"name\": \"%s\", \"frames\": %u, \"runs\": %u, \"cpu_ms_per_frame\": %.4f, \"cpu_ms_p95\": %.4f, \"allocations_per_frame\": %.2f, \"vulkan_commands_per_frame\": %.2f, \"draw_calls\": %u }%s\n",
+            result.name.c_str(), result.frames, result.runs, result.cpuMsPerFrame, result.cpuMsP95, result.allocationsPerFrame, result.vulkanCommandsPerFrame, result.drawCalls,
+            i + 1 < results.size() ? "," : ""
+        );
+
+        file << line;
+    }
+
+    file << "    ]\n";
+    file << "}\n";
+
+    file.close();
+
+    if (!file) {
+        I_LOG_ERROR("Failed to write benchmark report: %s", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Only reads what WriteReport writes, every scenario is on its own line.
+static bool FindValue(const std::string& line, const std::string& key, std::string& value) {
+    size_t offset = line.find("\"" + key + "\":");
+    if (offset == std::string::npos)
+        return false;
+
+    offset = line.find_first_not_of(' ', offset + key.size() + 3);
+    if (offset == std::string::npos)
+        return false;
+
+    if (line[offset] == '"') {
+        size_t end = line.find('"', offset + 1);
+        if (end == std::string::npos)
+            return false;
+
+        value = line.substr(offset + 1, end - offset - 1);
+        return true;
+    }
+
+    size_t end = line.find_first_of(",}", offset);
+    value = line.substr(offset, end - offset);
+    return true;
+}
+
+bool ReadReport(const std::string& filename, std::vector<ScenarioResult>& results) {
+    std::ifstream file{ filename };
+
+    if (!file.is_open()) {
+        I_LOG_ERROR("Failed to open benchmark report: %s", filename.c_str());
+        return false;
+    }
+
+    std::string line{};
+    while (std::getline(file, line)) {
+        ScenarioResult result{};
+        std::string value{};
+
+        if (!FindValue(line, "name", result.name))
+            continue;
+
+        if (FindValue(line, "frames", value))
+            result.frames = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        if (FindValue(line, "runs", value))
+            result.runs = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        if (FindValue(line, "cpu_ms_per_frame", value))
+            result.cpuMsPerFrame = strtod(value.c_str(), nullptr);
+        if (FindValue(line, "cpu_ms_p95", value))
+            result.cpuMsP95 = strtod(value.c_str(), nullptr);
+        if (FindValue(line, "allocations_per_frame", value))
+            result.allocationsPerFrame = strtod(value.c_str(), nullptr);
+        if (FindValue(line, "vulkan_commands_per_frame", value))
+            result.vulkanCommandsPerFrame = strtod(value.c_str(), nullptr);
+        if (FindValue(line, "draw_calls", value))
+            result.drawCalls = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+
+        results.push_back(result);
+    }
+
+    return true;
+}
+
+static bool CheckRegression(const std::string& scenario, const char* measurement, double baseline, double result, double thresholdPercent) {
+    // Counts of 0 stay 0, anything above is a regression.
+    if (result <= baseline * (1.0 + thresholdPercent / 100.0))
+        return false;
+
+    I_LOG_ERROR("Regression in %s: %s went from %.3f to %.3f (threshold %.1f%%)", scenario.c_str(), measurement, baseline, result, thresholdPercent);
+    return true;
+}
+
+uint32_t CompareReports(const std::vector<ScenarioResult>& baseline, const std::vector<ScenarioResult>& results, double thresholdPercent, std::optional<double> timeThresholdPercent) {
+    uint32_t regressionCount = 0;
+
+    for (const ScenarioResult& result : results) {
+        for (const ScenarioResult& baselineResult : baseline) {
+            if (baselineResult.name != result.name)
+                continue;
+
+            regressionCount += CheckRegression(result.name, "allocations_per_frame", baselineResult.allocationsPerFrame, result.allocationsPerFrame, thresholdPercent);
+            regressionCount += CheckRegression(result.name, "vulkan_commands_per_frame", baselineResult.vulkanCommandsPerFrame, result.vulkanCommandsPerFrame, thresholdPercent);
+            regressionCount += CheckRegression(result.name, "draw_calls", baselineResult.drawCalls, result.drawCalls, thresholdPercent);
+
+            if (timeThresholdPercent)
+                regressionCount += CheckRegression(result.name, "cpu_ms_per_frame", baselineResult.cpuMsPerFrame, result.cpuMsPerFrame, *timeThresholdPercent);
+        }
+    }
+
+    return regressionCount;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Measurements of one scenario, averaged over its measured frames.
+/// </summary>
+struct ScenarioResult {
+    std::string name;
+    uint32_t frames = 0;
+    // Times the scenario was run, every measurement is the median of the runs.
+    uint32_t runs = 1;
+    // Scenario update and IRun::Vk::FrameTimings::cpuMs, so waiting on the Gpu isn't counted.
+    double cpuMsPerFrame = 0.0;
+    double cpuMsP95 = 0.0;
+    // Counted, not timed, so they are the same on every run and every machine with the same driver.
+    double allocationsPerFrame = 0.0;
+    // IRun::Vk::DrawStats::commands.
+    double vulkanCommandsPerFrame = 0.0;
+    uint32_t drawCalls = 0;
+};
+
+/// <summary>
+/// Combine the runs of one scenario, every measurement is the median of that measurement over the runs.
+/// </summary>
+/// <param name="runs">At least one run.</param>
+ScenarioResult MedianOfRuns(const std::vector<ScenarioResult>& runs);
+
+/// <summary>
+/// Write the results as json, one scenario per line so the file diffs well.
+/// </summary>
+/// <returns>False if the file couldn't be written.</returns>
+bool WriteReport(const std::string& filename, const std::string& device, const std::vector<ScenarioResult>& results);
+
+/// <summary>
+/// Read the scenarios of a report written by WriteReport.
+/// </summary>
+/// <returns>False if the file couldn't be read.</returns>
+bool ReadReport(const std::string& filename, std::vector<ScenarioResult>& results);
+
+/// <summary>
+/// Compare the allocations, Vulkan commands and draw calls per frame of every scenario against the baseline scenario with the same name
+/// and log every count more than thresholdPercent higher. Scenarios missing from either report are skipped.
+/// Cpu time depends on the machine and its load, it is only compared if timeThresholdPercent is set, and should then be the median of several runs.
+/// </summary>
+/// <returns>Number of regressions.</returns>
+uint32_t CompareReports(const std::vector<ScenarioResult>& baseline, const std::vector<ScenarioResult>& results, double thresholdPercent, std::optional<double> timeThresholdPercent);
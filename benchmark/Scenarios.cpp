@@ -0,0 +1,277 @@
+#include "Scenarios.h"
+
+#include "AllocationCounter.h"
+#include "Fixtures.h"
+
+#include <tools/Timer.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+/// <summary>
+/// Quads with a mesh each so draws aren't merged by instancing and recording does real work.
+/// </summary>
+struct Quads {
+    std::vector<IRun::ECS::Entity> entities{};
+
+    Quads(ScenarioContext& context, uint32_t quadCount, const std::vector<IRun::ECS::Shader>& shaders) {
+        for (uint32_t i = 0; i < quadCount; i++) {
+            uint32_t mesh = context.renderer.CreateMesh({ QUAD_VERTEX_DATA }, { QUAD_INDEX_DATA });
+
+            IRun::ECS::Entity entity = context.helper.create<IRun::ECS::Mesh, IRun::ECS::Shader, IRun::ECS::Transform>(
+                { mesh }, shaders[i % shaders.size()], QuadTransform(i, quadCount)
+            );
+
+            context.renderer.AddEntity(entity);
+            entities.push_back(entity);
+
+            // The entity keeps the mesh alive.
+            context.renderer.DestroyMesh(mesh);
+        }
+    }
+
+    void Destroy(ScenarioContext& context) {
+        for (IRun::ECS::Entity entity : entities) {
+            context.renderer.RemoveEntity(entity);
+            context.helper.remove(entity);
+        }
+
+        entities.clear();
+    }
+};
+
+/// <summary>
+/// Draws the warmup frames and then the measured frames, calling update before every frame.
+/// Allocations and Cpu time are those of update and Renderer::Draw.
+/// </summary>
+static ScenarioResult MeasureFrames(const std::string& name, ScenarioContext& context, const std::function<void(uint32_t)>& update) {
+    const BenchmarkOptions& options = context.options;
+
+    std::vector<double> cpuTimes{};
+    cpuTimes.reserve(options.frames);
+    uint64_t allocationCount = 0, commandCount = 0;
+
+    IRun::Tools::Timer<IRun::Tools::Milliseconds> timer{};
+
+    for (uint32_t frame = 0; frame < options.warmupFrames + options.frames; frame++) {
+        uint64_t allocationsBefore = AllocationCounter::GetCount();
+
+        timer.Start();
+        update(frame);
+        double updateTime = timer.Stop();
+
+        context.renderer.Draw();
+
+        uint64_t allocations = AllocationCounter::GetCount() - allocationsBefore;
+
+        if (frame < options.warmupFrames)
+            continue;
+
+        cpuTimes.push_back(updateTime + context.renderer.GetFrameTimings().cpuMs);
+        allocationCount += allocations;
+        commandCount += context.renderer.GetDrawStats().commands;
+    }
+
+    ScenarioResult result{};
+    result.name = name;
+    result.frames = options.frames;
+    result.drawCalls = context.renderer.GetDrawStats().drawCalls;
+
+    if (options.frames == 0)
+        return result;
+
+    double totalTime = 0.0;
+    for (double time : cpuTimes)
+        totalTime += time;
+
+    std::sort(cpuTimes.begin(), cpuTimes.end());
+
+    result.cpuMsPerFrame = totalTime / (double)options.frames;
+    result.cpuMsP95 = cpuTimes[std::min((size_t)((double)cpuTimes.size() * 0.95), cpuTimes.size() - 1)];
+    result.allocationsPerFrame = (double)allocationCount / (double)options.frames;
+    result.vulkanCommandsPerFrame = (double)commandCount / (double)options.frames;
+
+    return result;
+}
+
+static ScenarioResult StaticQuads(ScenarioContext& context) {
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines({ QUAD_SHADER });
+    Quads quads{ context, context.options.quadCount, { QUAD_SHADER } };
+
+    ScenarioResult result = MeasureFrames("static_quads", context, [](uint32_t) {});
+
+    quads.Destroy(context);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+static ScenarioResult MovingQuads(ScenarioContext& context) {
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines({ QUAD_SHADER });
+    Quads quads{ context, context.options.quadCount, { QUAD_SHADER } };
+
+    std::mt19937 random{ RANDOM_SEED };
+    std::uniform_real_distribution<float> phaseDistribution{ 0.0f, 6.283185f };
+
+    std::vector<float> phases(quads.entities.size());
+    for (float& phase : phases)
+        phase = phaseDistribution(random);
+
+    ScenarioResult result = MeasureFrames("moving_quads", context, [&](uint32_t frame) {
+        for (size_t i = 0; i < quads.entities.size(); i++) {
+            auto [transform] = context.helper.get<IRun::ECS::Transform>(quads.entities[i]);
+
+            IRun::ECS::Transform home = QuadTransform((uint32_t)i, (uint32_t)quads.entities.size());
+            float angle = phases[i] + (float)frame * 0.05f;
+
+            transform.position.x = home.position.x + cosf(angle) * 0.1f;
+            transform.position.y = home.position.y + sinf(angle) * 0.1f;
+            transform.rotation.z = (float)frame;
+        }
+    });
+
+    quads.Destroy(context);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+static ScenarioResult InstancedQuads(ScenarioContext& context) {
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines({ QUAD_SHADER });
+
+    // Every quad shares one mesh, so static_quads is the same frame without instancing.
+    uint32_t mesh = context.renderer.CreateMesh({ QUAD_VERTEX_DATA }, { QUAD_INDEX_DATA });
+
+    std::vector<IRun::ECS::Entity> entities{};
+    for (uint32_t i = 0; i < context.options.quadCount; i++) {
+        IRun::ECS::Entity entity = context.helper.create<IRun::ECS::Mesh, IRun::ECS::Shader, IRun::ECS::Transform>(
+            { mesh }, QUAD_SHADER, QuadTransform(i, context.options.quadCount)
+        );
+
+        context.renderer.AddEntity(entity);
+        entities.push_back(entity);
+    }
+
+    ScenarioResult result = MeasureFrames("instanced_quads", context, [](uint32_t) {});
+
+    for (IRun::ECS::Entity entity : entities) {
+        context.renderer.RemoveEntity(entity);
+        context.helper.remove(entity);
+    }
+
+    context.renderer.DestroyMesh(mesh);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+static ScenarioResult UniqueShaders(ScenarioContext& context) {
+    const std::string directory = "shaders/benchmark";
+    std::filesystem::create_directories(directory);
+
+    // A fragment shader per pipeline, each with its own colour so the compiler can't merge them.
+    std::vector<IRun::ECS::Shader> shaders{};
+    for (uint32_t i = 0; i < context.options.shaderCount; i++) {
+        std::string filename = directory + "/frag" + std::to_string(i) + ".hlsl";
+        float red = (float)i / (float)std::max(context.options.shaderCount, 1u);
+
+        std::ofstream file{ filename, std::ios::trunc };
+        file << "float4 main() : SV_TARGET\n{\n    return float4(" << red << "f, 0.5f, 1.0f, 1.0f);\n}\n";
+        file.close();
+
+        shaders.push_back({ QUAD_SHADER.vertexFilename, filename, IRun::ShaderLanguage::HLSL });
+    }
+
+    // Created up front so no measured frame is drawn with the fallback pipeline while they compile.
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines(shaders);
+    Quads quads{ context, context.options.quadCount, shaders };
+
+    ScenarioResult result = MeasureFrames("unique_shaders", context, [](uint32_t) {});
+
+    quads.Destroy(context);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+static ScenarioResult EntityChurn(ScenarioContext& context) {
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines({ QUAD_SHADER });
+    uint32_t quadCount = context.options.quadCount;
+    Quads quads{ context, quadCount, { QUAD_SHADER } };
+
+    // New entities share one mesh so the churn measures the entities, not buffer uploads.
+    uint32_t mesh = context.renderer.CreateMesh({ QUAD_VERTEX_DATA }, { QUAD_INDEX_DATA });
+
+    // 1% of the entities are replaced every frame, oldest first.
+    uint32_t churnCount = std::max(quadCount / 100, 1u);
+    size_t oldest = 0;
+
+    std::mt19937 random{ RANDOM_SEED };
+    std::uniform_int_distribution<uint32_t> slotDistribution{ 0, std::max(quadCount, 1u) - 1 };
+
+    ScenarioResult result = MeasureFrames("entity_churn", context, [&](uint32_t) {
+        for (uint32_t i = 0; i < churnCount && !quads.entities.empty(); i++) {
+            IRun::ECS::Entity& entity = quads.entities[oldest];
+
+            context.renderer.RemoveEntity(entity);
+            context.helper.remove(entity);
+
+            entity = context.helper.create<IRun::ECS::Mesh, IRun::ECS::Shader, IRun::ECS::Transform>(
+                { mesh }, QUAD_SHADER, QuadTransform(slotDistribution(random), quadCount)
+            );
+            context.renderer.AddEntity(entity);
+
+            oldest = (oldest + 1) % quads.entities.size();
+        }
+    });
+
+    quads.Destroy(context);
+    context.renderer.DestroyMesh(mesh);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+static ScenarioResult ResizeStorm(ScenarioContext& context) {
+    // Sizes cycled through, a resize every frame.
+    static constexpr std::array<VkExtent2D, 5> SIZES = { {
+        { 1920, 1080 }, { 800, 600 }, { 1024, 768 }, { 640, 480 }, { BENCHMARK_WIDTH, BENCHMARK_HEIGHT }
+    } };
+
+    std::vector<uint32_t> pipelines = context.renderer.CreateGraphicsPipelines({ QUAD_SHADER });
+    // Fewer quads, the resizes are what is measured.
+    Quads quads{ context, std::max(context.options.quadCount / 10, 1u), { QUAD_SHADER } };
+
+    ScenarioResult result = MeasureFrames("resize_storm", context, [&](uint32_t frame) {
+        const VkExtent2D& size = SIZES[frame % SIZES.size()];
+        context.renderer.Resize(size.width, size.height);
+    });
+
+    context.renderer.Resize(BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+
+    quads.Destroy(context);
+    for (uint32_t pipeline : pipelines)
+        context.renderer.DestroyGraphicsPipeline(pipeline);
+
+    return result;
+}
+
+std::vector<Scenario> GetScenarios() {
+    return {
+        { "static_quads", StaticQuads },
+        { "moving_quads", MovingQuads },
+        { "instanced_quads", InstancedQuads },
+        { "unique_shaders", UniqueShaders },
+        { "entity_churn", EntityChurn },
+        { "resize_storm", ResizeStorm },
+    };
+}
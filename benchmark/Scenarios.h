@@ -0,0 +1,39 @@
+#pragma once
+
+#include <renderer/vulkan/Renderer.h>
+
+#include "Report.h"
+
+#include <functional>
+
+// Size of the offscreen images, restored after the resize_storm scenario.
+constexpr uint32_t BENCHMARK_WIDTH = 1280, BENCHMARK_HEIGHT = 720;
+
+struct BenchmarkOptions {
+    // Frames drawn before measuring, so pipelines, buffers and caches are warm.
+    uint32_t warmupFrames = 30;
+    uint32_t frames = 300;
+    uint32_t quadCount = 10000;
+    // Pipelines in the unique_shaders scenario.
+    uint32_t shaderCount = 64;
+    // Threads recording the draws, 0 leaves the renderer's default.
+    uint32_t recordingThreads = 0;
+};
+
+struct ScenarioContext {
+    IRun::Vk::Renderer& renderer;
+    IRun::ECS::Helper& helper;
+    const BenchmarkOptions& options;
+};
+
+/// <summary>
+/// A scripted workload. Scenarios are deterministic, every run draws the same entities with the same transforms,
+/// and leave the renderer as they found it.
+/// </summary>
+struct Scenario {
+    const char* name;
+    std::function<ScenarioResult(ScenarioContext&)> run;
+};
+
+/// <returns>static_quads, moving_quads, instanced_quads, unique_shaders, entity_churn and resize_storm.</returns>
+std::vector<Scenario> GetScenarios();
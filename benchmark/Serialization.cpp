@@ -0,0 +1,103 @@
+#include "Benchmarks.h"
+#include "Fixtures.h"
+
+#include <ILog.h>
+
+#include <tools/Timer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+/// <summary>
+/// Serializes and deserializes 1000 entities with 1000 vertices each (1M vertices) with the text format and the binary format
+/// and logs the time and size of both.
+/// </summary>
+int BenchmarkSerialization() {
+    constexpr uint32_t ENTITY_COUNT = 1000;
+    constexpr uint32_t VERTEX_COUNT = 1000;
+
+    IRun::ECS::Helper helper{};
+    helper.index<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>("VertexData", "IndexData", "Shader");
+
+    std::mt19937 random{ RANDOM_SEED };
+    std::uniform_real_distribution<float> distribution{ -100.0f, 100.0f };
+
+    std::vector<IRun::ECS::Entity> entities{};
+    for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        IRun::ECS::VertexData vertexData{};
+        IRun::ECS::IndexData indexData{};
+
+        for (uint32_t vertex = 0; vertex < VERTEX_COUNT; vertex++) {
+            vertexData.data.push_back({ { distribution(random), distribution(random), distribution(random) }, { 0.0f, 0.0f } });
+            indexData.data.push_back(vertex);
+        }
+
+        entities.push_back(helper.create<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(
+            std::move(vertexData), std::move(indexData), QUAD_SHADER
+        ));
+    }
+
+    IRun::Tools::Timer<IRun::Tools::Milliseconds> timer{};
+
+    timer.Start();
+    std::vector<IRun::ECS::SerializedEntity> serializedEntities{};
+    for (IRun::ECS::Entity entity : entities)
+        serializedEntities.push_back(IRun::ECS::Serialize<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(helper, entity));
+    double textWriteTime = timer.Stop();
+
+    size_t textSize = 0;
+    for (const IRun::ECS::SerializedEntity& serializedEntity : serializedEntities)
+        for (const std::pair<std::string, std::string>& component : serializedEntity)
+            textSize += component.first.size() + component.second.size();
+
+    timer.Start();
+    std::vector<IRun::ECS::Entity> textEntities{};
+    for (const IRun::ECS::SerializedEntity& serializedEntity : serializedEntities)
+        textEntities.push_back(IRun::ECS::Deserialize<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(helper, serializedEntity));
+    double textReadTime = timer.Stop();
+
+    timer.Start();
+    std::vector<uint8_t> bytes{};
+    IRun::ECS::SerializeBinary<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(helper, entities, bytes);
+    double binaryWriteTime = timer.Stop();
+
+    timer.Start();
+    std::vector<IRun::ECS::Entity> binaryEntities{};
+    IRun::ErrorCode err = IRun::ECS::DeserializeBinary<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(helper, bytes.data(), bytes.size(), binaryEntities);
+    double binaryReadTime = timer.Stop();
+
+    // Only the vertices, read into preallocated storage without creating entities.
+    timer.Start();
+    IRun::ECS::BinaryScene scene{};
+    std::vector<IRun::ECS::VertexData> vertexStorage{};
+    vertexStorage.reserve(ENTITY_COUNT);
+    if (err == IRun::ErrorCode::Success)
+        err = IRun::ECS::ParseBinaryScene(bytes.data(), bytes.size(), scene);
+    if (err == IRun::ErrorCode::Success)
+        err = IRun::ECS::ReadBinaryColumn<IRun::ECS::VertexData>(scene.columns[0], vertexStorage);
+    double columnReadTime = timer.Stop();
+
+    if (err != IRun::ErrorCode::Success || binaryEntities.size() != ENTITY_COUNT || vertexStorage.size() != ENTITY_COUNT) {
+        I_LOG_ERROR("Serialization benchmark failed to read a scene it wrote: %s", IRun::ErrorCodeToString(err).c_str());
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        auto [original] = helper.get<IRun::ECS::VertexData>(entities[i]);
+        auto [binary] = helper.get<IRun::ECS::VertexData>(binaryEntities[i]);
+
+        if (binary.data.size() != original.data.size() || memcmp(binary.data.data(), original.data.data(), original.data.size() * sizeof(IRun::Vertex)) != 0) {
+            I_LOG_ERROR("Serialization benchmark read different vertices than it wrote!");
+            return EXIT_FAILURE;
+        }
+    }
+
+    I_LOG_INFO("Serialization benchmark, %u entities, %u vertices:", ENTITY_COUNT, ENTITY_COUNT * VERTEX_COUNT);
+    I_LOG_INFO("    Text:   write %.3f ms, read %.3f ms, %zu KB", textWriteTime, textReadTime, textSize / 1024);
+    I_LOG_INFO("    Binary: write %.3f ms, read %.3f ms, %zu KB", binaryWriteTime, binaryReadTime, bytes.size() / 1024);
+    I_LOG_INFO("    Binary vertices into preallocated storage: read %.3f ms", columnReadTime);
+    I_LOG_INFO("    %.1fx faster read", textReadTime / std::max(binaryReadTime, 0.001));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include "Benchmarks.h"
+#include "Fixtures.h"
+
+#include <ILog.h>
+
+#include <ecs/Archetype.h>
+#include <tools/Timer.h>
+
+#include <algorithm>
+
+/// <summary>
+/// Moves 100k entities and computes their model matrices once through IRun::ECS::Helper and once through an IRun::ECS::Archetype,
+/// and logs the time of both.
+/// </summary>
+int BenchmarkTransformStorage() {
+    constexpr uint32_t ENTITY_COUNT = 100000;
+    constexpr uint32_t ITERATION_COUNT = 100;
+
+    IRun::ECS::Helper helper{};
+    IRun::ECS::Archetype<IRun::ECS::Transform> archetype{};
+
+    std::vector<IRun::ECS::Entity> entities{};
+    for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        IRun::ECS::Transform transform = QuadTransform(i, ENTITY_COUNT);
+
+        IRun::ECS::Entity entity = helper.create<IRun::ECS::Transform>(transform);
+        archetype.Add(entity, transform);
+        entities.push_back(entity);
+    }
+
+    std::vector<glm::mat4> models(ENTITY_COUNT);
+    IRun::Tools::Timer<IRun::Tools::Milliseconds> timer{};
+    double helperTime = 0.0, archetypeTime = 0.0;
+
+    for (uint32_t iteration = 0; iteration < ITERATION_COUNT; iteration++) {
+        timer.Start();
+        for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+            auto [transform] = helper.get<IRun::ECS::Transform>(entities[i]);
+            transform.position.x += 0.001f;
+            transform.rotation.z += 1.0f;
+            models[i] = transform.GetModelMatrix();
+        }
+        helperTime += timer.Stop();
+
+        timer.Start();
+        uint32_t first = 0;
+        archetype.ForEachChunk([&models, &first](uint32_t count, const IRun::ECS::Entity*, IRun::ECS::Transform* transforms) {
+            for (uint32_t i = 0; i < count; i++) {
+                transforms[i].position.x += 0.001f;
+                transforms[i].rotation.z += 1.0f;
+                models[first + i] = transforms[i].GetModelMatrix();
+            }
+
+            first += count;
+        });
+        archetypeTime += timer.Stop();
+    }
+
+    for (uint32_t i = 0; i < ENTITY_COUNT; i += ENTITY_COUNT / 100) {
+        auto [transform] = helper.get<IRun::ECS::Transform>(entities[i]);
+
+        if (archetype.Get<IRun::ECS::Transform>(entities[i]).position != transform.position) {
+            I_LOG_ERROR("Transform storage benchmark moved the entities differently!");
+            return EXIT_FAILURE;
+        }
+    }
+
+    I_LOG_INFO("Transform storage benchmark, %u entities, %u iterations:", ENTITY_COUNT, ITERATION_COUNT);
+    I_LOG_INFO("    Helper:    %.3f ms per update", helperTime / ITERATION_COUNT);
+    I_LOG_INFO("    Archetype: %.3f ms per update", archetypeTime / ITERATION_COUNT);
+    I_LOG_INFO("    %.1fx faster", helperTime / std::max(archetypeTime, 0.001));
+
+    return EXIT_SUCCESS;
+}
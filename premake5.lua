@@ -6,6 +6,15 @@ workspace "IRun"
 
     vulkanSdk = os.getenv("VULKAN_SDK");
 
+    -- Linux packages install the Vulkan headers and libraries into /usr when there is no sdk.
+    if vulkanSdk == nil and os.istarget("linux") then
+        vulkanSdk = "/usr"
+    end
+
+    -- IWindow only supports Windows, on Linux only the headless renderer is built and hlsl is compiled with glslang instead of DXC.
+    -- Static libraries don't carry their links with gmake, so everything that links IRun on Linux links these after it.
+    linuxLinks = { "ILog", "vulkan", "glslang", "MachineIndependent", "GenericCodeGen", "OSDependent", "SPIRV-Tools-opt", "SPIRV-Tools", "pthread", "dl" }
+
     function defaultBuildCfg()
         filter "configurations:Debug"
             defines { "DEBUG" }
@@ -25,6 +34,8 @@ workspace "IRun"
         objdir ("bin-int/%{prj.name}/%{cfg.buildcfg}")
     end
 
+    -- Needs a window.
+    if os.istarget("windows") then
     startproject "TestApplication"
 
     project "TestApplication"
@@ -54,6 +65,46 @@ workspace "IRun"
 
         defaultBuildLocation()
         defaultBuildCfg()
+    end
+
+    project "Benchmarks"
+        location "benchmark"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+
+        includedirs { 
+            "%{prj.location}/", 
+            "%{prj.location}/../deps/glad/include", 
+            "%{prj.location}/../deps/ILog/", 
+            "%{prj.location}/../deps/IWindow/src",
+            "%{prj.location}/../deps/imgui/",
+            "%{prj.location}/../src/",
+            vulkanSdk .. "/Include",
+            "%{prj.location}/../deps/glm",
+            "%{prj.location}/../deps/CNtity/include",
+            "%{prj.location}/../deps/IStl/src",
+        }
+
+        files {"%{prj.location}/**.cpp", "%{prj.location}/**.h",}
+        
+        defines { "_CRT_SECURE_NO_WARNINGS" }
+
+        -- Uses the shaders of the test application.
+        debugdir "%{wks.location}/test"
+
+        filter "system:windows"
+            links {"IRun", "ImGui"}
+
+        filter "system:linux"
+            includedirs { vulkanSdk .. "/include" }
+            libdirs { vulkanSdk .. "/lib" }
+            links { "IRun", linuxLinks }
+
+        filter {}
+
+        defaultBuildLocation()
+        defaultBuildCfg()
 
 
     project "IRun"
@@ -76,11 +127,21 @@ workspace "IRun"
 
         files {"%{prj.location}/**.cpp", "%{prj.location}/**.h",}
         
-        libdirs { vulkanSdk .. "/Lib" }
-        links {"OpenGL32", "Vulkan-1", "IWindow", "ILog", "ImGui", "Glad", "Dxcompiler" }
-
         defines { "_CRT_SECURE_NO_WARNINGS" }
 
+        filter "system:windows"
+            libdirs { vulkanSdk .. "/Lib" }
+            links {"OpenGL32", "Vulkan-1", "IWindow", "ILog", "ImGui", "Glad", "Dxcompiler" }
+
+        filter "system:linux"
+            -- The OpenGL renderer and DXC are Windows only, see IRUN_WINDOWED in Core.h.
+            removefiles { "%{prj.location}/renderer/opengl/**", "%{prj.location}/tools/dxc/**" }
+            includedirs { vulkanSdk .. "/include" }
+            libdirs { vulkanSdk .. "/lib" }
+            links { linuxLinks }
+
+        filter {}
+
         defaultBuildLocation()
         defaultBuildCfg()
 
@@ -110,6 +171,7 @@ workspace "IRun"
         defaultBuildLocation()
         defaultBuildCfg()
     
+    if os.istarget("windows") then
     project "IWindow"
         location "deps/IWindow"
         kind "StaticLib"
@@ -153,4 +215,5 @@ workspace "IRun"
 
         defaultBuildLocation()
 
-        defaultBuildCfg()
\ No newline at end of file
+        defaultBuildCfg()
+    end
\ No newline at end of file
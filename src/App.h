@@ -2,6 +2,8 @@
 
 #include <IWindow.h>
 #include "renderer/vulkan/Renderer.h"
+#include "tools/JobSystem.h"
+#include "tools/AsyncReader.h"
 
 namespace IRun {
 	typedef std::vector<std::string> CommandLineArguments;
@@ -17,6 +19,15 @@ namespace IRun {
 		IWindow::Window window;
 		IRun::Vk::Renderer renderer;
 		IRun::ECS::Helper helper;
+		/// <summary>
+		/// Shared by every system that runs work in parallel. Created before OnCreate and destroyed after OnDestroy.
+		/// </summary>
+		IRun::Tools::JobSystem jobSystem;
+		/// <summary>
+		/// Reads files in the background. Created before OnCreate and destroyed after OnDestroy, callbacks run on the main thread
+		/// at the start of every frame so they can hand data to the renderer.
+		/// </summary>
+		IRun::Tools::AsyncReader asyncReader;
 	};
 
 
@@ -1,7 +1,12 @@
 #pragma once
 
-#ifndef _WIN32
-#error "IWindow only supports Windows!"
+// IWindow only supports Windows. Everywhere else only the headless renderer is built, see IRun::Vk::Renderer.
+#ifdef _WIN32
+#define IRUN_WINDOWED
+#else
+namespace IWindow {
+	class Window;
+}
 #endif
 
 #define IRUN_API
@@ -2,6 +2,10 @@
 
 #include "App.h"
 
+#include "tools/Profiler.h"
+
+#include <algorithm>
+
 
 int main(int argc, char** argv) {
 
@@ -10,34 +14,64 @@ int main(int argc, char** argv) {
 	for (int i = 0; i < argc; i++) 
 		args.push_back(argv[i]);
 
+	// --trace records Cpu profiler scopes and writes them to trace.json on exit.
+	bool trace = std::find(args.begin(), args.end(), "--trace") != args.end();
+	IRun::Tools::Profiler::SetEnabled(trace);
+	IRun::Tools::Profiler::SetThreadName("Main");
+
 	IWindow::Initialize(IWindow::CurrentVersion);
 
 	std::shared_ptr app = IRun::CreateApp();
 
+	app->jobSystem.Create();
+	app->asyncReader.Create();
+
 	app->helper.index<IRun::ECS::Shader, IRun::ECS::VertexData, IRun::ECS::IndexData>("Shader", "VertexData", "IndexData");
 
-	app->OnCreate(args);
+	{
+		IRUN_PROFILE_SCOPE("App::OnCreate");
+		app->OnCreate(args);
+	}
 
 	double currentTime = app->window.GetTime();
 	double lastTime = currentTime;
 	while (app->window.IsRunning()) {
+		IRUN_PROFILE_SCOPE("App::Frame");
+
 		currentTime = app->window.GetTime();
 		double dt = currentTime - lastTime;
 
+		app->asyncReader.Poll();
 
 		// Does nothing until imgui support is added to the Vulkan renderer
 		// app->OnUIRender(dt);
 
-		app->OnRender(dt);
+		{
+			IRUN_PROFILE_SCOPE("App::OnRender");
+			app->OnRender(dt);
+		}
+
+		{
+			IRUN_PROFILE_SCOPE("App::OnUpdate");
+			app->OnUpdate(dt);
 
-		app->OnUpdate(dt);
+			app->OnUpdate(dt);
+		}
+
+		{
+			IRUN_PROFILE_SCOPE("Window::Update");
+			app->window.Update();
+		}
 
-		app->OnUpdate(dt);
-		app->window.Update();
 		lastTime = currentTime;
 	}
 
 	app->OnDestroy();
+	app->asyncReader.Destroy();
 	app->renderer.Destroy();
 	app->window.Destroy();
+	app->jobSystem.Destroy();
+
+	if (trace)
+		IRun::Tools::Profiler::WriteChromeTrace("trace.json");
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <ILog.h>
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Components.h"
+
+namespace IRun {
+	namespace ECS {
+		/// <summary>
+		/// Storage for entities that all have the same trivially copyable components, meant for components that are read or written every
+		/// frame like IRun::ECS::Transform. Components are kept in chunks of CHUNK_CAPACITY entities and a chunk holds an array per component
+		/// type (structure of arrays), so a pass over a component reads memory linearly and can be vectorized.
+		/// Entities are kept packed, removing one moves the last entity into its place. Separate from IRun::ECS::Helper, an entity
+		/// can have its hot components here and the rest in the helper.
+		/// </summary>
+		template<typename ...Components>
+		class Archetype {
+			static_assert(sizeof...(Components) > 0, "IRun::ECS::Archetype needs at least one component.");
+			static_assert((std::is_trivially_copyable_v<Components> && ...), "IRun::ECS::Archetype components are moved with memcpy, they must be trivially copyable.");
+			static_assert((std::is_default_constructible_v<Components> && ...), "IRun::ECS::Archetype components must be default constructible.");
+		public:
+			static constexpr uint32_t CHUNK_CAPACITY = 1024;
+
+			Archetype() = default;
+			/// <summary>
+			/// Add an entity with its components. Amortized constant time, a chunk is allocated every CHUNK_CAPACITY entities.
+			/// </summary>
+			void Add(Entity entity, const Components&... components) {
+				I_ASSERT_FATAL_ERROR(m_indices.contains(entity), "IRun::ECS::Archetype::Add failed. The entity is already in the archetype!");
+
+				if (m_count == m_chunks.size() * CHUNK_CAPACITY)
+					m_chunks.push_back(std::make_unique<Chunk>());
+
+				Chunk& chunk = *m_chunks[m_count / CHUNK_CAPACITY];
+				uint32_t slot = m_count % CHUNK_CAPACITY;
+
+				chunk.entities[slot] = entity;
+				((std::get<ComponentArray<Components>>(chunk.components).data[slot] = components), ...);
+
+				m_indices.insert({ entity, m_count });
+				m_count++;
+			}
+			/// <summary>
+			/// Remove an entity. The last entity is moved into its place, chunks are kept for entities added later.
+			/// </summary>
+			void Remove(Entity entity) {
+				auto itr = m_indices.find(entity);
+				I_ASSERT_FATAL_ERROR(itr == m_indices.end(), "IRun::ECS::Archetype::Remove failed. The entity is not in the archetype!");
+
+				uint32_t index = itr->second;
+				uint32_t last = m_count - 1;
+				m_indices.erase(itr);
+
+				if (index != last) {
+					Chunk& chunk = *m_chunks[index / CHUNK_CAPACITY];
+					Chunk& lastChunk = *m_chunks[last / CHUNK_CAPACITY];
+					uint32_t slot = index % CHUNK_CAPACITY, lastSlot = last % CHUNK_CAPACITY;
+
+					chunk.entities[slot] = lastChunk.entities[lastSlot];
+					((std::get<ComponentArray<Components>>(chunk.components).data[slot] = std::get<ComponentArray<Components>>(lastChunk.components).data[lastSlot]), ...);
+
+					m_indices[chunk.entities[slot]] = index;
+				}
+
+				m_count--;
+			}
+			/// <returns>If the entity is in the archetype.</returns>
+			inline bool Has(Entity entity) const { return m_indices.contains(entity); }
+			/// <summary>
+			/// Look up a component of one entity. Use Archetype::ForEachChunk to go over many entities.
+			/// </summary>
+			/// <returns>The component, valid until an entity is added or removed.</returns>
+			template<typename Component>
+			Component& Get(Entity entity) {
+				auto itr = m_indices.find(entity);
+				I_ASSERT_FATAL_ERROR(itr == m_indices.end(), "IRun::ECS::Archetype::Get failed. The entity is not in the archetype!");
+
+				return std::get<ComponentArray<Component>>(m_chunks[itr->second / CHUNK_CAPACITY]->components).data[itr->second % CHUNK_CAPACITY];
+			}
+			/// <summary>
+			/// Call function once per chunk with the number of entities in it and a pointer to the first entity and to the first of every
+			/// component: function(uint32_t count, const Entity* entities, Components*... components). The arrays are 64 byte aligned.
+			/// Entities must not be added or removed from inside of function.
+			/// </summary>
+			template<typename Function>
+			void ForEachChunk(Function&& function) {
+				for (uint32_t chunk = 0; chunk * CHUNK_CAPACITY < m_count; chunk++) {
+					Chunk& data = *m_chunks[chunk];
+					uint32_t count = std::min(m_count - chunk * CHUNK_CAPACITY, CHUNK_CAPACITY);
+
+					function(count, (const Entity*)data.entities, std::get<ComponentArray<Components>>(data.components).data...);
+				}
+			}
+			/// <summary>
+			/// Call function for every entity: function(Entity entity, Components&... components). Entities must not be added or removed from inside of function.
+			/// </summary>
+			template<typename Function>
+			void ForEach(Function&& function) {
+				ForEachChunk([&function](uint32_t count, const Entity* entities, Components*... components) {
+					for (uint32_t i = 0; i < count; i++)
+						function(entities[i], components[i]...);
+				});
+			}
+			/// <returns>Number of entities.</returns>
+			inline uint32_t GetCount() const { return m_count; }
+			/// <summary>
+			/// Remove every entity and free every chunk.
+			/// </summary>
+			inline void Clear() {
+				m_chunks.clear();
+				m_indices.clear();
+				m_count = 0;
+			}
+		private:
+			// Cache line aligned so chunk passes start on a cache line and vector loads of the first elements are aligned.
+			template<typename Component>
+			struct alignas(64) ComponentArray {
+				Component data[CHUNK_CAPACITY];
+			};
+
+			struct Chunk {
+				Entity entities[CHUNK_CAPACITY];
+				std::tuple<ComponentArray<Components>...> components;
+			};
+
+			// Behind pointers so components don't move when a chunk is added.
+			std::vector<std::unique_ptr<Chunk>> m_chunks;
+			std::unordered_map<Entity, uint32_t> m_indices;
+			uint32_t m_count = 0;
+		};
+	}
+}
@@ -3,8 +3,11 @@
 #include <CNtity/Helper.hpp>
 #include <ILog.h>
 #include <array>
+#include <cstring>
+#include <type_traits>
 #include <vector>
 
+#include "Error.h"
 #include "renderer/Vertex.h"
 #include "renderer/ShaderLang.h"
 
@@ -18,6 +21,46 @@ namespace IRun {
 		using View = CNtity::View<Components...>;
 
 		using SerializedEntity = std::vector<std::pair<std::string, std::string>>;
+
+		inline void AppendBinary(std::vector<uint8_t>& bytes, const void* data, size_t size) {
+			bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		}
+
+		inline void AppendBinaryString(std::vector<uint8_t>& bytes, const std::string& string) {
+			uint64_t length = string.size();
+			AppendBinary(bytes, &length, sizeof(length));
+			AppendBinary(bytes, string.data(), string.size());
+		}
+
+		/// <summary>
+		/// Bounds checked reads from a binary blob. Every read fails once one has failed.
+		/// </summary>
+		struct BinaryReader {
+			const uint8_t* data;
+			size_t size;
+			size_t offset = 0;
+
+			inline bool Read(void* destination, size_t readSize) {
+				if (readSize > size - offset) {
+					offset = size;
+					return false;
+				}
+
+				memcpy(destination, data + offset, readSize);
+				offset += readSize;
+				return true;
+			}
+
+			inline bool ReadString(std::string& string) {
+				uint64_t length = 0;
+				if (!Read(&length, sizeof(length)) || length > size - offset)
+					return false;
+
+				string.assign((const char*)data + offset, (size_t)length);
+				offset += (size_t)length;
+				return true;
+			}
+		};
 		
 		struct VertexData {
 			std::vector<Vertex> data;
@@ -46,13 +89,28 @@ namespace IRun {
 
 				std::copy(std::istream_iterator<float>(dataSS), std::istream_iterator<float>(), std::back_inserter(tempVec));
 
-				for (int i = 0; i < tempVec.size(); i += 3) {
+				for (int i = 0; i + 2 < tempVec.size(); i += 3) {
 					std::vector<float> vec3;
-					std::copy_n(tempVec.begin() + i, (i + 3), std::back_inserter(vec3));
+					std::copy_n(tempVec.begin() + i, 3, std::back_inserter(vec3));
 
 					data.push_back({ { vec3[0], vec3[1], vec3[2] } });
 				}
 			}
+
+			inline void WriteBinary(std::vector<uint8_t>& bytes) const {
+				AppendBinary(bytes, data.data(), data.size() * sizeof(Vertex));
+			}
+
+			inline bool ReadBinary(const uint8_t* bytes, size_t size) {
+				static_assert(std::is_trivially_copyable_v<Vertex>, "Vertices are stored as raw bytes.");
+
+				if (size % sizeof(Vertex) != 0)
+					return false;
+
+				data.resize(size / sizeof(Vertex));
+				memcpy(data.data(), bytes, size);
+				return true;
+			}
 		};
 
 		struct IndexData {
@@ -80,6 +138,19 @@ namespace IRun {
 
 				std::copy(std::istream_iterator<uint32_t>(dataSS), std::istream_iterator<uint32_t>(), std::back_inserter(data));
 			}
+
+			inline void WriteBinary(std::vector<uint8_t>& bytes) const {
+				AppendBinary(bytes, data.data(), data.size() * sizeof(uint32_t));
+			}
+
+			inline bool ReadBinary(const uint8_t* bytes, size_t size) {
+				if (size % sizeof(uint32_t) != 0)
+					return false;
+
+				data.resize(size / sizeof(uint32_t));
+				memcpy(data.data(), bytes, size);
+				return true;
+			}
 		};
 
 
@@ -101,6 +172,24 @@ namespace IRun {
 				language = StringToShaderLanguage(values);
 			}
 
+			inline void WriteBinary(std::vector<uint8_t>& bytes) const {
+				AppendBinaryString(bytes, vertexFilename);
+				AppendBinaryString(bytes, fragmentFilename);
+				uint32_t languageValue = (uint32_t)language;
+				AppendBinary(bytes, &languageValue, sizeof(languageValue));
+			}
+
+			inline bool ReadBinary(const uint8_t* bytes, size_t size) {
+				BinaryReader reader{ bytes, size };
+				uint32_t languageValue = 0;
+
+				if (!reader.ReadString(vertexFilename) || !reader.ReadString(fragmentFilename) || !reader.Read(&languageValue, sizeof(languageValue)))
+					return false;
+
+				language = (ShaderLanguage)languageValue;
+				return reader.offset == size;
+			}
+
 			inline bool operator==(const Shader& shader) const {
 				return (vertexFilename.compare(shader.vertexFilename) == 0) && (fragmentFilename.compare(shader.fragmentFilename) == 0) && language == shader.language;
 			}
@@ -121,6 +210,23 @@ namespace IRun {
 			glm::vec3 scale;
 			/// degrees
 			glm::vec3 rotation; 
+
+			/// <returns>Translation * rotation (z, y then x) * scale.</returns>
+			inline glm::mat4 GetModelMatrix() const {
+				glm::mat4 model = glm::translate(glm::mat4{ 1.0f }, position);
+				model = glm::rotate(model, glm::radians(rotation.z), { 0.0f, 0.0f, 1.0f });
+				model = glm::rotate(model, glm::radians(rotation.y), { 0.0f, 1.0f, 0.0f });
+				model = glm::rotate(model, glm::radians(rotation.x), { 1.0f, 0.0f, 0.0f });
+				return glm::scale(model, scale);
+			}
+		};
+
+		/// <summary>
+		/// Handle to a mesh created with IRun::Vk::Renderer::CreateMesh. Use instead of IRun::ECS::VertexData and IRun::ECS::IndexData
+		/// so entities can share a mesh. Entities with the same mesh and shader are drawn with one instanced draw call.
+		/// </summary>
+		struct Mesh {
+			uint32_t handle;
 		};
 
 		template<typename ...Components >
@@ -156,5 +262,253 @@ namespace IRun {
 			return entity;
 		}
 
+		static constexpr uint32_t BINARY_SCENE_MAGIC = 0x42535249; // "IRSB"
+		static constexpr uint32_t BINARY_SCENE_VERSION = 1;
+
+		/// <summary>
+		/// Start of a binary scene written by IRun::ECS::SerializeBinary. Followed by a column per component type, in the order of the
+		/// template arguments. A column is:
+		///     uint32_t componentSize: sizeof the component if it is trivially copyable, 0 if it writes itself with WriteBinary.
+		///     uint32_t componentCount: entities that have the component.
+		///     uint64_t blobSize
+		///     (entityCount + 7) / 8 bytes, padded to 8: bit i is set if entity i has the component.
+		///     blobSize bytes, padded to 8: the components in entity order. Trivially copyable components are an array that is copied
+		///     with one memcpy, others are each a uint64_t length followed by what their WriteBinary wrote.
+		/// Everything is in native byte order.
+		/// </summary>
+		struct BinarySceneHeader {
+			uint32_t magic = BINARY_SCENE_MAGIC;
+			uint32_t version = BINARY_SCENE_VERSION;
+			uint32_t entityCount = 0;
+			uint32_t componentTypeCount = 0;
+		};
+
+		/// <summary>
+		/// A column of a binary scene. Points into the bytes passed to IRun::ECS::ParseBinaryScene.
+		/// </summary>
+		struct BinaryColumn {
+			uint32_t componentSize;
+			uint32_t componentCount;
+			const uint8_t* presence;
+			const uint8_t* blob;
+			uint64_t blobSize;
+
+			inline bool Has(uint32_t entity) const { return presence[entity / 8] & (1 << (entity % 8)); }
+		};
+
+		struct BinaryScene {
+			uint32_t entityCount = 0;
+			std::vector<BinaryColumn> columns{};
+		};
+
+		inline size_t BinaryPadding(size_t size) {
+			return (8 - size % 8) % 8;
+		}
+
+		template<typename Component>
+		void WriteBinaryColumn(Helper& helper, const std::vector<Entity>& entities, std::vector<uint8_t>& bytes) {
+			size_t headerOffset = bytes.size();
+			size_t presenceSize = (entities.size() + 7) / 8;
+			bytes.resize(headerOffset + 16 + presenceSize + BinaryPadding(presenceSize), 0);
+
+			size_t blobOffset = bytes.size();
+			uint32_t componentCount = 0;
+
+			for (size_t i = 0; i < entities.size(); i++) {
+				if (!helper.has<Component>(entities[i]))
+					continue;
+
+				bytes[headerOffset + 16 + i / 8] |= (uint8_t)(1 << (i % 8));
+				componentCount++;
+
+				auto [component] = helper.get<Component>(entities[i]);
+
+				if constexpr (std::is_trivially_copyable_v<Component>) {
+					AppendBinary(bytes, &component, sizeof(Component));
+				}
+				else {
+					size_t lengthOffset = bytes.size();
+					bytes.resize(lengthOffset + sizeof(uint64_t));
+
+					component.WriteBinary(bytes);
+
+					uint64_t length = bytes.size() - lengthOffset - sizeof(uint64_t);
+					memcpy(bytes.data() + lengthOffset, &length, sizeof(length));
+				}
+			}
+
+			uint32_t componentSize = std::is_trivially_copyable_v<Component> ? (uint32_t)sizeof(Component) : 0;
+			uint64_t blobSize = bytes.size() - blobOffset;
+			bytes.resize(bytes.size() + BinaryPadding(bytes.size()), 0);
+
+			memcpy(bytes.data() + headerOffset, &componentSize, sizeof(componentSize));
+			memcpy(bytes.data() + headerOffset + 4, &componentCount, sizeof(componentCount));
+			memcpy(bytes.data() + headerOffset + 8, &blobSize, sizeof(blobSize));
+		}
+
+		/// <summary>
+		/// Serialize entities to the binary scene format, see IRun::ECS::BinarySceneHeader. Much faster to write and read than
+		/// IRun::ECS::Serialize, but it has to be read with the same components in the same order.
+		/// Components that aren't trivially copyable need WriteBinary and ReadBinary functions, see IRun::ECS::VertexData.
+		/// </summary>
+		/// <param name="entities">Entities to serialize, entity i of the scene is entities[i].</param>
+		/// <param name="bytes">The scene is appended to it, reserve it to avoid reallocating.</param>
+		template<typename ...Components>
+		void SerializeBinary(Helper& helper, const std::vector<Entity>& entities, std::vector<uint8_t>& bytes) {
+			BinarySceneHeader header{};
+			header.entityCount = (uint32_t)entities.size();
+			header.componentTypeCount = (uint32_t)sizeof...(Components);
+			AppendBinary(bytes, &header, sizeof(header));
+
+			(WriteBinaryColumn<Components>(helper, entities, bytes), ...);
+		}
+
+		/// <summary>
+		/// Read the header of a binary scene and check that its columns can fit in the data, before anything is sized from it.
+		/// </summary>
+		/// <returns>IRun::ErrorCode::Corrupt if the data isn't a binary scene of this version or is too small for its columns.</returns>
+		inline ErrorCode ReadBinarySceneHeader(const uint8_t* data, size_t size, BinarySceneHeader& header) {
+			BinaryReader reader{ data, size };
+
+			if (!reader.Read(&header, sizeof(header)) || header.magic != BINARY_SCENE_MAGIC || header.version != BINARY_SCENE_VERSION)
+				return ErrorCode::Corrupt;
+
+			// Every column starts with 16 bytes of sizes.
+			if ((uint64_t)header.componentTypeCount * 16 > size - reader.offset)
+				return ErrorCode::Corrupt;
+
+			return ErrorCode::Success;
+		}
+
+		/// <summary>
+		/// Parse the header and the columns of a binary scene without copying anything.
+		/// </summary>
+		/// <param name="data">The scene, must outlive scene.</param>
+		/// <returns>IRun::ErrorCode::Corrupt if the data isn't a binary scene of this version or is truncated.</returns>
+		inline ErrorCode ParseBinaryScene(const uint8_t* data, size_t size, BinaryScene& scene) {
+			BinarySceneHeader header{};
+			ErrorCode err = ReadBinarySceneHeader(data, size, header);
+
+			if (err != ErrorCode::Success)
+				return err;
+
+			BinaryReader reader{ data, size, sizeof(header) };
+
+			scene.entityCount = header.entityCount;
+			scene.columns.resize(header.componentTypeCount);
+
+			size_t presenceSize = ((size_t)header.entityCount + 7) / 8;
+
+			for (BinaryColumn& column : scene.columns) {
+				if (!reader.Read(&column.componentSize, 4) || !reader.Read(&column.componentCount, 4) || !reader.Read(&column.blobSize, 8))
+					return ErrorCode::Corrupt;
+
+				size_t paddedPresenceSize = presenceSize + BinaryPadding(presenceSize);
+				if (paddedPresenceSize > size - reader.offset)
+					return ErrorCode::Corrupt;
+
+				column.presence = data + reader.offset;
+				reader.offset += paddedPresenceSize;
+
+				if (column.blobSize > size - reader.offset)
+					return ErrorCode::Corrupt;
+
+				column.blob = data + reader.offset;
+				reader.offset += (size_t)column.blobSize;
+				reader.offset = std::min(reader.offset + BinaryPadding(reader.offset), size);
+			}
+
+			return ErrorCode::Success;
+		}
+
+		/// <summary>
+		/// Read a column straight into preallocated component storage. Trivially copyable components are copied with one memcpy.
+		/// </summary>
+		/// <param name="components">Resized to the number of components in the column, in entity order.</param>
+		/// <returns>IRun::ErrorCode::Corrupt if the column doesn't hold Component or is truncated.</returns>
+		template<typename Component>
+		ErrorCode ReadBinaryColumn(const BinaryColumn& column, std::vector<Component>& components) {
+			if constexpr (std::is_trivially_copyable_v<Component>) {
+				if (column.componentSize != sizeof(Component) || column.blobSize != (uint64_t)column.componentCount * sizeof(Component))
+					return ErrorCode::Corrupt;
+
+				components.resize(column.componentCount);
+				memcpy(components.data(), column.blob, (size_t)column.blobSize);
+			}
+			else {
+				// Every component has at least its length.
+				if (column.componentSize != 0 || column.componentCount > column.blobSize / sizeof(uint64_t))
+					return ErrorCode::Corrupt;
+
+				components.resize(column.componentCount);
+				BinaryReader reader{ column.blob, (size_t)column.blobSize };
+
+				for (Component& component : components) {
+					uint64_t length = 0;
+					if (!reader.Read(&length, sizeof(length)) || length > reader.size - reader.offset)
+						return ErrorCode::Corrupt;
+
+					if (!component.ReadBinary(reader.data + reader.offset, (size_t)length))
+						return ErrorCode::Corrupt;
+
+					reader.offset += (size_t)length;
+				}
+			}
+
+			return ErrorCode::Success;
+		}
+
+		template<typename Component>
+		ErrorCode AddBinaryColumn(Helper& helper, const BinaryColumn& column, const std::vector<Entity>& entities) {
+			std::vector<Component> components{};
+			ErrorCode err = ReadBinaryColumn<Component>(column, components);
+
+			if (err != ErrorCode::Success)
+				return err;
+
+			size_t next = 0;
+			for (uint32_t i = 0; i < (uint32_t)entities.size() && next < components.size(); i++) {
+				if (column.Has(i))
+					helper.add<Component>(entities[i], std::move(components[next++]));
+			}
+
+			return next == components.size() ? ErrorCode::Success : ErrorCode::Corrupt;
+		}
+
+		/// <summary>
+		/// Create the entities of a binary scene written by IRun::ECS::SerializeBinary with the same components.
+		/// </summary>
+		/// <param name="entities">The created entities are appended to it, entity i of the scene first.</param>
+		/// <returns>IRun::ErrorCode::Corrupt if the data isn't a scene of these components. Entities created before the error are kept.</returns>
+		template<typename ...Components>
+		ErrorCode DeserializeBinary(Helper& helper, const uint8_t* data, size_t size, std::vector<Entity>& entities) {
+			BinarySceneHeader header{};
+			ErrorCode err = ReadBinarySceneHeader(data, size, header);
+
+			if (err != ErrorCode::Success)
+				return err;
+
+			if (header.componentTypeCount != sizeof...(Components))
+				return ErrorCode::Corrupt;
+
+			BinaryScene scene{};
+			err = ParseBinaryScene(data, size, scene);
+
+			if (err != ErrorCode::Success)
+				return err;
+
+			std::vector<Entity> sceneEntities{};
+			sceneEntities.reserve(scene.entityCount);
+			for (uint32_t i = 0; i < scene.entityCount; i++)
+				sceneEntities.push_back(helper.create());
+
+			entities.insert(entities.end(), sceneEntities.begin(), sceneEntities.end());
+
+			size_t column = 0;
+			((err = err == ErrorCode::Success ? AddBinaryColumn<Components>(helper, scene.columns[column++], sceneEntities) : err), ...);
+
+			return err;
+		}
+
 	}
 }
\ No newline at end of file
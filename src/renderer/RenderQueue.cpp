@@ -0,0 +1,56 @@
+#include "RenderQueue.h"
+
+#include <ILog.h>
+
+#include <array>
+
+namespace IRun {
+	static constexpr uint32_t RADIX_BITS = 8;
+	static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+	static constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+	uint64_t RenderQueue::MakeKey(uint32_t pipeline, uint32_t descriptorSet, uint32_t buffer, uint32_t mesh, uint32_t index) {
+		I_ASSERT_FATAL_ERROR(pipeline >> PIPELINE_BITS, "IRun::RenderQueue::MakeKey failed. Param pipeline does not fit in the key!");
+		I_ASSERT_FATAL_ERROR(descriptorSet >> DESCRIPTOR_SET_BITS, "IRun::RenderQueue::MakeKey failed. Param descriptorSet does not fit in the key!");
+		I_ASSERT_FATAL_ERROR(buffer >> BUFFER_BITS, "IRun::RenderQueue::MakeKey failed. Param buffer does not fit in the key!");
+		I_ASSERT_FATAL_ERROR(mesh >> MESH_BITS, "IRun::RenderQueue::MakeKey failed. Param mesh does not fit in the key!");
+		I_ASSERT_FATAL_ERROR(index >> INDEX_BITS, "IRun::RenderQueue::MakeKey failed. Param index does not fit in the key!");
+
+		return ((uint64_t)pipeline << PIPELINE_SHIFT) | ((uint64_t)descriptorSet << DESCRIPTOR_SET_SHIFT) | ((uint64_t)buffer << BUFFER_SHIFT) | ((uint64_t)mesh << MESH_SHIFT) | ((uint64_t)index << INDEX_SHIFT);
+	}
+
+	void RenderQueue::Sort() {
+		if (m_keys.size() < 2)
+			return;
+
+		// Count every digit of every pass in one read of the keys.
+		std::array<std::array<uint32_t, RADIX_SIZE>, RADIX_PASSES> histograms{};
+		for (uint64_t key : m_keys)
+			for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+				histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+
+		m_scratch.resize(m_keys.size());
+
+		for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+			std::array<uint32_t, RADIX_SIZE>& histogram = histograms[pass];
+			uint32_t shift = pass * RADIX_BITS;
+
+			// Every key has the same digit, this pass wouldn't move anything.
+			if (histogram[(m_keys[0] >> shift) & (RADIX_SIZE - 1)] == (uint32_t)m_keys.size())
+				continue;
+
+			// Turn the counts into the first output position of each digit.
+			uint32_t offset = 0;
+			for (uint32_t& count : histogram) {
+				uint32_t digitCount = count;
+				count = offset;
+				offset += digitCount;
+			}
+
+			for (uint64_t key : m_keys)
+				m_scratch[histogram[(key >> shift) & (RADIX_SIZE - 1)]++] = key;
+
+			m_keys.swap(m_scratch);
+		}
+	}
+}
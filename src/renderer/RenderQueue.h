@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace IRun {
+	/// <summary>
+	/// Orders draws so that draws sharing the same state end up next to each other.
+	/// Every draw is one 64 bit key, from the most to the least significant bits: pipeline, descriptor set, buffer, mesh and the index of the draw.
+	/// Keys are radix sorted so the renderer only has to emit a state change when a field differs from the previous key,
+	/// and runs of keys with the same batch (every field but the index) can be drawn with one instanced draw.
+	/// </summary>
+	class RenderQueue {
+	public:
+		static constexpr uint32_t PIPELINE_BITS = 12;
+		static constexpr uint32_t DESCRIPTOR_SET_BITS = 6;
+		static constexpr uint32_t BUFFER_BITS = 6;
+		// Entities without an IRun::ECS::Mesh get a mesh each, so there can be about as many meshes as draws.
+		static constexpr uint32_t MESH_BITS = 20;
+		static constexpr uint32_t INDEX_BITS = 20;
+
+		static constexpr uint32_t INDEX_SHIFT = 0;
+		static constexpr uint32_t MESH_SHIFT = INDEX_SHIFT + INDEX_BITS;
+		static constexpr uint32_t BUFFER_SHIFT = MESH_SHIFT + MESH_BITS;
+		static constexpr uint32_t DESCRIPTOR_SET_SHIFT = BUFFER_SHIFT + BUFFER_BITS;
+		static constexpr uint32_t PIPELINE_SHIFT = DESCRIPTOR_SET_SHIFT + DESCRIPTOR_SET_BITS;
+
+		static_assert(PIPELINE_SHIFT + PIPELINE_BITS == 64, "IRun::RenderQueue key fields must add up to 64 bits.");
+
+		RenderQueue() = default;
+		/// <summary>
+		/// Build a sort key. Every field must fit in its number of bits.
+		/// </summary>
+		/// <param name="pipeline">Integer handle of the pipeline.</param>
+		/// <param name="descriptorSet">Integer handle of the descriptor set.</param>
+		/// <param name="buffer">Integer handle of the vertex and index buffers.</param>
+		/// <param name="mesh">Integer handle of the mesh.</param>
+		/// <param name="index">Index of the draw, used to find what to draw once the keys are sorted.</param>
+		/// <returns>The sort key.</returns>
+		static uint64_t MakeKey(uint32_t pipeline, uint32_t descriptorSet, uint32_t buffer, uint32_t mesh, uint32_t index);
+
+		static inline uint32_t GetPipeline(uint64_t key) { return GetField(key, PIPELINE_SHIFT, PIPELINE_BITS); }
+		static inline uint32_t GetDescriptorSet(uint64_t key) { return GetField(key, DESCRIPTOR_SET_SHIFT, DESCRIPTOR_SET_BITS); }
+		static inline uint32_t GetBuffer(uint64_t key) { return GetField(key, BUFFER_SHIFT, BUFFER_BITS); }
+		static inline uint32_t GetMesh(uint64_t key) { return GetField(key, MESH_SHIFT, MESH_BITS); }
+		static inline uint32_t GetIndex(uint64_t key) { return GetField(key, INDEX_SHIFT, INDEX_BITS); }
+		/// <returns>Every field but the index. Draws with the same batch can be instanced.</returns>
+		static inline uint64_t GetBatch(uint64_t key) { return key >> MESH_SHIFT; }
+
+		/// <summary>
+		/// Remove all keys. Keeps the memory so the queue can be refilled every frame without allocating.
+		/// </summary>
+		inline void Clear() { m_keys.clear(); }
+		/// <summary>
+		/// Add a key made with RenderQueue::MakeKey.
+		/// </summary>
+		inline void Push(uint64_t key) { m_keys.push_back(key); }
+		/// <summary>
+		/// Sort the keys in ascending order with an 8 bit least significant digit radix sort.
+		/// Passes where every key has the same digit are skipped.
+		/// </summary>
+		void Sort();
+		/// <returns>The keys, sorted if RenderQueue::Sort has been called since the last push.</returns>
+		inline const std::vector<uint64_t>& Get() const { return m_keys; }
+		inline size_t GetSize() const { return m_keys.size(); }
+	private:
+		std::vector<uint64_t> m_keys;
+		std::vector<uint64_t> m_scratch;
+
+		static inline uint32_t GetField(uint64_t key, uint32_t shift, uint32_t bits) {
+			return (uint32_t)((key >> shift) & ((1ull << bits) - 1));
+		}
+	};
+}
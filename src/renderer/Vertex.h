@@ -17,6 +17,13 @@ namespace IRun {
 	struct Mvp {
 		glm::mat4 proj;
 		glm::mat4 view;
-		glm::mat4 model;
+	};
+
+	/// <summary>
+	/// Per instance vertex data. Read from vertex binding 1 at location 2.
+	/// </summary>
+	struct InstanceData {
+		// Index of the model matrix in the transform storage buffer (descriptor set 0 binding 1).
+		uint32_t transformIndex;
 	};
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
-#include <IWindowWindow.h>
 #include "ICamera.h"
 
+#ifdef IRUN_WINDOWED
+#include <IWindowWindow.h>
+#endif
+
 namespace IRun {
 	class Camera3D : public ICamera {
 	public:
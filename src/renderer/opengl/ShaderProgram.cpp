@@ -1,6 +1,6 @@
 #include "ShaderProgram.h"
 
-#include "tools\dxc\HLSLCompiler.h"
+#include "tools/dxc/HLSLCompiler.h"
 
 
 namespace IRun {
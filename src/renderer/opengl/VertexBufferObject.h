@@ -1,7 +1,7 @@
 #pragma once
 
 #include <array>
-#include <glad\glad.h>
+#include <glad/glad.h>
 #include "../Vertex.h"
 
 namespace IRun {
@@ -0,0 +1,340 @@
+#include "Allocator.h"
+
+namespace IRun {
+	namespace Vk {
+		static inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		static inline VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment) {
+			return value & ~(alignment - 1);
+		}
+
+		static inline VkDeviceSize NextPowerOfTwo(VkDeviceSize value) {
+			VkDeviceSize powerOfTwo = 1;
+			while (powerOfTwo < value)
+				powerOfTwo <<= 1;
+			return powerOfTwo;
+		}
+
+		// Returns UINT32_MAX if the allocation is too big for a size class.
+		static uint32_t FindSizeClass(VkDeviceSize size, VkDeviceSize alignment) {
+			VkDeviceSize classSize = std::max({ NextPowerOfTwo(size), NextPowerOfTwo(alignment), Allocator::MIN_SIZE_CLASS });
+
+			uint32_t sizeClass = 0;
+			for (VkDeviceSize s = Allocator::MIN_SIZE_CLASS; s < classSize; s <<= 1)
+				sizeClass++;
+
+			return sizeClass < Allocator::SIZE_CLASS_COUNT ? sizeClass : UINT32_MAX;
+		}
+
+		static inline VkDeviceSize SizeClassToBytes(uint32_t sizeClass) {
+			return Allocator::MIN_SIZE_CLASS << sizeClass;
+		}
+
+		Allocator::Allocator(const Device& device, VkDeviceSize blockSize) :
+			m_mutex{ std::make_unique<std::mutex>() }
+		{
+			vkGetPhysicalDeviceMemoryProperties(device.Get().second, &m_memoryProperties);
+
+			m_nonCoherentAtomSize = std::max<VkDeviceSize>(device.GetDeviceProperties().limits.nonCoherentAtomSize, 1);
+			m_maxAllocationCount = device.GetDeviceProperties().limits.maxMemoryAllocationCount;
+
+			m_pools.resize(m_memoryProperties.memoryTypeCount);
+
+			for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+				// Small heaps (like the 256 MiB device local + host visible heap) would be used up by a few blocks.
+				VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[i].heapIndex].size;
+				m_pools[i].blockSize = std::max(std::min(blockSize, heapSize / 8), SizeClassToBytes(SIZE_CLASS_COUNT - 1) * 2);
+			}
+		}
+
+		Allocation Allocator::Allocate(const Device& device, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags propertyFlags) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			Allocation allocation{};
+			allocation.requestedSize = requirements.size;
+			allocation.memoryTypeIndex = FindMemoryTypeIndex(requirements.memoryTypeBits, propertyFlags);
+
+			I_ASSERT_FATAL_ERROR(allocation.memoryTypeIndex == UINT32_MAX, "Failed to find a suitable memory type index for allocation Vulkan device memory!");
+
+			MemoryPool& pool = m_pools[allocation.memoryTypeIndex];
+
+			VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+			uint32_t sizeClass = FindSizeClass(requirements.size, alignment);
+
+			if (sizeClass != UINT32_MAX) {
+				// Small allocation. Reuse a freed slot of the same size class if there is one.
+				allocation.sizeClass = sizeClass;
+				allocation.size = SizeClassToBytes(sizeClass);
+
+				std::vector<FreeSlot>& freeList = pool.sizeClassFreeLists[sizeClass];
+				if (!freeList.empty()) {
+					FreeSlot slot = freeList.back();
+					freeList.pop_back();
+
+					allocation.blockIndex = slot.blockIndex;
+					allocation.offset = slot.offset;
+					allocation.memory = pool.blocks[slot.blockIndex].memory;
+				}
+				// A power of two slot aligned to its own size satisfies any power of two alignment that is smaller than it.
+				else if (!AllocateFromBlocks(device, pool, allocation.memoryTypeIndex, allocation.size, allocation.size, allocation)) {
+					I_LOG_FATAL_ERROR("IRun::Vk::Allocator failed to allocate %llu bytes!", (unsigned long long)requirements.size);
+					exit(EXIT_FAILURE);
+				}
+			}
+			else if (requirements.size <= pool.blockSize / 2) {
+				// Medium allocation. Placed in the free ranges of the blocks.
+				allocation.size = AlignUp(requirements.size, alignment);
+
+				if (!AllocateFromBlocks(device, pool, allocation.memoryTypeIndex, allocation.size, alignment, allocation)) {
+					I_LOG_FATAL_ERROR("IRun::Vk::Allocator failed to allocate %llu bytes!", (unsigned long long)requirements.size);
+					exit(EXIT_FAILURE);
+				}
+			}
+			else {
+				// Large allocation. Gets its own VkDeviceMemory.
+				allocation.size = requirements.size;
+				allocation.offset = 0;
+				allocation.memory = AllocateDeviceMemory(device, allocation.size, allocation.memoryTypeIndex);
+
+				DedicatedMemory dedicatedMemory{};
+				dedicatedMemory.size = allocation.size;
+				pool.dedicated.insert({ allocation.memory, dedicatedMemory });
+			}
+
+			m_allocationCount++;
+			m_bytesInUse += allocation.requestedSize;
+
+			return allocation;
+		}
+
+		void Allocator::Free(const Device& device, const Allocation& allocation) {
+			if (allocation.memory == nullptr)
+				return;
+
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			MemoryPool& pool = m_pools[allocation.memoryTypeIndex];
+
+			if (allocation.IsDedicated()) {
+				I_DEBUG_LOG_TRACE("Freed Vulkan device memory: 0x%p", allocation.memory);
+				vkFreeMemory(device.Get().first, allocation.memory, nullptr);
+				pool.dedicated.erase(allocation.memory);
+				m_deviceMemoryCount--;
+			}
+			else if (allocation.sizeClass != UINT32_MAX) {
+				pool.sizeClassFreeLists[allocation.sizeClass].push_back({ allocation.blockIndex, allocation.offset });
+			}
+			else {
+				pool.blocks[allocation.blockIndex].ranges.Free(allocation.offset, allocation.size);
+			}
+
+			m_allocationCount--;
+			m_bytesInUse -= allocation.requestedSize;
+		}
+
+		void* Allocator::Map(const Device& device, const Allocation& allocation) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			MemoryPool& pool = m_pools[allocation.memoryTypeIndex];
+
+			if (allocation.IsDedicated()) {
+				DedicatedMemory& dedicatedMemory = pool.dedicated.at(allocation.memory);
+				// VkMemoryMapFlags is reserved should always be zero.
+				if (dedicatedMemory.mapCount == 0)
+					VK_CHECK(vkMapMemory(device.Get().first, allocation.memory, 0, VK_WHOLE_SIZE, 0, &dedicatedMemory.mapped), "Failed to map Vulkan device memory!");
+				dedicatedMemory.mapCount++;
+
+				return dedicatedMemory.mapped;
+			}
+
+			// A VkDeviceMemory can only be mapped once so the whole block is mapped and shared by all allocations in it.
+			Block& block = pool.blocks[allocation.blockIndex];
+			if (block.mapCount == 0)
+				VK_CHECK(vkMapMemory(device.Get().first, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped), "Failed to map Vulkan device memory!");
+			block.mapCount++;
+
+			return (uint8_t*)block.mapped + allocation.offset;
+		}
+
+		void Allocator::Unmap(const Device& device, const Allocation& allocation) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			MemoryPool& pool = m_pools[allocation.memoryTypeIndex];
+
+			if (allocation.IsDedicated()) {
+				DedicatedMemory& dedicatedMemory = pool.dedicated.at(allocation.memory);
+				if (--dedicatedMemory.mapCount == 0) {
+					vkUnmapMemory(device.Get().first, allocation.memory);
+					dedicatedMemory.mapped = nullptr;
+				}
+				return;
+			}
+
+			Block& block = pool.blocks[allocation.blockIndex];
+			if (--block.mapCount == 0) {
+				vkUnmapMemory(device.Get().first, block.memory);
+				block.mapped = nullptr;
+			}
+		}
+
+		void Allocator::Flush(const Device& device, const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+			if (IsHostCoherent(allocation))
+				return;
+
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			if (size == VK_WHOLE_SIZE)
+				size = allocation.size - offset;
+
+			VkDeviceSize memorySize = allocation.IsDedicated() ? allocation.size : m_pools[allocation.memoryTypeIndex].blocks[allocation.blockIndex].size;
+
+			// Flushed ranges must be multiples of VkPhysicalDeviceLimits::nonCoherentAtomSize relative to the start of the VkDeviceMemory.
+			VkMappedMemoryRange memoryRange{};
+			memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			memoryRange.memory = allocation.memory;
+			memoryRange.offset = AlignDown(allocation.offset + offset, m_nonCoherentAtomSize);
+
+			VkDeviceSize end = AlignUp(allocation.offset + offset + size, m_nonCoherentAtomSize);
+			memoryRange.size = end >= memorySize ? VK_WHOLE_SIZE : end - memoryRange.offset;
+
+			VK_CHECK(vkFlushMappedMemoryRanges(device.Get().first, 1, &memoryRange), "Failed to flush mapped memory range!");
+		}
+
+		bool Allocator::IsHostCoherent(const Allocation& allocation) const {
+			return m_memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		}
+
+		uint32_t Allocator::FindMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags propertyFlags) const {
+			for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+				// Black magic
+				// Index of memory type must match bit in allowedTypes
+				// Desired property flags must be available in physical memory property flags
+				if ((allowedTypes & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags) {
+					return i;
+				}
+			}
+
+			return UINT32_MAX;
+		}
+
+		AllocatorStats Allocator::GetStats() const {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			AllocatorStats stats{};
+			stats.allocationCount = m_allocationCount;
+			stats.bytesInUse = m_bytesInUse;
+
+			for (const MemoryPool& pool : m_pools) {
+				stats.blockCount += (uint32_t)pool.blocks.size();
+				stats.dedicatedAllocationCount += (uint32_t)pool.dedicated.size();
+
+				for (const Block& block : pool.blocks) {
+					stats.bytesReserved += block.size;
+
+					stats.bytesFree += block.ranges.GetSize() - block.ranges.GetUsed();
+					stats.largestFreeRange = std::max(stats.largestFreeRange, block.ranges.GetLargestFreeRange());
+				}
+
+				for (const std::pair<const VkDeviceMemory, DedicatedMemory>& dedicatedMemory : pool.dedicated)
+					stats.bytesReserved += dedicatedMemory.second.size;
+
+				for (uint32_t i = 0; i < SIZE_CLASS_COUNT; i++)
+					stats.bytesInSizeClassFreeLists += pool.sizeClassFreeLists[i].size() * SizeClassToBytes(i);
+			}
+
+			if (stats.bytesFree > 0)
+				stats.fragmentation = 1.0f - ((float)stats.largestFreeRange / (float)stats.bytesFree);
+
+			return stats;
+		}
+
+		void Allocator::LogStats() const {
+			AllocatorStats stats = GetStats();
+
+			I_LOG_INFO(
+				"IRun::Vk::Allocator: %u blocks, %u dedicated allocations, %u allocations, %llu bytes reserved, %llu bytes in use, %llu bytes in size class free lists, %llu bytes free in blocks (largest range: %llu bytes), fragmentation: %.2f",
+				stats.blockCount,
+				stats.dedicatedAllocationCount,
+				stats.allocationCount,
+				(unsigned long long)stats.bytesReserved,
+				(unsigned long long)stats.bytesInUse,
+				(unsigned long long)stats.bytesInSizeClassFreeLists,
+				(unsigned long long)stats.bytesFree,
+				(unsigned long long)stats.largestFreeRange,
+				stats.fragmentation
+			);
+		}
+
+		void Allocator::Destroy(const Device& device) {
+			if (m_allocationCount > 0)
+				I_LOG_WARNING("IRun::Vk::Allocator destroyed with %u allocations still alive!", m_allocationCount);
+
+			for (MemoryPool& pool : m_pools) {
+				for (Block& block : pool.blocks) {
+					I_DEBUG_LOG_TRACE("Freed Vulkan device memory: 0x%p", block.memory);
+					vkFreeMemory(device.Get().first, block.memory, nullptr);
+				}
+
+				for (std::pair<const VkDeviceMemory, DedicatedMemory>& dedicatedMemory : pool.dedicated) {
+					I_DEBUG_LOG_TRACE("Freed Vulkan device memory: 0x%p", dedicatedMemory.first);
+					vkFreeMemory(device.Get().first, dedicatedMemory.first, nullptr);
+				}
+			}
+
+			m_pools.clear();
+			m_deviceMemoryCount = 0;
+			m_allocationCount = 0;
+			m_bytesInUse = 0;
+		}
+
+		VkDeviceMemory Allocator::AllocateDeviceMemory(const Device& device, VkDeviceSize size, uint32_t memoryTypeIndex) {
+			if (m_deviceMemoryCount + 1 > m_maxAllocationCount)
+				I_LOG_WARNING("IRun::Vk::Allocator is about to exceed VkPhysicalDeviceLimits::maxMemoryAllocationCount (%u)!", m_maxAllocationCount);
+
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = size;
+			allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+			VkDeviceMemory memory = nullptr;
+			VK_CHECK(vkAllocateMemory(device.Get().first, &allocInfo, nullptr, &memory), "Failed to allocate Vulkan device memory");
+			I_DEBUG_LOG_TRACE("Allocated Vulkan device memory: 0x%p (%llu bytes, memory type: %u)", memory, (unsigned long long)size, memoryTypeIndex);
+
+			m_deviceMemoryCount++;
+
+			return memory;
+		}
+
+		bool Allocator::AllocateFromBlocks(const Device& device, MemoryPool& pool, uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation) {
+			for (uint32_t i = 0; i < (uint32_t)pool.blocks.size(); i++) {
+				VkDeviceSize offset = 0;
+				if (pool.blocks[i].ranges.Allocate(size, alignment, offset)) {
+					allocation.memory = pool.blocks[i].memory;
+					allocation.blockIndex = i;
+					allocation.offset = offset;
+					return true;
+				}
+			}
+
+			// No space left in any block, create a new one.
+			Block block{};
+			block.size = pool.blockSize;
+			block.memory = AllocateDeviceMemory(device, block.size, memoryTypeIndex);
+			block.ranges = RangeAllocator{ block.size };
+
+			pool.blocks.push_back(block);
+
+			VkDeviceSize offset = 0;
+			if (!pool.blocks.back().ranges.Allocate(size, alignment, offset))
+				return false;
+
+			allocation.memory = pool.blocks.back().memory;
+			allocation.blockIndex = (uint32_t)pool.blocks.size() - 1;
+			allocation.offset = offset;
+
+			return true;
+		}
+	}
+}
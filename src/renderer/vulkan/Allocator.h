@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "Device.h"
+#include "RangeAllocator.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// A range of VkDeviceMemory handed out by IRun::Vk::Allocator.
+		/// </summary>
+		struct Allocation {
+			VkDeviceMemory memory = nullptr;
+			// Offset of this allocation inside of Allocation::memory. Pass into vkBindBufferMemory.
+			VkDeviceSize offset = 0;
+			// Size of the allocation in bytes. May be larger than the requested size.
+			VkDeviceSize size = 0;
+			// Size that was requested by VkMemoryRequirements::size.
+			VkDeviceSize requestedSize = 0;
+			uint32_t memoryTypeIndex = UINT32_MAX;
+			// Index of the block in the memory pool or UINT32_MAX if the allocation is dedicated.
+			uint32_t blockIndex = UINT32_MAX;
+			// Index of the size class the allocation came from or UINT32_MAX if it was not a small allocation.
+			uint32_t sizeClass = UINT32_MAX;
+
+			inline bool IsDedicated() const { return blockIndex == UINT32_MAX; }
+		};
+
+		/// <summary>
+		/// Memory usage of an IRun::Vk::Allocator.
+		/// </summary>
+		struct AllocatorStats {
+			// Number of VkDeviceMemory blocks that are sub-allocated from.
+			uint32_t blockCount = 0;
+			// Number of allocations that got their own VkDeviceMemory.
+			uint32_t dedicatedAllocationCount = 0;
+			// Number of live allocations (sub-allocated and dedicated).
+			uint32_t allocationCount = 0;
+			// Bytes allocated from the driver with vkAllocateMemory.
+			VkDeviceSize bytesReserved = 0;
+			// Bytes requested by live allocations.
+			VkDeviceSize bytesInUse = 0;
+			// Bytes sitting in size class free lists waiting to be reused.
+			VkDeviceSize bytesInSizeClassFreeLists = 0;
+			// Bytes in the free ranges of all blocks.
+			VkDeviceSize bytesFree = 0;
+			// Size of the largest free range in any block.
+			VkDeviceSize largestFreeRange = 0;
+			// 0.0 when all free memory in the blocks is one range, approaching 1.0 as the free memory is split into smaller ranges.
+			float fragmentation = 0.0f;
+		};
+
+		/// <summary>
+		/// Sub-allocates VkDeviceMemory so that buffers do not each need their own vkAllocateMemory call.
+		/// Each memory type gets a pool of large blocks. Small allocations are rounded up to a power of two size class and recycled through free lists,
+		/// medium allocations are placed in the free ranges of the blocks and large allocations get a dedicated VkDeviceMemory.
+		/// </summary>
+		class Allocator {
+		public:
+			/// <summary>
+			/// Smallest size class in bytes.
+			/// </summary>
+			static constexpr VkDeviceSize MIN_SIZE_CLASS = 256;
+			/// <summary>
+			/// Number of size classes. The largest size class is MIN_SIZE_CLASS << (SIZE_CLASS_COUNT - 1) (256 KiB).
+			/// </summary>
+			static constexpr uint32_t SIZE_CLASS_COUNT = 11;
+			/// <summary>
+			/// Default size of a block of VkDeviceMemory.
+			/// </summary>
+			static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024ull * 1024ull;
+
+			Allocator() = default;
+			/// <summary>
+			/// Init allocator.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="blockSize">Preferred size of the blocks that will be sub-allocated from. Will be lowered for small memory heaps.</param>
+			Allocator(const Device& device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+			/// <summary>
+			/// Allocate memory. Will exit the application if the memory could not be allocated.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="requirements">Requirements retrieved from vkGetBufferMemoryRequirements or vkGetImageMemoryRequirements.</param>
+			/// <param name="propertyFlags">Properties of the memory. Must be a valid VkMemoryPropertyFlags.</param>
+			/// <returns>The allocation.</returns>
+			Allocation Allocate(const Device& device, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags propertyFlags);
+			/// <summary>
+			/// Return an allocation to the allocator. The memory must not be in use by the Gpu.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocation">An allocation returned by Allocator::Allocate.</param>
+			void Free(const Device& device, const Allocation& allocation);
+			/// <summary>
+			/// Map a host visible allocation. Blocks are mapped once and reference counted so that allocations sharing a block can be mapped at the same time.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocation">A host visible allocation.</param>
+			/// <returns>Pointer to the start of the allocation.</returns>
+			void* Map(const Device& device, const Allocation& allocation);
+			/// <summary>
+			/// Unmap an allocation mapped with Allocator::Map.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocation">A mapped allocation.</param>
+			void Unmap(const Device& device, const Allocation& allocation);
+			/// <summary>
+			/// Flush a range of an allocation so the Gpu can see host writes. Does nothing if the memory is host coherent.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocation">A mapped allocation.</param>
+			/// <param name="offset">Offset in bytes from the start of the allocation.</param>
+			/// <param name="size">Size in bytes of the range to flush or VK_WHOLE_SIZE.</param>
+			void Flush(const Device& device, const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+			/// <returns>True if the allocation does not need to be flushed after writing to it.</returns>
+			bool IsHostCoherent(const Allocation& allocation) const;
+			/// <summary>
+			/// Find a memory type that is allowed by allowedTypes and has all of propertyFlags.
+			/// </summary>
+			/// <returns>Index of the memory type or UINT32_MAX if there is none.</returns>
+			uint32_t FindMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags propertyFlags) const;
+			/// <returns>Current memory usage of the allocator.</returns>
+			AllocatorStats GetStats() const;
+			/// <summary>
+			/// Log the current memory usage with ILog.
+			/// </summary>
+			void LogStats() const;
+			/// <summary>
+			/// Free all VkDeviceMemory owned by the allocator. All allocations must be freed and the device must be idle.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			void Destroy(const Device& device);
+		private:
+			struct Block {
+				VkDeviceMemory memory = nullptr;
+				VkDeviceSize size = 0;
+				RangeAllocator ranges;
+				void* mapped = nullptr;
+				uint32_t mapCount = 0;
+			};
+
+			struct DedicatedMemory {
+				VkDeviceSize size = 0;
+				void* mapped = nullptr;
+				uint32_t mapCount = 0;
+			};
+
+			struct FreeSlot {
+				uint32_t blockIndex;
+				VkDeviceSize offset;
+			};
+
+			struct MemoryPool {
+				VkDeviceSize blockSize = 0;
+				std::vector<Block> blocks;
+				std::array<std::vector<FreeSlot>, SIZE_CLASS_COUNT> sizeClassFreeLists;
+				std::unordered_map<VkDeviceMemory, DedicatedMemory> dedicated;
+			};
+
+			VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+			VkDeviceSize m_nonCoherentAtomSize = 1;
+			uint32_t m_maxAllocationCount = 0;
+
+			std::vector<MemoryPool> m_pools;
+
+			uint32_t m_deviceMemoryCount = 0;
+			uint32_t m_allocationCount = 0;
+			VkDeviceSize m_bytesInUse = 0;
+
+			// Heap allocated so the allocator (and the renderer owning it) can still be moved.
+			std::unique_ptr<std::mutex> m_mutex;
+
+			VkDeviceMemory AllocateDeviceMemory(const Device& device, VkDeviceSize size, uint32_t memoryTypeIndex);
+			bool AllocateFromBlocks(const Device& device, MemoryPool& pool, uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation);
+		};
+	}
+}
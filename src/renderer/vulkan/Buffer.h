@@ -1,9 +1,12 @@
 #pragma once
 
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
+
+#include <array>
 
 #include "../Vertex.h"
 #include "Device.h"
+#include "Allocator.h"
 #include "tools/Flags.h"
 
 namespace IRun {
@@ -17,6 +20,11 @@ namespace IRun {
 			/// Do not map the host visible data to the gpu.
 			/// </summary>
 			NoMap = 0x1,
+			/// <summary>
+			/// Map the host visible memory once when the buffer is created and keep it mapped until it is destroyed.
+			/// Writes only memcpy into the mapping and flush the written range if the memory is not host coherent.
+			/// </summary>
+			PersistentMap = 0x2,
 			Max
 		};
 		CREATE_FLAGS_FROM_ENUM_STRUCT(BufferFlags, BufferFlags::Max);
@@ -34,14 +42,19 @@ namespace IRun {
 			/// Init buffer.
 			/// </summary>
 			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator. The memory of the buffer is sub-allocated from it.</param>
 			/// <param name="data">Data that is to be stored.</param>
 			/// <param name="dataSize">Size of data to be stored.</param>
 			/// <param name="usageFlags">Usage of the buffer. Must be a valid VkBufferUsageFlags.</param>
-			/// <param name="sharingMode">Allow sharing between queue families. Must be a valid VkSharingMode.</param>
+			/// <param name="sharingMode">
+			/// Allow sharing between queue families. Must be a valid VkSharingMode. VK_SHARING_MODE_CONCURRENT shares the buffer between the
+			/// graphics and the transfer queue family, so buffers written by IRun::Vk::UploadManager need no queue family ownership transfer.
+			/// It is the same as VK_SHARING_MODE_EXCLUSIVE if both are one family.
+			/// </param>
 			/// <param name="propertyFlags">Properties of the buffers. Must be a valid VkMemoryPropertyFlags.</param>
-			Buffer(Device& device, DataType* data, size_t dataSize, VkBufferUsageFlags usageFlags, VkSharingMode sharingMode, VkMemoryPropertyFlags propertyFlags, BufferFlags flags = BufferFlags::None) :
-				m_size{ dataSize },
-				m_hostCoherent{ false }
+			/// <param name="flags">IRun specific flags. PersistentMap requires propertyFlags to contain VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT.</param>
+			Buffer(Device& device, Allocator& allocator, DataType* data, size_t dataSize, VkBufferUsageFlags usageFlags, VkSharingMode sharingMode, VkMemoryPropertyFlags propertyFlags, BufferFlags flags = BufferFlags::None) :
+				m_size{ dataSize }
 			{
 				VkBufferCreateInfo createInfo{};
 				createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -50,105 +63,102 @@ namespace IRun {
 				createInfo.usage = usageFlags;
 				createInfo.sharingMode = sharingMode;
 
+				const QueueFamilyIndices& indices = device.GetQueueFamilies();
+				std::array<uint32_t, 2> queueFamilies = { (uint32_t)indices.graphicsFamily, (uint32_t)indices.transferFamily };
+
+				if (sharingMode == VK_SHARING_MODE_CONCURRENT) {
+					// Concurrent sharing needs at least two distinct families.
+					if (queueFamilies[0] == queueFamilies[1]) {
+						createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+					}
+					else {
+						createInfo.queueFamilyIndexCount = (uint32_t)queueFamilies.size();
+						createInfo.pQueueFamilyIndices = queueFamilies.data();
+					}
+				}
+
 				VK_CHECK(vkCreateBuffer(device.Get().first, &createInfo, nullptr, &m_buffer), "Failed to create Vulkan buffer!");
 
 				VkMemoryRequirements memoryRequirments{};
 				vkGetBufferMemoryRequirements(device.Get().first, m_buffer, &memoryRequirments);
 
-				VkMemoryAllocateInfo allocInfo{};
-				allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-				allocInfo.allocationSize = memoryRequirments.size;
-				allocInfo.memoryTypeIndex = FindMemoryTypeIndex(device, memoryRequirments.memoryTypeBits, propertyFlags);
-
-				I_ASSERT_FATAL_ERROR(allocInfo.memoryTypeIndex == UINT32_MAX, "Failed to find a suitable memory type index for allocation Vulkan device memory!");
-
-				VK_CHECK(vkAllocateMemory(device.Get().first, &allocInfo, nullptr, &m_memory), "Failed to allocate Vulkan device memory");
+				m_allocation = allocator.Allocate(device, memoryRequirments, propertyFlags);
 
-				// memoryOffset is for memory pools. I should add that.
-				vkBindBufferMemory(device.Get().first, m_buffer, m_memory, 0);
+				vkBindBufferMemory(device.Get().first, m_buffer, m_allocation.memory, m_allocation.offset);
 
-				if (!(int64_t)(flags & BufferFlags::NoMap)) {
-					void* mappedData;
-					// VkMemoryMapFlags is reserved should always be zero.
-					vkMapMemory(device.Get().first, m_memory, 0, createInfo.size, 0, &mappedData);
-					memcpy(mappedData, data, (size_t)createInfo.size);
-
-					if (!(propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-						m_hostCoherent = true;
-
-						VkMappedMemoryRange memoryRange{};
-						memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-						memoryRange.offset = 0;
-						memoryRange.size = VK_WHOLE_SIZE;
-						memoryRange.memory = m_memory;
-
-						VK_CHECK(vkFlushMappedMemoryRanges(device.Get().first, 1, &memoryRange), "Failed to flush mapped memory range!");
-						VK_CHECK(vkInvalidateMappedMemoryRanges(device.Get().first, 1, &memoryRange), "Failed to flush mapped memory range!");
-					}
-
-
-					vkUnmapMemory(device.Get().first, m_memory);
+				if ((int64_t)(flags & BufferFlags::PersistentMap)) {
+					I_DEBUG_ASSERT_FATAL_ERROR(!(propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT), "IRun::Vk::BufferFlags::PersistentMap requires host visible memory!");
+					m_mapped = (DataType*)allocator.Map(device, m_allocation);
 				}
-			}
-
-			inline void SetBufferData(const Device& device, DataType* data) {
-				void* mappedData;
-				// VkMemoryMapFlags is reserved should always be zero.
-				vkMapMemory(device.Get().first, m_memory, 0, (uint32_t)sizeof(DataType) * m_size, 0, &mappedData);
-				memcpy(mappedData, data, (size_t)sizeof(DataType) * m_size);
 
-				if (m_hostCoherent) {
-					VkMappedMemoryRange memoryRange{};
-					memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-					memoryRange.offset = 0;
-					memoryRange.size = VK_WHOLE_SIZE;
-					memoryRange.memory = m_memory;
+				if (!(int64_t)(flags & BufferFlags::NoMap) && (!m_mapped || data))
+					SetBufferData(device, allocator, data);
+			}
 
-					VK_CHECK(vkFlushMappedMemoryRanges(device.Get().first, 1, &memoryRange), "Failed to flush mapped memory range!");
-					VK_CHECK(vkInvalidateMappedMemoryRanges(device.Get().first, 1, &memoryRange), "Failed to flush mapped memory range!");
+			/// <summary>
+			/// Overwrite the whole buffer. The memory must be host visible.
+			/// </summary>
+			inline void SetBufferData(const Device& device, Allocator& allocator, const DataType* data) {
+				if (m_mapped) {
+					Write(device, allocator, data, 0, m_size);
+					return;
 				}
 
-				vkUnmapMemory(device.Get().first, m_memory);
+				void* mappedData = allocator.Map(device, m_allocation);
+				memcpy(mappedData, data, (size_t)sizeof(DataType) * m_size);
+				allocator.Flush(device, m_allocation, 0, (VkDeviceSize)sizeof(DataType) * m_size);
+				allocator.Unmap(device, m_allocation);
+			}
+			/// <summary>
+			/// Copy count elements into a buffer created with BufferFlags::PersistentMap and flush only that range.
+			/// </summary>
+			/// <param name="offset">Offset in elements.</param>
+			/// <param name="count">Number of elements.</param>
+			inline void Write(const Device& device, Allocator& allocator, const DataType* data, size_t offset, size_t count) {
+				I_DEBUG_ASSERT_FATAL_ERROR(!m_mapped, "IRun::Vk::Buffer::Write requires a buffer created with IRun::Vk::BufferFlags::PersistentMap!");
+				memcpy(m_mapped + offset, data, sizeof(DataType) * count);
+				Flush(device, allocator, offset, count);
+			}
+			/// <summary>
+			/// Make host writes to a range of a persistently mapped buffer visible to the Gpu. Does nothing if the memory is host coherent.
+			/// </summary>
+			/// <param name="offset">Offset in elements.</param>
+			/// <param name="count">Number of elements.</param>
+			inline void Flush(const Device& device, Allocator& allocator, size_t offset, size_t count) {
+				if (count > 0)
+					allocator.Flush(device, m_allocation, (VkDeviceSize)sizeof(DataType) * offset, (VkDeviceSize)sizeof(DataType) * count);
 			}
 
 			/// <summary>
-			/// Destroy the VkBuffer and free the VkDeviceMemory.
+			/// Destroy the VkBuffer and give its memory back to the allocator.
 			/// </summary>
 			/// <param name="device">A valid IRun::Vk::Device.</param>
-			inline void Destroy(Device& device) {
-				vkFreeMemory(device.Get().first, m_memory, nullptr);
+			/// <param name="allocator">The IRun::Vk::Allocator the buffer was created with.</param>
+			inline void Destroy(Device& device, Allocator& allocator) {
+				if (m_mapped) {
+					allocator.Unmap(device, m_allocation);
+					m_mapped = nullptr;
+				}
+
 				vkDestroyBuffer(device.Get().first, m_buffer, nullptr);
+				allocator.Free(device, m_allocation);
 			}
 			/// <returns>Size of the buffer.</returns>
 			const inline size_t GetSize() const { return m_size; }
 			/// <returns>Handle to the VkBuffer</returns>
 			const inline VkBuffer Get() const { return m_buffer; }
 			/// <returns>Handle to the VkDeviceMemory</returns>
-			const inline VkDeviceMemory GetMemory() const { return m_memory; }
+			const inline VkDeviceMemory GetMemory() const { return m_allocation.memory; }
+			/// <returns>The range of VkDeviceMemory the buffer is bound to.</returns>
+			const inline Allocation& GetAllocation() const { return m_allocation; }
+			/// <returns>Pointer to the mapped memory if the buffer was created with BufferFlags::PersistentMap, otherwise nullptr.</returns>
+			inline DataType* GetMapped() const { return m_mapped; }
 
 		private:
 			VkBuffer m_buffer;
-			VkDeviceMemory m_memory;
+			Allocation m_allocation;
 			size_t m_size;
-
-			bool m_hostCoherent;
-
-			inline uint32_t FindMemoryTypeIndex(Device& device, uint32_t allowedTypes, VkMemoryPropertyFlags propertyFlags) {
-				// Props of the physical device memory
-				VkPhysicalDeviceMemoryProperties memoryProperties{};
-				vkGetPhysicalDeviceMemoryProperties(device.Get().second, &memoryProperties);
-
-				for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
-					// Black magic
-					// Index of memory type must match bit in allowedTypes
-					// Desired property flags must be available in physical memory property flags
-					if ((allowedTypes & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags) {
-						return i;
-					}
-				}
-
-				return UINT32_MAX;
-			}
+			DataType* m_mapped = nullptr;
 		};
 	}
 }
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Device.h"
+#include "Buffer.h"
+#include "UploadManager.h"
+#include "DeletionQueue.h"
+#include "RangeAllocator.h"
+
+#include <ILog.h>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// One large device local buffer that many meshes are placed in, so they can be drawn without rebinding buffers.
+		/// Ranges are handed out in elements of DataType, freed ranges are reused and the buffer grows by creating a bigger buffer
+		/// and copying the old one into it on the transfer queue.
+		/// </summary>
+		/// <typeparam name="DataType">Type of data to be stored.</typeparam>
+		template<typename DataType>
+		class BufferArena {
+		public:
+			/// <summary>
+			/// Default number of elements the arena can hold before it has to grow.
+			/// </summary>
+			static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+			BufferArena() = default;
+			/// <summary>
+			/// Init arena.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator.</param>
+			/// <param name="usageFlags">Usage of the buffer. Must be a valid VkBufferUsageFlags.</param>
+			/// <param name="capacity">Number of elements the arena can hold before it has to grow.</param>
+			BufferArena(Device& device, Allocator& allocator, VkBufferUsageFlags usageFlags, size_t capacity = DEFAULT_CAPACITY) :
+				m_usageFlags{ usageFlags },
+				m_ranges{ capacity }
+			{
+				m_buffer = CreateBuffer(device, allocator, capacity);
+			}
+			/// <summary>
+			/// Place data in the arena and enqueue its upload. Grows the arena if there is no free range big enough.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">The IRun::Vk::Allocator the arena was created with.</param>
+			/// <param name="uploadManager">A valid IRun::Vk::UploadManager.</param>
+			/// <param name="deletionQueue">If the arena grows the old buffer is destroyed through this queue.</param>
+			/// <param name="frame">Number of the next frame to be submitted. The old buffer is kept alive until it has finished.</param>
+			/// <param name="data">Data to be uploaded. Can be freed once this function returns.</param>
+			/// <param name="count">Number of elements in data.</param>
+			/// <returns>Offset in elements of the data in the arena.</returns>
+			size_t Allocate(Device& device, Allocator& allocator, UploadManager& uploadManager, DeletionQueue& deletionQueue, uint64_t frame, const DataType* data, size_t count) {
+				uint64_t offset = 0;
+
+				if (count == 0)
+					return 0;
+
+				if (!m_ranges.Allocate(count, 1, offset)) {
+					Grow(device, allocator, uploadManager, deletionQueue, frame, (size_t)std::max<uint64_t>(m_ranges.GetSize() * 2, m_ranges.GetSize() + count));
+
+					bool allocated = m_ranges.Allocate(count, 1, offset);
+					I_ASSERT_FATAL_ERROR(!allocated, "Failed to allocate from IRun::Vk::BufferArena after growing it!");
+				}
+
+				uploadManager.Enqueue(device, m_buffer.Get(), offset * sizeof(DataType), data, count * sizeof(DataType));
+
+				return (size_t)offset;
+			}
+			/// <summary>
+			/// Give back a range returned by BufferArena::Allocate. The range must not be in use by the Gpu.
+			/// </summary>
+			/// <param name="offset">Offset in elements.</param>
+			/// <param name="count">Number of elements.</param>
+			inline void Free(size_t offset, size_t count) {
+				if (count > 0)
+					m_ranges.Free(offset, count);
+			}
+			/// <summary>
+			/// Destroy the buffer of the arena.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">The IRun::Vk::Allocator the arena was created with.</param>
+			inline void Destroy(Device& device, Allocator& allocator) {
+				m_buffer.Destroy(device, allocator);
+			}
+			/// <returns>The buffer of the arena. Changes when the arena grows.</returns>
+			const inline Buffer<DataType>& Get() const { return m_buffer; }
+			/// <returns>Number of elements the arena can hold.</returns>
+			const inline size_t GetCapacity() const { return (size_t)m_ranges.GetSize(); }
+			/// <returns>Number of elements in use.</returns>
+			const inline size_t GetUsed() const { return (size_t)m_ranges.GetUsed(); }
+		private:
+			Buffer<DataType> m_buffer;
+			VkBufferUsageFlags m_usageFlags = 0;
+			RangeAllocator m_ranges;
+
+			inline Buffer<DataType> CreateBuffer(Device& device, Allocator& allocator, size_t capacity) {
+				// Transfer source so the arena can be copied into a bigger buffer when it grows. Filled on the transfer queue and
+				// read on the graphics queue, concurrent so no ownership transfer is needed.
+				return Buffer<DataType>{ device, allocator, nullptr, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | m_usageFlags, VK_SHARING_MODE_CONCURRENT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, BufferFlags::NoMap };
+			}
+
+			void Grow(Device& device, Allocator& allocator, UploadManager& uploadManager, DeletionQueue& deletionQueue, uint64_t frame, size_t capacity) {
+				I_LOG_INFO("Growing IRun::Vk::BufferArena from %zu to %zu elements.", (size_t)m_ranges.GetSize(), capacity);
+
+				Buffer<DataType> oldBuffer = m_buffer;
+				m_buffer = CreateBuffer(device, allocator, capacity);
+
+				// Only copy up to the end of the last allocated range.
+				uint64_t usedEnd = m_ranges.GetSize();
+				const std::map<uint64_t, uint64_t>& freeRanges = m_ranges.GetFreeRanges();
+				if (!freeRanges.empty() && freeRanges.rbegin()->first + freeRanges.rbegin()->second == usedEnd)
+					usedEnd = freeRanges.rbegin()->first;
+
+				if (usedEnd > 0)
+					uploadManager.EnqueueCopy(device, oldBuffer.Get(), 0, m_buffer.Get(), 0, usedEnd * sizeof(DataType));
+
+				m_ranges.Grow(capacity);
+
+				// Frames before frame still read the old buffer and the copy is waited on by frame.
+				deletionQueue.Push(frame, [oldBuffer](Device& device, Allocator& allocator) mutable {
+					oldBuffer.Destroy(device, allocator);
+				});
+			}
+		};
+	}
+}
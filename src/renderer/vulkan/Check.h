@@ -1,7 +1,7 @@
 #pragma once
 
-#include <vulkan\vulkan.h>
-#include <vulkan\vk_enum_string_helper.h>
+#include <vulkan/vulkan.h>
+#include <vulkan/vk_enum_string_helper.h>
 #include <ILog.h>
 
 
@@ -64,5 +64,9 @@ namespace IRun {
 			// Breaks everything
 			// m_commandBuffers.erase(commandBuffer);
 		}
+
+		void CommandPool::Reset(const Device& device, VkCommandPoolResetFlags flags) {
+			VK_CHECK(vkResetCommandPool(device.Get().first, m_commandPool, flags), "Failed to reset Vulkan command pool");
+		}
 	}
 }
\ No newline at end of file
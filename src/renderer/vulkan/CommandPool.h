@@ -59,6 +59,12 @@ namespace IRun {
 			/// </summary>
 			/// <param name="commandBuffer">Command buffer to be destroyed.</param>
 			void DestroyCommandBuffer(Device& device, CommandBuffer commandBuffer);
+			/// <summary>
+			/// Reset every command buffer in the pool to the initial state. None of them may be pending execution.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="flags">Flags for vkResetCommandPool. Must be a valid VkCommandPoolResetFlags.</param>
+			void Reset(const Device& device, VkCommandPoolResetFlags flags = 0);
 			inline VkCommandBuffer operator[](CommandBuffer commandBuffer) { return m_commandBuffers.at(commandBuffer); }
 			/// <summary>
 			/// Get the VkCommandBufferHandle.
@@ -0,0 +1,23 @@
+#include "DeletionQueue.h"
+
+namespace IRun {
+	namespace Vk {
+		void DeletionQueue::Push(uint64_t frame, DeleteFunction function) {
+			m_entries.push_back({ frame, std::move(function) });
+		}
+
+		void DeletionQueue::Flush(Device& device, Allocator& allocator, uint64_t completedFrame) {
+			while (!m_entries.empty() && m_entries.front().frame <= completedFrame) {
+				m_entries.front().function(device, allocator);
+				m_entries.pop_front();
+			}
+		}
+
+		void DeletionQueue::Destroy(Device& device, Allocator& allocator) {
+			for (Entry& entry : m_entries)
+				entry.function(device, allocator);
+
+			m_entries.clear();
+		}
+	}
+}
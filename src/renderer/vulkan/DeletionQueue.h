@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Device.h"
+#include "Allocator.h"
+
+#include <deque>
+#include <functional>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Defers destroying Vulkan objects until the Gpu is done with every frame that could still be using them.
+		/// </summary>
+		class DeletionQueue {
+		public:
+			using DeleteFunction = std::function<void(Device&, Allocator&)>;
+
+			DeletionQueue() = default;
+			/// <summary>
+			/// Queue a function to be called once frame has finished on the Gpu.
+			/// Capture objects by value, the function is called with the device and allocator it has to destroy them with.
+			/// </summary>
+			/// <param name="frame">Number of the last frame that may use the object.</param>
+			/// <param name="function">Function that destroys the object.</param>
+			void Push(uint64_t frame, DeleteFunction function);
+			/// <summary>
+			/// Call the functions of every frame up to and including completedFrame.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator.</param>
+			/// <param name="completedFrame">Number of the last frame that has finished on the Gpu.</param>
+			void Flush(Device& device, Allocator& allocator, uint64_t completedFrame);
+			/// <summary>
+			/// Call every queued function. The device must be idle.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator.</param>
+			void Destroy(Device& device, Allocator& allocator);
+		private:
+			struct Entry {
+				uint64_t frame;
+				DeleteFunction function;
+			};
+
+			// Sorted by frame since frames only ever increase.
+			std::deque<Entry> m_entries;
+		};
+	}
+}
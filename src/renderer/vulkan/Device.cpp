@@ -1,6 +1,6 @@
 #include "Device.h"
 
-#include "tools\Timer.h"
+#include "tools/Timer.h"
 
 namespace IRun {
 	namespace Vk {
@@ -31,7 +31,9 @@ namespace IRun {
 			return strQueueType;
 		}
 
-		Device::Device(const Instance& instance, const Surface& surface) {
+		Device::Device(const Instance& instance, const Surface& surface) :
+			m_headless{ surface.Get() == VK_NULL_HANDLE }
+		{
 			GetPhysicalDevice(instance, surface);
 			CreateDevice(instance);
 		}
@@ -73,7 +75,8 @@ namespace IRun {
 			I_LOG_INFO("Device Name: %s, Device Type: %s", m_deviceProperties.deviceName, string_VkPhysicalDeviceType(m_deviceProperties.deviceType));
 
 			m_indices = FindQueueFamilies(m_physicalDevice, surface);
-			m_swapchainDetails = FindSwapchainDetails(m_physicalDevice, surface);
+			if (!m_headless)
+				m_swapchainDetails = FindSwapchainDetails(m_physicalDevice, surface);
 		}
 
 		void Device::CreateDevice(const Instance& instance) {
@@ -167,12 +170,23 @@ namespace IRun {
 
 
 
+			std::vector<const char*> extensions{};
+
+			if (!m_headless)
+				extensions.insert(extensions.end(), m_deviceExtensions.begin(), m_deviceExtensions.end());
+
+			m_presentWaitEnabled = !m_headless && CheckPresentWaitSupport();
+			if (m_presentWaitEnabled)
+				extensions.insert(extensions.end(), m_presentWaitExtensions.begin(), m_presentWaitExtensions.end());
+
+			I_LOG_INFO("Present wait: %s", m_presentWaitEnabled ? "supported" : "not supported, frames are paced on the Cpu");
+
 			VkDeviceCreateInfo deviceCreateInfo{};
 			deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 			deviceCreateInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
 			deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-			deviceCreateInfo.enabledExtensionCount = (uint32_t)m_deviceExtensions.size();
-			deviceCreateInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
+			deviceCreateInfo.enabledExtensionCount = (uint32_t)extensions.size();
+			deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
 			// Deprecated in Vulkan 1.1
 			deviceCreateInfo.enabledLayerCount = 0;
 			deviceCreateInfo.ppEnabledLayerNames = nullptr;
@@ -186,6 +200,19 @@ namespace IRun {
 			vk12DeviceFeatures.timelineSemaphore = VK_TRUE;
 			deviceCreateInfo.pNext = &vk12DeviceFeatures;
 
+			VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+			presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+			presentWaitFeatures.pNext = nullptr;
+			presentWaitFeatures.presentWait = VK_TRUE;
+
+			VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+			presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+			presentIdFeatures.presentId = VK_TRUE;
+
+			if (m_presentWaitEnabled)
+				vk12DeviceFeatures.pNext = &presentIdFeatures;
+
 			VK_CHECK(vkCreateDevice(m_physicalDevice, &deviceCreateInfo, nullptr, &m_device), "Failed to create Vulkan Logical Device!");
 			I_DEBUG_LOG_TRACE("Created Vulkan device: 0x%p", m_device);
 
@@ -255,7 +282,8 @@ namespace IRun {
 			int i = 0;
 			for (const VkQueueFamilyProperties& queueFamilyProps : queueFamilies) {
 				VkBool32 presentationQueue = false;
-				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface.Get(), &presentationQueue);
+				if (!m_headless)
+					vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface.Get(), &presentationQueue);
 
 				// Have to check if a queue family has more than one queue because a queue can have 0 queues for some reason.
 				if (queueFamilyProps.queueCount > 0 && queueFamilyProps.queueFlags & VK_QUEUE_GRAPHICS_BIT)
@@ -281,6 +309,10 @@ namespace IRun {
 			indices.videoDecodeFamily = supportedQueuesinQueueFamilies[QueueType::VideoDecode].index;
 			indices.presentationFamily = supportedQueuesinQueueFamilies[QueueType::Presentation].index;
 
+			// Nothing is presented, the queue only exists so the queues are the same as with a surface.
+			if (m_headless)
+				indices.presentationFamily = indices.graphicsFamily;
+
 			return indices;
 		}
 
@@ -293,6 +325,11 @@ namespace IRun {
 			vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
 			QueueFamilyIndices indices = FindQueueFamilies(device, surface);
+
+			// Any device with a graphics queue can render offscreen, including software implementations like lavapipe.
+			if (m_headless)
+				return indices.IsValid();
+
 			SwapchainDetails details = FindSwapchainDetails(device, surface);
 
 			bool extensionsSupported = CheckDeviceExtensionSupport(device);
@@ -326,6 +363,42 @@ namespace IRun {
 			return false;
 		}
 
+		bool Device::CheckPresentWaitSupport() {
+			uint32_t extensionCount = 0;
+			vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+
+			std::vector<VkExtensionProperties> extensions{};
+			extensions.resize(extensionCount);
+
+			vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, extensions.data());
+
+			for (const char* presentWaitExtension : m_presentWaitExtensions) {
+				bool found = false;
+				for (const VkExtensionProperties& extension : extensions)
+					if (strcmp(extension.extensionName, presentWaitExtension) == 0)
+						found = true;
+
+				if (!found)
+					return false;
+			}
+
+			// Supporting the extensions doesn't mean the features are.
+			VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+			presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+			VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+			presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &presentIdFeatures;
+
+			vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features);
+
+			return presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+		}
+
 		SwapchainDetails Device::FindSwapchainDetails(VkPhysicalDevice device, const Surface& surface) {
 			SwapchainDetails swapchainDetails{};
 
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <ILog.h>
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
 #include <unordered_map>
 #include <map>
 #include <algorithm>
@@ -32,6 +32,8 @@ namespace IRun {
 			/// Obtain the best physical device (APU, GPU, TPU, etc.) for our program, then create an interface between our physical device and IRun. Must be destroyed before the instance.
 			/// </summary>
 			/// <param name="instance"></param>
+			/// <param name="surface">Surface to be presented to. A default constructed surface creates a headless device, which
+			/// needs no VK_KHR_swapchain and has no presentation queue of its own, the presentation queue is the graphics queue.</param>
 			Device(const Instance& instance, const Surface& surface);
 			/// <summary>
 			/// Destroy the device.
@@ -64,6 +66,12 @@ namespace IRun {
 			/// Get the physical device properties.
 			/// </summary>
 			const inline VkPhysicalDeviceProperties& GetDeviceProperties() const { return m_deviceProperties; }
+			/// <summary>
+			/// If VK_KHR_present_id and VK_KHR_present_wait are enabled, so a present can be given an id and waited on with vkWaitForPresentKHR.
+			/// </summary>
+			inline bool IsPresentWaitEnabled() const { return m_presentWaitEnabled; }
+			/// <returns>If the device was created without a surface and can't present.</returns>
+			inline bool IsHeadless() const { return m_headless; }
 		private:
 			VkPhysicalDevice m_physicalDevice = nullptr;
 			VkDevice m_device;
@@ -77,6 +85,15 @@ namespace IRun {
 				VK_NV_LOW_LATENCY_2_EXTENSION_NAME
 			};
 
+			// Enabled if the device supports them, the renderer falls back to pacing frames on the Cpu otherwise.
+			std::array<const char*, 2> m_presentWaitExtensions = {
+				VK_KHR_PRESENT_ID_EXTENSION_NAME,
+				VK_KHR_PRESENT_WAIT_EXTENSION_NAME
+			};
+
+			bool m_presentWaitEnabled = false;
+			bool m_headless = false;
+
 			QueueFamilyIndices m_indices;
 			SwapchainDetails m_swapchainDetails;
 
@@ -89,6 +106,7 @@ namespace IRun {
 
 			bool CheckDeviceSuitable(VkPhysicalDevice device, const Surface& surface);
 			bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+			bool CheckPresentWaitSupport();
 		};
 	}
 }
@@ -2,7 +2,7 @@
 
 #include "Device.h"
 #include "Buffer.h"
-#include "CommandPool.h"
+#include "UploadManager.h"
 
 namespace IRun {
 	namespace Vk {
@@ -12,81 +12,33 @@ namespace IRun {
 		public:
 			DeviceLocalBuffer() = default;
 			/// <summary>
-			/// 
+			/// Create a device local buffer and enqueue the upload of its data. Does not wait for the upload to finish, 
+			/// the data is ready once DeviceLocalBuffer::GetUploadValue has been signalled on the upload manager's timeline semaphore.
 			/// </summary>
-			/// <param name="device"></param>
-			/// <param name="data"></param>
-			/// <param name="dataSize"></param>
-			/// <param name="usageFlags"></param>
-			/// <param name="sharingMode"></param>
-			DeviceLocalBuffer(Device& device, CommandPool& transferCommandPool, DataType* data, size_t dataSize, VkBufferUsageFlags usageFlags) 
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator.</param>
+			/// <param name="uploadManager">A valid IRun::Vk::UploadManager.</param>
+			/// <param name="data">Data to be uploaded. Can be freed once the constructor returns.</param>
+			/// <param name="dataSize">Number of elements in data.</param>
+			/// <param name="usageFlags">Usage of the buffer. Must be a valid VkBufferUsageFlags.</param>
+			DeviceLocalBuffer(Device& device, Allocator& allocator, UploadManager& uploadManager, DataType* data, size_t dataSize, VkBufferUsageFlags usageFlags) 
 			{
-				// TODO: Check if transfer queue family == graphics queue family.
-				Buffer<DataType> stagingBuffer = Buffer<DataType>{ device, data, dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+				// Written on the transfer queue and read on the graphics queue, concurrent so no ownership transfer is needed.
+				m_deviceLocalBuffer = Buffer<DataType>{ device, allocator, data, dataSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags, VK_SHARING_MODE_CONCURRENT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, BufferFlags::NoMap };
 
-				m_deviceLocalBuffer = Buffer<DataType>{ device, data, dataSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, BufferFlags::NoMap };
-
-				CommandBuffer transferCommandBuffer = transferCommandPool.CreateBuffer(device, CommandBufferLevel::Primary);
-
-				transferCommandPool.BeginRecordingCommands(device, transferCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-					{
-						VkBufferMemoryBarrier barrier{};
-						barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-						barrier.srcAccessMask = VK_ACCESS_NONE;
-						barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-						barrier.buffer = m_deviceLocalBuffer.Get();
-						barrier.size = m_deviceLocalBuffer.GetSize() * sizeof(DataType);
-
-						vkCmdPipelineBarrier(transferCommandPool[transferCommandBuffer], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
-					}
-
-					VkBufferCopy bufferCopyRegion{};
-					bufferCopyRegion.srcOffset = 0;
-					bufferCopyRegion.dstOffset = 0;
-					bufferCopyRegion.size = dataSize * sizeof(DataType);
-
-					vkCmdCopyBuffer(transferCommandPool[transferCommandBuffer], stagingBuffer.Get(), m_deviceLocalBuffer.Get(), 1, &bufferCopyRegion);
-
-					{
-						VkBufferMemoryBarrier barrier{};
-						barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-						barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-						barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-						barrier.buffer = m_deviceLocalBuffer.Get();
-						barrier.size = m_deviceLocalBuffer.GetSize() * sizeof(DataType);
-
-						vkCmdPipelineBarrier(transferCommandPool[transferCommandBuffer], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
-					}
-
-
-				transferCommandPool.EndRecordingCommands(transferCommandBuffer);
-
-				VkSubmitInfo submitInfo{};
-				submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-				std::array<VkCommandBuffer, 1> submitCommandBuffer{
-					transferCommandPool[transferCommandBuffer]
-				};
-
-				submitInfo.commandBufferCount = (uint32_t)submitCommandBuffer.size();
-				submitInfo.pCommandBuffers = submitCommandBuffer.data();
-
-				vkQueueSubmit(device.GetQueues().at(QueueType::Transfer), 1, &submitInfo, nullptr);
-				vkQueueWaitIdle(device.GetQueues().at(QueueType::Transfer));
-
-				transferCommandPool.DestroyCommandBuffer(device, transferCommandBuffer);
-
-				stagingBuffer.Destroy(device);
+				m_uploadValue = uploadManager.Enqueue(device, m_deviceLocalBuffer.Get(), 0, data, dataSize * sizeof(DataType));
 			}
 
-			void Destroy(Device& device) {
-				m_deviceLocalBuffer.Destroy(device);
+			void Destroy(Device& device, Allocator& allocator) {
+				m_deviceLocalBuffer.Destroy(device, allocator);
 			}
 
 			const Buffer<DataType>& Get() const { return m_deviceLocalBuffer; };
+			/// <returns>The upload manager timeline value that is signalled once the data has been uploaded.</returns>
+			const uint64_t GetUploadValue() const { return m_uploadValue; }
 		private:
 			Buffer<DataType> m_deviceLocalBuffer;
+			uint64_t m_uploadValue = 0;
 		};
 	}
 }
\ No newline at end of file
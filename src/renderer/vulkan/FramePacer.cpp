@@ -0,0 +1,85 @@
+#include "FramePacer.h"
+
+#include <thread>
+
+namespace IRun {
+	namespace Vk {
+		// A present that is never shown, like one to a minimized window, must not block the frame forever.
+		static constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
+		// Sleeping is only accurate to about a millisecond on some platforms, the rest of the wait is spent yielding.
+		static constexpr std::chrono::duration<double> SLEEP_MARGIN{ 0.002 };
+
+		FramePacer::FramePacer(const Device& device) :
+			m_device{ device.Get().first }
+		{
+			if (device.IsPresentWaitEnabled())
+				m_waitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR");
+		}
+
+		void FramePacer::SetSwapchain(VkSwapchainKHR swapchain) {
+			m_swapchain = swapchain;
+			m_swapchainFirstPresentId = m_presentId + 1;
+			m_hasLastPresentTime = false;
+		}
+
+		void FramePacer::Wait(uint32_t maxQueuedPresents) {
+			maxQueuedPresents = std::max(maxQueuedPresents, 1u);
+
+			if (m_waitForPresent && m_presentId + 1 > maxQueuedPresents) {
+				uint64_t targetPresentId = m_presentId + 1 - maxQueuedPresents;
+
+				if (targetPresentId >= m_swapchainFirstPresentId && targetPresentId > m_waitedPresentId) {
+					VkResult res = m_waitForPresent(m_device, m_swapchain, targetPresentId, PRESENT_WAIT_TIMEOUT_NS);
+
+					// An out of date swapchain is recreated by the renderer, a timeout just lets the frame start.
+					if (res == VK_SUCCESS) {
+						if (targetPresentId == m_waitedPresentId + 1)
+							RecordPresent(Clock::now());
+						else {
+							m_lastPresentTime = Clock::now();
+							m_hasLastPresentTime = true;
+						}
+					}
+					else if (res != VK_TIMEOUT && res != VK_ERROR_OUT_OF_DATE_KHR && res != VK_SUBOPTIMAL_KHR) {
+						VK_CHECK(res, "Failed to wait for present!");
+					}
+
+					m_waitedPresentId = targetPresentId;
+				}
+			}
+
+			if (m_minFrameTime.count() > 0.0) {
+				Clock::time_point frameStart = m_lastFrameStart + std::chrono::duration_cast<Clock::duration>(m_minFrameTime);
+
+				if (Clock::now() + SLEEP_MARGIN < frameStart)
+					std::this_thread::sleep_until(frameStart - std::chrono::duration_cast<Clock::duration>(SLEEP_MARGIN));
+
+				while (Clock::now() < frameStart)
+					std::this_thread::yield();
+			}
+
+			m_lastFrameStart = Clock::now();
+		}
+
+		uint64_t FramePacer::NextPresentId() {
+			return ++m_presentId;
+		}
+
+		void FramePacer::Presented() {
+			if (!m_waitForPresent)
+				RecordPresent(Clock::now());
+		}
+
+		void FramePacer::SetFrameRateLimit(double framesPerSecond) {
+			m_minFrameTime = std::chrono::duration<double>{ framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0 };
+		}
+
+		void FramePacer::RecordPresent(Clock::time_point time) {
+			if (m_hasLastPresentTime)
+				m_presentIntervalMs = std::chrono::duration<double, std::milli>{ time - m_lastPresentTime }.count();
+
+			m_lastPresentTime = time;
+			m_hasLastPresentTime = true;
+		}
+	}
+}
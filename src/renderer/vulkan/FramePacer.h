@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Device.h"
+
+#include <chrono>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Decides when the Cpu may start the next frame.
+		/// With VK_KHR_present_wait every present gets an id and a frame only starts once the present a set number of frames earlier is on screen,
+		/// which bounds the latency between input and display instead of only bounding the frames queued on the Gpu.
+		/// Without it presents are timed on the Cpu and only the frame rate limit paces frames.
+		/// </summary>
+		class FramePacer {
+		public:
+			FramePacer() = default;
+			/// <param name="device">A valid IRun::Vk::Device. Present wait is used if IRun::Vk::Device::IsPresentWaitEnabled.</param>
+			FramePacer(const Device& device);
+			/// <summary>
+			/// Must be called with every new swapchain, present ids of the old swapchain are never waited on.
+			/// </summary>
+			void SetSwapchain(VkSwapchainKHR swapchain);
+			/// <summary>
+			/// Block until the next frame may start.
+			/// </summary>
+			/// <param name="maxQueuedPresents">Number of presents that may not be on screen yet when the next frame starts, including the one before it. Ignored without present wait.</param>
+			void Wait(uint32_t maxQueuedPresents);
+			/// <summary>
+			/// Get the id of the next present. Put it in VkPresentIdKHR if FramePacer::UsesPresentWait.
+			/// </summary>
+			uint64_t NextPresentId();
+			/// <summary>
+			/// Call once vkQueuePresentKHR has returned.
+			/// </summary>
+			void Presented();
+			/// <summary>
+			/// Don't start frames more often than framesPerSecond. 0 for no limit.
+			/// </summary>
+			void SetFrameRateLimit(double framesPerSecond);
+			/// <returns>Frame rate limit, 0 if there is none.</returns>
+			inline double GetFrameRateLimit() const { return m_minFrameTime.count() > 0.0 ? 1.0 / m_minFrameTime.count() : 0.0; }
+			/// <returns>If presents are waited on with vkWaitForPresentKHR.</returns>
+			inline bool UsesPresentWait() const { return m_waitForPresent != nullptr; }
+			/// <returns>
+			/// Time between the last two presents. With present wait it is the time between them reaching the screen as seen by the Cpu,
+			/// otherwise the time between vkQueuePresentKHR returning.
+			/// </returns>
+			inline double GetPresentIntervalMs() const { return m_presentIntervalMs; }
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			VkDevice m_device = VK_NULL_HANDLE;
+			VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+			PFN_vkWaitForPresentKHR m_waitForPresent = nullptr;
+
+			// Id of the last present, 0 before the first one.
+			uint64_t m_presentId = 0;
+			// Id of the first present to the current swapchain.
+			uint64_t m_swapchainFirstPresentId = 1;
+			// Last id vkWaitForPresentKHR returned for.
+			uint64_t m_waitedPresentId = 0;
+
+			std::chrono::duration<double> m_minFrameTime{ 0.0 };
+			Clock::time_point m_lastFrameStart{};
+
+			// Time the last present was waited on or returned from vkQueuePresentKHR, not set for the first present to a swapchain.
+			Clock::time_point m_lastPresentTime{};
+			bool m_hasLastPresentTime = false;
+			double m_presentIntervalMs = 0.0;
+
+			void RecordPresent(Clock::time_point time);
+		};
+	}
+}
@@ -0,0 +1,245 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+
+namespace IRun {
+	namespace Vk {
+		void GpuProfiler::Create(const Device& device, uint32_t queueFamily, uint32_t frameCount, uint32_t maxScopesPerFrame, uint32_t historySize) {
+			m_device = device.Get().first;
+			m_maxScopesPerFrame = maxScopesPerFrame;
+			m_historySize = std::max(historySize, 1u);
+
+			uint32_t queueFamilyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(device.Get().second, &queueFamilyCount, nullptr);
+
+			std::vector<VkQueueFamilyProperties> queueFamilies{};
+			queueFamilies.resize(queueFamilyCount);
+
+			vkGetPhysicalDeviceQueueFamilyProperties(device.Get().second, &queueFamilyCount, queueFamilies.data());
+
+			uint32_t timestampValidBits = queueFamilies[queueFamily].timestampValidBits;
+
+			if (timestampValidBits == 0) {
+				I_LOG_WARNING("Queue family %u doesn't support timestamps, the Gpu profiler is disabled.", queueFamily);
+				return;
+			}
+
+			m_timestampMask = timestampValidBits >= 64 ? UINT64_MAX : ((1ULL << timestampValidBits) - 1);
+			m_timestampPeriod = (double)device.GetDeviceProperties().limits.timestampPeriod;
+
+			// Two queries per scope, start and end.
+			VkQueryPoolCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			createInfo.queryCount = frameCount * maxScopesPerFrame * 2;
+
+			VK_CHECK(vkCreateQueryPool(m_device, &createInfo, nullptr, &m_queryPool), "Failed to create Vulkan timestamp query pool!");
+			I_DEBUG_LOG_TRACE("Created Vulkan query pool: 0x%p", m_queryPool);
+
+			m_frames = std::vector<FrameQueries>(frameCount);
+			for (FrameQueries& frame : m_frames)
+				frame.records.resize(maxScopesPerFrame);
+
+			m_timestamps.resize((size_t)maxScopesPerFrame * 2);
+		}
+
+		void GpuProfiler::Destroy(const Device& device) {
+			if (m_csv.is_open())
+				m_csv.close();
+
+			if (m_queryPool == VK_NULL_HANDLE)
+				return;
+
+			vkDestroyQueryPool(device.Get().first, m_queryPool, nullptr);
+			I_DEBUG_LOG_TRACE("Destroyed Vulkan query pool: 0x%p", m_queryPool);
+			m_queryPool = VK_NULL_HANDLE;
+		}
+
+		void GpuProfiler::CollectFrame(uint32_t frame) {
+			if (m_queryPool == VK_NULL_HANDLE || !m_frames[frame].pending)
+				return;
+
+			FrameQueries& frameQueries = m_frames[frame];
+			frameQueries.pending = false;
+
+			uint32_t recordCount = std::min(frameQueries.recordCount.load(), m_maxScopesPerFrame);
+			if (recordCount == 0)
+				return;
+
+			// No VK_QUERY_RESULT_WAIT_BIT, the frame has finished so the results are available.
+			VkResult res = vkGetQueryPoolResults(m_device, m_queryPool, frame * m_maxScopesPerFrame * 2, recordCount * 2, recordCount * 2 * sizeof(uint64_t), m_timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+			if (res != VK_SUCCESS) {
+				I_DEBUG_LOG_ERROR("IRun::Vk::GpuProfiler::CollectFrame: timestamps of frame %u are not available.", frame);
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			m_frameSums.assign(m_scopes.size(), -1.0);
+
+			for (uint32_t i = 0; i < recordCount; i++) {
+				uint64_t ticks = (m_timestamps[i * 2 + 1] - m_timestamps[i * 2]) & m_timestampMask;
+				double ms = (double)ticks * m_timestampPeriod / 1000000.0;
+
+				double& sum = m_frameSums[frameQueries.records[i].scopeId];
+				sum = sum < 0.0 ? ms : sum + ms;
+			}
+
+			for (uint32_t scopeId = 0; scopeId < (uint32_t)m_frameSums.size(); scopeId++) {
+				if (m_frameSums[scopeId] < 0.0)
+					continue;
+
+				ScopeHistory& scope = m_scopes[scopeId];
+				scope.lastMs = m_frameSums[scopeId];
+
+				if (scope.samples.size() < m_historySize)
+					scope.samples.push_back(scope.lastMs);
+				else
+					scope.samples[scope.frames % m_historySize] = scope.lastMs;
+
+				scope.frames++;
+
+				if (m_csv.is_open())
+					m_csv << frameQueries.frameNumber << ',' << scope.name << ',' << scope.lastMs << '\n';
+			}
+		}
+
+		void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber) {
+			if (m_queryPool == VK_NULL_HANDLE)
+				return;
+
+			FrameQueries& frameQueries = m_frames[frame];
+			frameQueries.recordCount = 0;
+			frameQueries.frameNumber = frameNumber;
+			frameQueries.pending = true;
+
+			vkCmdResetQueryPool(commandBuffer, m_queryPool, frame * m_maxScopesPerFrame * 2, m_maxScopesPerFrame * 2);
+		}
+
+		uint32_t GpuProfiler::GetScopeId(const std::string& name) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			auto itr = m_scopeIds.find(name);
+			if (itr != m_scopeIds.end())
+				return itr->second;
+
+			uint32_t scopeId = (uint32_t)m_scopes.size();
+
+			ScopeHistory scope{};
+			scope.name = name;
+			m_scopes.push_back(scope);
+			m_scopeIds.insert({ name, scopeId });
+
+			return scopeId;
+		}
+
+		uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scopeId) {
+			if (m_queryPool == VK_NULL_HANDLE)
+				return UINT32_MAX;
+
+			FrameQueries& frameQueries = m_frames[frame];
+
+			uint32_t scope = frameQueries.recordCount.fetch_add(1);
+			if (scope >= m_maxScopesPerFrame)
+				return UINT32_MAX;
+
+			frameQueries.records[scope].scopeId = scopeId;
+
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, (frame * m_maxScopesPerFrame + scope) * 2);
+
+			return scope;
+		}
+
+		void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope) {
+			if (scope == UINT32_MAX)
+				return;
+
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, (frame * m_maxScopesPerFrame + scope) * 2 + 1);
+		}
+
+		double GpuProfiler::GetLastMs(uint32_t scopeId) const {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			if (scopeId >= m_scopes.size())
+				return 0.0;
+
+			return m_scopes[scopeId].lastMs;
+		}
+
+		// Nearest rank percentile of sorted samples.
+		static double Percentile(const std::vector<double>& sortedSamples, double percentile) {
+			size_t rank = (size_t)(percentile * (double)(sortedSamples.size() - 1) + 0.5);
+			return sortedSamples[std::min(rank, sortedSamples.size() - 1)];
+		}
+
+		std::vector<GpuScopeStats> GpuProfiler::GetStats() const {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			std::vector<GpuScopeStats> stats{};
+			std::vector<double> sortedSamples{};
+
+			for (const ScopeHistory& scope : m_scopes) {
+				GpuScopeStats scopeStats{};
+				scopeStats.name = scope.name;
+				scopeStats.frames = scope.frames;
+				scopeStats.lastMs = scope.lastMs;
+
+				if (!scope.samples.empty()) {
+					sortedSamples = scope.samples;
+					std::sort(sortedSamples.begin(), sortedSamples.end());
+
+					double sum = 0.0;
+					for (double sample : sortedSamples)
+						sum += sample;
+
+					scopeStats.averageMs = sum / (double)sortedSamples.size();
+					scopeStats.minMs = sortedSamples.front();
+					scopeStats.maxMs = sortedSamples.back();
+					scopeStats.p50Ms = Percentile(sortedSamples, 0.50);
+					scopeStats.p95Ms = Percentile(sortedSamples, 0.95);
+					scopeStats.p99Ms = Percentile(sortedSamples, 0.99);
+				}
+
+				stats.push_back(scopeStats);
+			}
+
+			return stats;
+		}
+
+		bool GpuProfiler::SetCsvOutput(const std::string& filename) {
+			if (m_csv.is_open())
+				m_csv.close();
+
+			if (filename.empty())
+				return true;
+
+			m_csv.open(filename, std::ios::trunc);
+
+			if (!m_csv.is_open()) {
+				I_LOG_ERROR("Failed to open Gpu profiler csv file: %s", filename.c_str());
+				return false;
+			}
+
+			m_csv << "frame,scope,ms\n";
+
+			return true;
+		}
+
+		bool GpuProfiler::WriteStatsCsv(const std::string& filename) const {
+			std::ofstream file{ filename, std::ios::trunc };
+
+			if (!file.is_open()) {
+				I_LOG_ERROR("Failed to open Gpu profiler csv file: %s", filename.c_str());
+				return false;
+			}
+
+			file << "scope,frames,last_ms,average_ms,min_ms,max_ms,p50_ms,p95_ms,p99_ms\n";
+
+			for (const GpuScopeStats& stats : GetStats())
+				file << stats.name << ',' << stats.frames << ',' << stats.lastMs << ',' << stats.averageMs << ',' << stats.minMs << ',' << stats.maxMs << ',' << stats.p50Ms << ',' << stats.p95Ms << ',' << stats.p99Ms << '\n';
+
+			return (bool)file;
+		}
+	}
+}
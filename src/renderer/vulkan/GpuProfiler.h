@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Device.h"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Gpu time of a profiler scope over the last frames it was recorded in.
+		/// </summary>
+		struct GpuScopeStats {
+			std::string name;
+			// Frames the scope was recorded in since the profiler was created.
+			uint64_t frames = 0;
+			// Statistics of the last GpuProfiler::GetHistorySize frames.
+			double lastMs = 0.0;
+			double averageMs = 0.0;
+			double minMs = 0.0;
+			double maxMs = 0.0;
+			double p50Ms = 0.0;
+			double p95Ms = 0.0;
+			double p99Ms = 0.0;
+		};
+
+		/// <summary>
+		/// Measures Gpu time of scopes of command buffers with VkQueryPool timestamps.
+		/// Every frame in flight has its own queries, which are read back when the frame's fence has been waited on, so reading never stalls.
+		/// Scopes recorded more than once in a frame, like the draws of one batch split across threads, are summed into one sample.
+		/// </summary>
+		class GpuProfiler {
+		public:
+			GpuProfiler() = default;
+			GpuProfiler(const GpuProfiler&) = delete;
+			GpuProfiler& operator=(const GpuProfiler&) = delete;
+			/// <summary>
+			/// Create the query pool. Does nothing if the queue family has no timestamps, check GpuProfiler::IsSupported.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="queueFamily">Queue family the profiled command buffers are submitted to.</param>
+			/// <param name="frameCount">Number of frames in flight, frames are indexed 0 - frameCount - 1.</param>
+			/// <param name="maxScopesPerFrame">Scopes recorded past this in a frame are not measured.</param>
+			/// <param name="historySize">Number of frames statistics are computed over.</param>
+			void Create(const Device& device, uint32_t queueFamily, uint32_t frameCount, uint32_t maxScopesPerFrame, uint32_t historySize);
+			/// <summary>
+			/// Destroy the query pool and close the csv file.
+			/// </summary>
+			void Destroy(const Device& device);
+			/// <returns>If timestamps are supported and scopes are measured.</returns>
+			inline bool IsSupported() const { return m_queryPool != VK_NULL_HANDLE; }
+			/// <summary>
+			/// Read back the scopes of the last submission of frame. The frame must have finished on the Gpu. Does nothing if they were read already.
+			/// </summary>
+			void CollectFrame(uint32_t frame);
+			/// <summary>
+			/// Reset the queries of frame. Call with the first command of the frame's primary command buffer, outside of a render pass, after GpuProfiler::CollectFrame.
+			/// </summary>
+			/// <param name="frameNumber">Frame number written to the csv file.</param>
+			void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber);
+			/// <summary>
+			/// Get the id of a scope, the scope is created the first time a name is used. Thread safe.
+			/// </summary>
+			uint32_t GetScopeId(const std::string& name);
+			/// <summary>
+			/// Write the start timestamp of a scope. Thread safe, any command buffer of the frame can record scopes.
+			/// </summary>
+			/// <returns>Handle to pass to GpuProfiler::EndScope.</returns>
+			uint32_t BeginScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scopeId);
+			/// <summary>
+			/// Write the end timestamp of a scope, in the same command buffer as GpuProfiler::BeginScope.
+			/// </summary>
+			void EndScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope);
+			/// <returns>Gpu time of the scope in the last frame that was read back, 0 if it hasn't been measured yet.</returns>
+			double GetLastMs(uint32_t scopeId) const;
+			/// <returns>Statistics of every scope.</returns>
+			std::vector<GpuScopeStats> GetStats() const;
+			/// <returns>Number of frames statistics are computed over.</returns>
+			inline uint32_t GetHistorySize() const { return m_historySize; }
+			/// <summary>
+			/// Append every sample to a csv file as frame,scope,ms when it is read back. An empty filename stops writing.
+			/// </summary>
+			/// <returns>False if the file couldn't be opened.</returns>
+			bool SetCsvOutput(const std::string& filename);
+			/// <summary>
+			/// Write the statistics of every scope to a csv file.
+			/// </summary>
+			/// <returns>False if the file couldn't be written.</returns>
+			bool WriteStatsCsv(const std::string& filename) const;
+		private:
+			struct ScopeHistory {
+				std::string name;
+				// Ring buffer of the last m_historySize samples.
+				std::vector<double> samples;
+				uint64_t frames = 0;
+				double lastMs = 0.0;
+			};
+
+			struct Record {
+				uint32_t scopeId;
+			};
+
+			struct FrameQueries {
+				// Scope of every pair of queries of the frame.
+				std::vector<Record> records;
+				std::atomic<uint32_t> recordCount = 0;
+				uint64_t frameNumber = 0;
+				// Set by BeginFrame, cleared by CollectFrame.
+				bool pending = false;
+			};
+
+			VkDevice m_device = VK_NULL_HANDLE;
+			VkQueryPool m_queryPool = VK_NULL_HANDLE;
+			// Nanoseconds per tick.
+			double m_timestampPeriod = 0.0;
+			uint64_t m_timestampMask = 0;
+			uint32_t m_maxScopesPerFrame = 0;
+			uint32_t m_historySize = 0;
+
+			std::vector<FrameQueries> m_frames;
+			std::vector<uint64_t> m_timestamps;
+			std::vector<double> m_frameSums;
+
+			// Guards the scopes, which recording threads create.
+			mutable std::mutex m_mutex;
+			std::vector<ScopeHistory> m_scopes;
+			std::unordered_map<std::string, uint32_t> m_scopeIds;
+
+			std::ofstream m_csv;
+		};
+	}
+}
@@ -1,36 +1,43 @@
 #include "GraphicsPipeline.h"
 
 #include "tools/Timer.h"
+#include "tools/Profiler.h"
 
 namespace IRun {
 	namespace Vk {
-		GraphicsPipeline::GraphicsPipeline(const std::string& vertShaderFilename, const std::string& fragShaderFilename, ShaderLanguage lang, Device& device, Swapchain& swapchain, RenderPass& renderPass, PipelineCache& pipelineCache, std::optional<int> pushConstants, std::optional<VkDescriptorSetLayout> descriptorSetLayout, std::optional<GraphicsPipeline> basePipeline) {
+		GraphicsPipeline::GraphicsPipeline(const std::string& vertShaderFilename, const std::string& fragShaderFilename, ShaderLanguage lang, Device& device, Swapchain& swapchain, RenderPass& renderPass, PipelineCache& pipelineCache, std::optional<int> pushConstants, std::optional<VkDescriptorSetLayout> descriptorSetLayout, std::optional<GraphicsPipeline> basePipeline) :
+			GraphicsPipeline{ CompileShaders(vertShaderFilename, fragShaderFilename, lang), device, swapchain, renderPass, pipelineCache, pushConstants, descriptorSetLayout, basePipeline }
+		{ }
 
-			VkShaderModule vertShaderModule{};
-			VkShaderModule fragShaderModule{};
+		std::array<std::vector<char>, 2> GraphicsPipeline::CompileShaders(const std::string& vertShaderFilename, const std::string& fragShaderFilename, ShaderLanguage lang, bool exitOnError) {
+			IRUN_PROFILE_FUNCTION();
 
-			
 			switch (lang)
 			{
-			case IRun::ShaderLanguage::HLSL: {
-				std::array<std::vector<char>, 2> shaderBin = Tools::DXC::CompileHLSLtoSPRIV(vertShaderFilename, fragShaderFilename);
-				vertShaderModule = CreateShaderModules((const uint32_t*)shaderBin[0].data(), shaderBin[0].size(), device);
-				fragShaderModule = CreateShaderModules((const uint32_t*)shaderBin[1].data(), shaderBin[1].size(), device);
-				break;
-			}
+			case IRun::ShaderLanguage::HLSL:
+#ifdef IRUN_WINDOWED
+				return Tools::DXC::CompileHLSLtoSPRIV(vertShaderFilename, fragShaderFilename, exitOnError);
+#else
+				// DXC is only linked on Windows, glslang compiles the same hlsl elsewhere.
+				return Tools::Shaders::CompileHLSLtoSPRIV(vertShaderFilename, fragShaderFilename, exitOnError);
+#endif
 			case IRun::ShaderLanguage::Spirv: {
 				std::string vertShaderCode = Tools::ReadFile(vertShaderFilename, Tools::IoFlags::Binary);
 				std::string fragShaderCode = Tools::ReadFile(fragShaderFilename, Tools::IoFlags::Binary);
-				vertShaderModule = CreateShaderModules((uint32_t*)vertShaderCode.c_str(), vertShaderCode.size(), device);
-				fragShaderModule = CreateShaderModules((uint32_t*)fragShaderCode.c_str(), vertShaderCode.size(), device);
-				break;
+				return { std::vector<char>{ vertShaderCode.begin(), vertShaderCode.end() }, std::vector<char>{ fragShaderCode.begin(), fragShaderCode.end() } };
 			}
 			default:
-				I_DEBUG_LOG_FATAL_ERROR("GraphicsPipeline::GraphicsPipeline(const std::string&, const std::string&, ShaderLanguage, Device&, Swapchain&, RenderPass&, GraphicsPipeline*, PipelineCache&): param ShaderLangauge is not a valid language type.");
-				break;
+				I_DEBUG_LOG_FATAL_ERROR("GraphicsPipeline::CompileShaders(const std::string&, const std::string&, ShaderLanguage): param ShaderLangauge is not a valid language type.");
+				return {};
 			}
+		}
+
+		GraphicsPipeline::GraphicsPipeline(const std::array<std::vector<char>, 2>& spirv, Device& device, Swapchain& swapchain, RenderPass& renderPass, PipelineCache& pipelineCache, std::optional<int> pushConstants, std::optional<VkDescriptorSetLayout> descriptorSetLayout, std::optional<GraphicsPipeline> basePipeline) {
+			IRUN_PROFILE_SCOPE("GraphicsPipeline::CreatePipeline");
+
+			VkShaderModule vertShaderModule = CreateShaderModules((const uint32_t*)spirv[0].data(), spirv[0].size(), device);
+			VkShaderModule fragShaderModule = CreateShaderModules((const uint32_t*)spirv[1].data(), spirv[1].size(), device);
 
-			
 			VkPipelineShaderStageCreateInfo vertShaderCreateInfo{};
 			vertShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 			vertShaderCreateInfo.module = vertShaderModule;
@@ -47,15 +54,20 @@ namespace IRun {
 				vertShaderCreateInfo, fragShaderCreateInfo
 			};
 
-			VkVertexInputBindingDescription bindingDescription{};
+			std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
 			// Can bind multiple streams of data, this defines which one.
-			bindingDescription.binding = 0;
+			bindingDescriptions[0].binding = 0;
 			// Size of each vertex object.
-			bindingDescription.stride = sizeof(Vertex); 
+			bindingDescriptions[0].stride = sizeof(Vertex); 
 			// For instancing. How to move between data after each vertex.
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-			std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+			// Per instance data, moves to the next element after each instance.
+			bindingDescriptions[1].binding = 1;
+			bindingDescriptions[1].stride = sizeof(InstanceData);
+			bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
 
 			// position attribute
 			// Binds this attribute to VkVertexInputBindingDescription::binding = 0
@@ -77,12 +89,18 @@ namespace IRun {
 			// Location of attribute in each stride
 			attributeDescriptions[1].offset = offsetof(Vertex, uv);
 
+			// transform index attribute
+			// Index into the model matrix storage buffer.
+			attributeDescriptions[2].binding = 1;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R32_UINT;
+			attributeDescriptions[2].offset = offsetof(InstanceData, transformIndex);
 
 			VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo{};
 			vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
+			vertexInputCreateInfo.vertexBindingDescriptionCount = (uint32_t)bindingDescriptions.size();
 			// Basically does the same thing as glVertexAttribPointer. Handles data spacing/stride info.
-			vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;
+			vertexInputCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 			vertexInputCreateInfo.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptions.size();
 			// Basically does the same thing as glVertexAttribPointer. Format and where to bind it to.
 			vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
@@ -212,11 +230,18 @@ namespace IRun {
 			// Index defined in VkRenderPassCreateInfo::pSubpasses
 			graphicsPipelineCreateInfo.subpass = 0;
 
-			// Base this pipline off another one
-			if (basePipeline.has_value())
+			// Base this pipline off another one. Pipelines without a base can be the base of others.
+			if (basePipeline.has_value()) {
+				graphicsPipelineCreateInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
 				graphicsPipelineCreateInfo.basePipelineHandle = basePipeline.value().Get();
-			// Base this pipeline off of another pipeline in an array of pipeline create infos (not used since we only have one pipline)
-			graphicsPipelineCreateInfo.basePipelineIndex = 0;
+				// Must be -1 when basePipelineHandle is used.
+				graphicsPipelineCreateInfo.basePipelineIndex = -1;
+			}
+			else {
+				graphicsPipelineCreateInfo.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+				// Base this pipeline off of another pipeline in an array of pipeline create infos (not used since we only have one pipline)
+				graphicsPipelineCreateInfo.basePipelineIndex = -1;
+			}
 
 			VK_CHECK(vkCreateGraphicsPipelines(device.Get().first, pipelineCache.Get().second, 1, &graphicsPipelineCreateInfo, nullptr, &m_graphicsPipeline), "Failed to create graphics pipeline!");
 			I_DEBUG_LOG_TRACE("Created Vulkan graphics pipeline: 0x%p", m_graphicsPipeline);
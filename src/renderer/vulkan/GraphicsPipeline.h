@@ -1,18 +1,25 @@
 #pragma once
 
+#include "Core.h"
 #include "Device.h"
 #include "Swapchain.h"
 #include "RenderPass.h"
 #include "PipelineCache.h"
-#include "tools\File.h"
-#include "tools\dxc\HLSLCompiler.h"
+#include "tools/File.h"
+#ifdef IRUN_WINDOWED
+#include "tools/dxc/HLSLCompiler.h"
+#else
+#include "tools/shaderc/ShaderCompiler.h"
+#endif
 #include "../ShaderLang.h"
 #include "../Vertex.h"
 #include "DescriptorPool.h"
 
+#include <array>
 #include <string>
+#include <vector>
 
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
 
 namespace IRun {
 	namespace Vk {
@@ -34,7 +41,22 @@ namespace IRun {
 			/// <param name="basePipeline">Can be nullptr, the base pipeline that this pipeline is based on.</param>
 			/// <param name="pipelineCache">A valid IRun::Vk::PipelineCache.</param>
 			GraphicsPipeline(const std::string& vertShaderFilename, const std::string& fragShaderfilename, ShaderLanguage lang, Device& device, Swapchain& swapchain, RenderPass& renderPass, PipelineCache& pipelineCache, std::optional<int> pushConstants = std::nullopt , std::optional<VkDescriptorSetLayout> descriptorPool = std::nullopt, std::optional<GraphicsPipeline> basePipeline = std::nullopt);
-			/// <returns>Get the VkPipeline handle.</returns>
+			/// <summary>
+			/// Creates a graphics pipeline from already compiled shaders. Can be called from several threads at once with the same pipeline cache.
+			/// </summary>
+			/// <param name="spirv">Spirv byte code of the vertex shader (1st index) and fragment shader (2nd index). Returned by GraphicsPipeline::CompileShaders.</param>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="swapchain">A valid IRun::Vk::Swapchain.</param>
+			/// <param name="renderPass">A valid IRun::Vk::RenderPass</param>
+			/// <param name="pipelineCache">A valid IRun::Vk::PipelineCache.</param>
+			GraphicsPipeline(const std::array<std::vector<char>, 2>& spirv, Device& device, Swapchain& swapchain, RenderPass& renderPass, PipelineCache& pipelineCache, std::optional<int> pushConstants = std::nullopt, std::optional<VkDescriptorSetLayout> descriptorPool = std::nullopt, std::optional<GraphicsPipeline> basePipeline = std::nullopt);
+			/// <summary>
+			/// Compile hlsl shaders to spirv or read spirv shaders.
+			/// </summary>
+			/// <param name="exitOnError">If false a shader that fails to compile is logged and returned empty instead of ending the application.</param>
+			/// <returns>Spirv byte code of the vertex shader (1st index) and fragment shader (2nd index). Empty if a shader failed to read or compile.</returns>
+			static std::array<std::vector<char>, 2> CompileShaders(const std::string& vertShaderFilename, const std::string& fragShaderFilename, ShaderLanguage lang, bool exitOnError = true);
+			/// <returns>Get the VkPipeline handle. VK_NULL_HANDLE if the pipeline hasn't been created.</returns>
 			inline const VkPipeline& Get() const { return m_graphicsPipeline; }
 
 			inline const VkPipelineLayout& GetLayout() const { return m_graphicsPipelineLayout; }
@@ -45,8 +67,8 @@ namespace IRun {
 			/// <param name="device">A valid IRun::Vk::Device.</param>
 			void Destroy(const Device& device);
 		private:
-			VkPipeline m_graphicsPipeline;
-			VkPipelineLayout m_graphicsPipelineLayout;
+			VkPipeline m_graphicsPipeline = VK_NULL_HANDLE;
+			VkPipelineLayout m_graphicsPipelineLayout = VK_NULL_HANDLE;
 
 			VkShaderModule CreateShaderModules(const uint32_t* spirvByteCode, size_t codeSize, const Device& device);
 		};
@@ -42,7 +42,11 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 
 namespace IRun {
 	namespace Vk {
-		Instance::Instance(IWindow::Window& window) {
+		Instance::Instance(IWindow::Window& window) :
+			Instance{ &window }
+		{}
+
+		Instance::Instance(IWindow::Window* window) {
 			CreateInstance(window);
 			CreateDebugMessenger();
 		}
@@ -54,7 +58,7 @@ namespace IRun {
 			vkDestroyInstance(m_instance, nullptr);
 		}
 
-		void Instance::CreateInstance(IWindow::Window& window) {
+		void Instance::CreateInstance(IWindow::Window* window) {
 			if (m_enableValidationLayers && !CheckValidationLayerSupport()) {
 				I_DEBUG_LOG_ERROR("Validation layers are not supported! Program will continue with no validation.");
 				m_enableValidationLayers = false;
@@ -73,8 +77,15 @@ namespace IRun {
 			createInfo.pApplicationInfo = &appInfo;
 
 			std::vector<const char*> requiredInstanceExtensions{};
-			requiredInstanceExtensions.push_back(VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
-			IWindow::Vk::GetRequiredInstanceExtensions(requiredInstanceExtensions);
+			// Headless instances don't create a surface, so they run on machines without a display.
+#ifdef IRUN_WINDOWED
+			if (window) {
+				requiredInstanceExtensions.push_back(VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
+				IWindow::Vk::GetRequiredInstanceExtensions(requiredInstanceExtensions);
+			}
+#else
+			I_ASSERT_FATAL_ERROR(window, "IRun::Vk::Instance: there are no windows on this platform, pass nullptr for a headless instance! Abort!");
+#endif
 			if (m_enableValidationLayers)
 				requiredInstanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "Core.h"
+
+#ifdef IRUN_WINDOWED
 #include <IWindow.h>
 #include <IWindowVK.h>
+#endif
 #include <ILog.h>
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
 
 #include "Check.h"
 
@@ -18,6 +22,11 @@ namespace IRun {
 			/// <param name="window"></param>
 			Instance(IWindow::Window& window);
 			/// <summary>
+			/// Create connection between Vulkan and IRun. Without a window no surface extensions are enabled, for headless rendering.
+			/// </summary>
+			/// <param name="window">Window to be rendered to or nullptr for headless rendering. Always nullptr where IRUN_WINDOWED isn't defined.</param>
+			Instance(IWindow::Window* window);
+			/// <summary>
 			/// Destroy's VkInstance and VkDebugUtilsMessenger (if in debug mode).
 			/// </summary>
 			void Destroy();
@@ -30,7 +39,7 @@ namespace IRun {
 			VkInstance m_instance;
 			VkDebugUtilsMessengerEXT m_debugMessenger;
 
-			void CreateInstance(IWindow::Window& window);
+			void CreateInstance(IWindow::Window* window);
 			void CreateDebugMessenger();
 
 			std::vector<const char*> m_validationLayers = {
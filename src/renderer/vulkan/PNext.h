@@ -1,6 +1,6 @@
 #pragma once
 
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
 
 namespace IRun {
 	namespace Tools {
@@ -1,124 +1,77 @@
 #include "PipelineCache.h"
 
 #include "tools/File.h"
+#include "tools/Hash.h"
+#include "tools/Profiler.h"
 
 namespace IRun {
 	namespace Vk {
 		constexpr uint32_t MAGIC = 0x2834554734ui32;
-
-		std::pair<uint8_t*, uint32_t> ConvertIRunPipelineCacheToVulkanPipelineCache(PipelineCacheHeader& header, uint8_t* cacheWithoutHeader, VkPipelineCacheHeaderVersion vkPipelineHeaderVersion) {
-			if (vkPipelineHeaderVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
-				I_LOG_ERROR("IRun's pipeline cache only supports converting to Vulkan pipeline cache version one!");
-				return { nullptr, 0 };
-			}
-
-			// Offset	 Size            Meaning
-			// ------    ------------    ------------------------------------------------------------------
-			//      0               4    length in bytes of the entire pipeline cache header written as a
-			//                           stream of bytes, with the least significant byte first
-			//      4               4    a VkPipelineCacheHeaderVersion value written as a stream of bytes,
-			//                           with the least significant byte first
-			//      8               4    a vendor ID equal to VkPhysicalDeviceProperties::vendorID written
-			//                           as a stream of bytes, with the least significant byte first
-			//     12               4    a device ID equal to VkPhysicalDeviceProperties::deviceID written
-			//                           as a stream of bytes, with the least significant byte first
-			//     16    VK_UUID_SIZE    a pipeline cache ID equal to VkPhysicalDeviceProperties::pipelineCacheUUID
-
-			uint32_t sizeOfHeader = 4 + 4 + 4 + 4 + VK_UUID_SIZE;
-			uint32_t pipelineHeaderVersion = (uint32_t)vkPipelineHeaderVersion;
-
-			uint8_t* vkPipelineCache = new uint8_t[(sizeOfHeader + header.dataSize)];
-
-			size_t offset = 0;
-
-			memcpy(vkPipelineCache, &sizeOfHeader, 4);
-			offset += 4;
-			memcpy(vkPipelineCache + offset, &pipelineHeaderVersion, 4);
-			offset += 4;
-			memcpy(vkPipelineCache + offset, &header.vendorID, 4);
-			offset += 4;
-			memcpy(vkPipelineCache + offset, &header.deviceID, 4);
-			offset += 4;
-			memcpy(vkPipelineCache + offset, &header.uuid, VK_UUID_SIZE);
-			offset += VK_UUID_SIZE;
-			memcpy(vkPipelineCache + offset, cacheWithoutHeader, header.dataSize);
-
-			return { vkPipelineCache, sizeOfHeader };
-		}
-
-		std::pair<uint8_t*, size_t> ConvertVulkanPipelineCacheToIRunPipelineCache(uint8_t* vkCacheDataWithHeader, size_t size, PipelineCacheHeader& header) {
-			size_t sizeOfVulkanHeader = 4 + 4 + 4 + 4 + VK_UUID_SIZE;
-			size_t sizeOfIRunHeader = 4 + 8 + 8 + 4 + 4 + 4 + VK_UUID_SIZE;
-			size_t sizeOfCacheDataWithoutHeader = (size - sizeOfVulkanHeader);
-
-			uint8_t* iRunPipelineCache = new uint8_t[(sizeOfCacheDataWithoutHeader + sizeOfIRunHeader)];
-
-			uint8_t* vkCacheDataWithoutHeader = new uint8_t[sizeOfCacheDataWithoutHeader];
-
-			memcpy(vkCacheDataWithoutHeader, vkCacheDataWithHeader + sizeOfVulkanHeader, sizeOfCacheDataWithoutHeader);
-
-			size_t offset = 0;
-			memcpy(iRunPipelineCache, &MAGIC, sizeof(uint32_t));
-			offset += sizeof(uint32_t);
-
-			memcpy(iRunPipelineCache + offset, &sizeOfCacheDataWithoutHeader, sizeof(size_t));
-			offset += sizeof(size_t);
-			size_t hash = header.Hash(vkCacheDataWithoutHeader);
-			memcpy(iRunPipelineCache + offset, &hash, sizeof(size_t));
-			offset += sizeof(size_t);
-			memcpy(iRunPipelineCache + offset, &header.vendorID, sizeof(uint32_t));
-			offset += sizeof(uint32_t);
-			memcpy(iRunPipelineCache + offset, &header.deviceID, sizeof(uint32_t));
-			offset += sizeof(uint32_t);
-			memcpy(iRunPipelineCache + offset, &header.driverVersion, sizeof(uint32_t));
-			offset += sizeof(uint32_t);
-			memcpy(iRunPipelineCache + offset, &header.uuid, (VK_UUID_SIZE * sizeof(uint8_t)));
-			offset += (VK_UUID_SIZE * sizeof(uint8_t));
-			memcpy(iRunPipelineCache + offset, vkCacheDataWithoutHeader, (sizeOfCacheDataWithoutHeader * sizeof(uint8_t)));
-
-			delete[] vkCacheDataWithoutHeader;
-
-			return { iRunPipelineCache, { size + sizeOfIRunHeader } };
-		}
+		// Version 1 stored the data without Vulkan's header and checked it with std::hash of a copy of the whole file.
+		constexpr uint32_t VERSION = 2;
 
 		ErrorCode PipelineCache::SaveCache(const std::string& filename, Device& device) {
+			IRUN_PROFILE_FUNCTION();
+
 			size_t dataSize = 0;
 
 			VK_CHECK(vkGetPipelineCacheData(device.Get().first, m_pipelineCache, &dataSize, nullptr), "Failed to get pipeline cache data!");
 
-			uint8_t* cacheData = new uint8_t[dataSize];
+			std::vector<uint8_t> cacheData(dataSize);
+
+			VK_CHECK(vkGetPipelineCacheData(device.Get().first, m_pipelineCache, &dataSize, cacheData.data()), "Failed to get pipeline cache data!");
 
-			VK_CHECK(vkGetPipelineCacheData(device.Get().first, m_pipelineCache, &dataSize, cacheData), "Failed to get pipeline cache data!");
+			return WriteCacheFile(filename, device.GetDeviceProperties(), cacheData.data(), dataSize);
+		}
 
-			m_header.vendorID = device.GetDeviceProperties().vendorID;
-			m_header.deviceID = device.GetDeviceProperties().deviceID;
-			m_header.driverVersion = device.GetDeviceProperties().driverVersion;
-			memcpy(m_header.uuid, device.GetDeviceProperties().pipelineCacheUUID, (VK_UUID_SIZE * sizeof(uint8_t)));
+		ErrorCode PipelineCache::WriteCacheFile(const std::string& filename, const VkPhysicalDeviceProperties& properties, const uint8_t* data, size_t dataSize) {
+			IRUN_PROFILE_FUNCTION();
 
-			size_t sizeOfVulkanHeader = 4 + 4 + 4 + 4 + VK_UUID_SIZE;
+			PipelineCacheHeader header{};
+			header.magic = MAGIC;
+			header.version = VERSION;
+			header.dataSize = dataSize;
+			header.dataHash = Tools::XXHash64(data, dataSize);
+			header.vendorID = properties.vendorID;
+			header.deviceID = properties.deviceID;
+			header.driverVersion = properties.driverVersion;
+			memcpy(header.uuid, properties.pipelineCacheUUID, (VK_UUID_SIZE * sizeof(uint8_t)));
 
-			std::pair<uint8_t*, size_t> convertedData = ConvertVulkanPipelineCacheToIRunPipelineCache(cacheData, (dataSize + sizeOfVulkanHeader), m_header);
+			std::filesystem::path directories = std::filesystem::path{ filename }.parent_path();
 
-			std::string directories = filename.substr(0, filename.find_last_of("/\\"));
+			std::error_code error{};
+			if (!directories.empty())
+				std::filesystem::create_directories(directories, error);
 
-			std::filesystem::create_directories(directories);
+			// Written next to the old cache and renamed over it, so the old cache stays intact if the application dies while saving.
+			std::string tempFilename = filename + ".tmp";
 
 			std::ofstream file{};
 
-			file.open(filename, std::ios::trunc | std::ios::binary);
+			file.open(tempFilename, std::ios::trunc | std::ios::binary);
 
 			if (!file.is_open()) {
-				I_LOG_ERROR("Failed to save cache at: %s", filename.c_str());
-				file.close();
+				I_LOG_ERROR("Failed to save cache at: %s", tempFilename.c_str());
 				return ErrorCode::IoError;
 			}
 
-			file.write((char*)convertedData.first, convertedData.second);
-
+			file.write((const char*)&header, sizeof(header));
+			file.write((const char*)data, dataSize);
 			file.close();
 
-			delete[] convertedData.first;
-			delete[] cacheData;
+			if (!file) {
+				I_LOG_ERROR("Failed to save cache at: %s", tempFilename.c_str());
+				std::filesystem::remove(tempFilename, error);
+				return ErrorCode::IoError;
+			}
+
+			std::filesystem::rename(tempFilename, filename, error);
+
+			if (error) {
+				I_LOG_ERROR("Failed to save cache at: %s (%s)", filename.c_str(), error.message().c_str());
+				std::filesystem::remove(tempFilename, error);
+				return ErrorCode::IoError;
+			}
 
 			return ErrorCode::Success;
 		}
@@ -134,72 +87,62 @@ namespace IRun {
 			return ErrorCode::Success;
 		}
 
-		ErrorCode PipelineCache::RetrieveCache(const std::string& filename, Device& device) {
-			std::ifstream file{};
-
-			file.open(filename, std::ios::binary | std::ios::ate);
+		ErrorCode PipelineCache::MapCacheFile(const std::string& filename, const VkPhysicalDeviceProperties& properties, Tools::MappedFile& file, std::pair<const uint8_t*, size_t>& data) {
+			file = Tools::MappedFile{ filename };
 
-			if (!file.is_open()) {
-				file.close();
+			if (!file.IsValid())
 				return ErrorCode::IoError;
-			}
 
-			size_t cacheDataSize = (size_t)file.tellg();
+			PipelineCacheHeader header{};
+			bool badCache = file.GetSize() < sizeof(header);
 
-			uint8_t* cacheData = new uint8_t[cacheDataSize];
-			
-			file.seekg(std::ios_base::beg);
-			file.read((char*)cacheData, cacheDataSize);
-			file.close();
+			if (!badCache)
+				memcpy(&header, file.GetData(), sizeof(header));
 
-			size_t offset = 0;
+			// Cheap checks first, the hash is only computed for a file that was saved on this device.
+			if (!badCache && header.magic != MAGIC) badCache = true;
 
-			memcpy(&m_header.magic, cacheData, 4);
-			offset += 4;
-			memcpy(&m_header.dataSize, cacheData + offset, 8);
-			offset += 8;
-			memcpy(&m_header.dataHash, cacheData + offset, 8);
-			offset += 8;
-			memcpy(&m_header.vendorID, cacheData + offset, 4);
-			offset += 4;
-			memcpy(&m_header.deviceID, cacheData + offset, 4);
-			offset += 4;
-			memcpy(&m_header.driverVersion, cacheData + offset, 4);
-			offset += 4;
-			memcpy(m_header.uuid, cacheData + offset, VK_UUID_SIZE);
-			offset += VK_UUID_SIZE;
+			if (!badCache && header.version != VERSION) badCache = true;
 
-			uint8_t* cacheDataWithoutHeader = new uint8_t[m_header.dataSize];
+			if (!badCache && header.dataSize != file.GetSize() - sizeof(header)) badCache = true;
 
-			memcpy(cacheDataWithoutHeader, cacheData + offset, m_header.dataSize);
+			if (!badCache && header.vendorID != properties.vendorID) badCache = true;
 
-			bool badCache = false;
+			if (!badCache && header.deviceID != properties.deviceID) badCache = true;
 
-			if (m_header.Hash(cacheDataWithoutHeader) != m_header.dataHash) badCache = true;
+			if (!badCache && header.driverVersion != properties.driverVersion) badCache = true;
 
-			if (m_header.magic != MAGIC) badCache = true;
+			if (!badCache && memcmp(header.uuid, properties.pipelineCacheUUID, sizeof(header.uuid)) != 0) badCache = true;
 
-			if (m_header.vendorID != device.GetDeviceProperties().vendorID) badCache = true;
+			if (!badCache && Tools::XXHash64(file.GetData() + sizeof(header), (size_t)header.dataSize) != header.dataHash) badCache = true;
 
-			if (m_header.deviceID != device.GetDeviceProperties().deviceID) badCache = true;
+			if (badCache) {
+				file.Destroy();
+				return ErrorCode::Corrupt;
+			}
 
-			if (m_header.driverVersion != device.GetDeviceProperties().driverVersion) badCache = true;
+			data = { file.GetData() + sizeof(header), (size_t)header.dataSize };
 
-			if (memcmp(m_header.uuid, device.GetDeviceProperties().pipelineCacheUUID, sizeof(m_header.uuid)) != 0) badCache = true;
+			return ErrorCode::Success;
+		}
 
-			if (badCache) {
-				delete[] cacheData;
-				delete[] cacheDataWithoutHeader;
+		ErrorCode PipelineCache::RetrieveCache(const std::string& filename, Device& device) {
+			IRUN_PROFILE_FUNCTION();
 
-				return ErrorCode::Corrupt;
-			}
+			Tools::MappedFile file{};
+			std::pair<const uint8_t*, size_t> data{};
+
+			ErrorCode err = MapCacheFile(filename, device.GetDeviceProperties(), file, data);
+
+			if (err != ErrorCode::Success)
+				return err;
 
-			std::pair<uint8_t*, uint32_t> convertedCache = ConvertIRunPipelineCacheToVulkanPipelineCache(m_header, cacheDataWithoutHeader, VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+			memcpy(&m_header, file.GetData(), sizeof(m_header));
 
-			CreateCache(device, convertedCache.first, (convertedCache.second + m_header.dataSize));
+			// Vulkan copies what it needs while creating the cache, so the file can be unmapped right after.
+			CreateCache(device, (uint8_t*)data.first, data.second);
 
-			delete[] convertedCache.first;
-			delete[] cacheDataWithoutHeader;
+			file.Destroy();
 
 			return ErrorCode::Success;
 		}
@@ -210,4 +153,4 @@ namespace IRun {
 		}
 
 	}
-}
\ No newline at end of file
+}
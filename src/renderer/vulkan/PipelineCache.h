@@ -2,6 +2,7 @@
 
 #include "Device.h"
 #include "Error.h"
+#include "tools/MappedFile.h"
 
 #include <functional>
 #include <string>
@@ -12,14 +13,17 @@ namespace IRun {
 		/// A more secure way to store pipeline cache data to disk
 		/// Sources: https://medium.com/@zeuxcg/creating-a-robust-pipeline-cache-with-vulkan-961d09416cda,
 		/// https://github.com/LunarG/VulkanSamples/blob/master/API-Samples/pipeline_cache/pipeline_cache.cpp
+		/// Written in front of the data returned by vkGetPipelineCacheData, which is stored as is so it can be passed straight to vkCreatePipelineCache.
 		/// </summary>
 		struct PipelineCacheHeader {
 			// a random number that is defined in "renderer/vulkan/PipelineCache.cpp" to make sure its our file
 			uint32_t magic;
+			// Version of this header, bumped when the file layout changes.
+			uint32_t version;
 			// Equal to *pDataSize returned by vkGetPipelineCacheData
-			size_t dataSize;
-			// A hash of pipeline cache data with the header
-			size_t dataHash;
+			uint64_t dataSize;
+			// IRun::Tools::XXHash64 of the pipeline cache data, to catch truncated or corrupted files.
+			uint64_t dataHash;
 
 			// Equal to VkPhysicalDeviceProperties::vendorID. Retrieve from IRun::Vk::Device::GetDeviceProperties.
 			uint32_t vendorID;
@@ -31,33 +35,10 @@ namespace IRun {
 			// Equal to VkPhysicalDeviceProperties::pipelineCacheUUID. Retrieve from IRun::Vk::Device::GetDeviceProperties.
 			uint8_t uuid[VK_UUID_SIZE];
 
-
-			/// <summary>
-			/// Hashes the pipeline header and Vulkan pipeline cache data.
-			/// PipelineCacheHeader::dataHash is set to this hash for security.
-			/// <param name="data">Buffer to Vulkan pipeline cache data without the Vulkan header.</param>
-			/// </summary>
-			size_t Hash(uint8_t* data) {
-				return std::hash<std::string>()(ToString(data));
-			}
-
-		private:
-			/// <summary>
-			/// Turns this struct into a string form excluding PipelineCacheHeader::dataHash.
-			/// data is a buffer of the pipeline cache data without the vulkan header.
-			/// </summary>
-			std::string ToString(uint8_t* data) const {
-				std::string string = std::string{ uuid, uuid + VK_UUID_SIZE };
-
-				return std::to_string(magic) +
-					std::to_string(dataSize) +
-					std::to_string(vendorID) +
-					std::to_string(deviceID) +
-					std::to_string(driverVersion) + 
-					std::string{ uuid, uuid + VK_UUID_SIZE } + 
-					std::string{ data, data + dataSize };
-			}
+			// Keeps the pipeline cache data 8 byte aligned in the file.
+			uint32_t padding;
 		};
+		static_assert(sizeof(PipelineCacheHeader) == 56, "IRun::Vk::PipelineCacheHeader is written to disk as is, its size must not change.");
 
 		class PipelineCache {
 		public:
@@ -72,6 +53,7 @@ namespace IRun {
 			ErrorCode CreateCache(Device& device, uint8_t* dataCache, size_t dataSize);
 			/// <summary>
 			/// Saves the cache to a file. The file with be saved with the IRun pipeline cache format.
+			/// The file is written to a temporary file first and renamed over filename, so a crash never leaves half of a file behind.
 			/// </summary>
 			/// <param name="filename">file to save cache data to.</param>
 			/// <param name="device">A valid IRun::Vk::Device.</param>
@@ -81,7 +63,8 @@ namespace IRun {
 			/// </returns>
 			ErrorCode SaveCache(const std::string& filename, Device& device);
 			/// <summary>
-			/// Saves the cache to a file. The file with should be in IRun pipeline cache format and will automatically convert the format to the appropriate Vulkan format and create a VkPipelineCache using that data. If this method succeeds then it will create the VkPipelineCache.
+			/// Retrieves the cache from a file in the IRun pipeline cache format and creates a VkPipelineCache using that data. If this method succeeds then it will create the VkPipelineCache.
+			/// The file is memory mapped and its data is passed to vkCreatePipelineCache without being copied.
 			/// </summary>
 			/// <param name="filename">file to get the cache data from.</param>
 			/// <param name="device">A valid IRun::Vk::Device.</param>
@@ -92,6 +75,31 @@ namespace IRun {
 			/// </returns>
 			ErrorCode RetrieveCache(const std::string& filename, Device& device);
 			/// <summary>
+			/// Write Vulkan pipeline cache data to a file in the IRun pipeline cache format. Used by PipelineCache::SaveCache.
+			/// </summary>
+			/// <param name="filename">File to save cache data to. Written to filename + ".tmp" first and then renamed.</param>
+			/// <param name="properties">Properties of the device the data was retrieved from.</param>
+			/// <param name="data">Data returned by vkGetPipelineCacheData.</param>
+			/// <param name="dataSize">Size of data in bytes.</param>
+			/// <returns>
+			/// Returns IRun::ErrorCode::Success if the function succeeds.
+			/// Returns IRun::ErrorCode::IoError if the file failed to be written.
+			/// </returns>
+			static ErrorCode WriteCacheFile(const std::string& filename, const VkPhysicalDeviceProperties& properties, const uint8_t* data, size_t dataSize);
+			/// <summary>
+			/// Map a file in the IRun pipeline cache format and check that it is intact and was saved on this device. Used by PipelineCache::RetrieveCache.
+			/// </summary>
+			/// <param name="filename">File to get the cache data from.</param>
+			/// <param name="properties">Properties of the device the cache will be created on.</param>
+			/// <param name="file">Set to the mapped file if this function succeeds. The caller must destroy it.</param>
+			/// <param name="data">Set to the Vulkan pipeline cache data inside of file and its size.</param>
+			/// <returns>
+			/// Returns IRun::ErrorCode::Success if the function succeeds.
+			/// Returns IRun::ErrorCode::IoError if file failed to open.
+			/// Returns IRun::ErrorCode::Corrupt if the file contains corrupted data or was saved on another device or driver.
+			/// </returns>
+			static ErrorCode MapCacheFile(const std::string& filename, const VkPhysicalDeviceProperties& properties, Tools::MappedFile& file, std::pair<const uint8_t*, size_t>& data);
+			/// <summary>
 			/// Get the IRun::Vk::PipelineCacheHeader and the VkPipelineCache handle
 			/// </summary>
 			/// <returns>
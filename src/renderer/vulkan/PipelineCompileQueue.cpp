@@ -0,0 +1,85 @@
+#include "PipelineCompileQueue.h"
+
+#include "tools/Timer.h"
+#include "tools/Profiler.h"
+
+#include <ILog.h>
+
+namespace IRun {
+	namespace Vk {
+		void PipelineCompileQueue::Create() {
+			I_ASSERT_FATAL_ERROR(m_running, "IRun::Vk::PipelineCompileQueue::Create: the compile queue has already been created!");
+
+			m_running = true;
+			m_thread = std::thread{ &PipelineCompileQueue::ThreadMain, this };
+		}
+
+		void PipelineCompileQueue::Push(const ECS::Shader& shaders, CompileFunction compile) {
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_jobs.push_back({ shaders, std::move(compile) });
+			}
+			m_wakeCondition.notify_one();
+		}
+
+		void PipelineCompileQueue::PopFinished(std::vector<Result>& finished) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			for (Result& result : m_finished)
+				finished.push_back(std::move(result));
+
+			m_finished.clear();
+		}
+
+		uint32_t PipelineCompileQueue::GetPendingCount() {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			return (uint32_t)m_jobs.size() + m_compiling;
+		}
+
+		void PipelineCompileQueue::Destroy(std::vector<Result>& finished) {
+			if (!m_running)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_running = false;
+				m_jobs.clear();
+			}
+			m_wakeCondition.notify_all();
+
+			m_thread.join();
+
+			PopFinished(finished);
+		}
+
+		void PipelineCompileQueue::ThreadMain() {
+			Tools::Profiler::SetThreadName("Pipeline compile");
+
+			while (true) {
+				Job job{};
+
+				{
+					std::unique_lock<std::mutex> lock{ m_mutex };
+					m_wakeCondition.wait(lock, [this]() { return !m_running || !m_jobs.empty(); });
+
+					if (!m_running)
+						break;
+
+					job = std::move(m_jobs.front());
+					m_jobs.pop_front();
+					m_compiling = 1;
+				}
+
+				Tools::Timer<Tools::Milliseconds> timer{};
+				timer.Start();
+
+				GraphicsPipeline pipeline = job.compile();
+				double compileMs = timer.Stop();
+
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_finished.push_back({ job.shaders, pipeline, compileMs });
+				m_compiling = 0;
+			}
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "GraphicsPipeline.h"
+
+#include "ecs/Components.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Compiles shaders and creates graphics pipelines one at a time on a thread of its own, so a new shader pair never blocks a frame.
+		/// It doesn't use the job system because a thread waiting on a job counter runs any queued job, which could be a compile in the middle of a frame.
+		/// </summary>
+		class PipelineCompileQueue {
+		public:
+			/// <summary>
+			/// Creates the pipeline. Capture objects by value, it is called on the compile thread.
+			/// </summary>
+			using CompileFunction = std::function<GraphicsPipeline()>;
+
+			/// <summary>
+			/// A pipeline that has finished compiling.
+			/// </summary>
+			struct Result {
+				ECS::Shader shaders;
+				GraphicsPipeline pipeline;
+				// Shader compilation and pipeline creation.
+				double compileMs;
+			};
+
+			PipelineCompileQueue() = default;
+			PipelineCompileQueue(const PipelineCompileQueue&) = delete;
+			PipelineCompileQueue& operator=(const PipelineCompileQueue&) = delete;
+			/// <summary>
+			/// Start the compile thread.
+			/// </summary>
+			void Create();
+			/// <summary>
+			/// Queue a pipeline to be compiled. Pipelines are compiled in the order they are pushed.
+			/// </summary>
+			/// <param name="shaders">Shader pair of the pipeline, returned with the result.</param>
+			/// <param name="compile">Function that creates the pipeline.</param>
+			void Push(const ECS::Shader& shaders, CompileFunction compile);
+			/// <summary>
+			/// Move every pipeline that has finished compiling since the last call into finished.
+			/// </summary>
+			/// <param name="finished">Finished pipelines are appended to it. The caller owns them.</param>
+			void PopFinished(std::vector<Result>& finished);
+			/// <returns>Number of pipelines that are queued or compiling.</returns>
+			uint32_t GetPendingCount();
+			/// <summary>
+			/// Wait for the pipeline that is compiling, drop the queued ones and stop the compile thread.
+			/// </summary>
+			/// <param name="finished">Pipelines that have finished but were never popped are appended to it, the caller must destroy them.</param>
+			void Destroy(std::vector<Result>& finished);
+		private:
+			struct Job {
+				ECS::Shader shaders;
+				CompileFunction compile;
+			};
+
+			std::mutex m_mutex;
+			std::condition_variable m_wakeCondition;
+			std::deque<Job> m_jobs;
+			std::vector<Result> m_finished;
+			// 1 while the compile thread runs a job that has been taken out of m_jobs.
+			uint32_t m_compiling = 0;
+			bool m_running = false;
+
+			std::thread m_thread;
+
+			void ThreadMain();
+		};
+	}
+}
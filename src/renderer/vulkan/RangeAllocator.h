@@ -0,0 +1,111 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+#include <algorithm>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Hands out ranges of [0, size) with a first fit free list. Freed ranges are coalesced with their neighbours.
+		/// Does not own any memory, used to place allocations inside of VkDeviceMemory blocks and buffers.
+		/// </summary>
+		class RangeAllocator {
+		public:
+			RangeAllocator() = default;
+			/// <summary>
+			/// Init range allocator.
+			/// </summary>
+			/// <param name="size">Size of the range to hand out.</param>
+			RangeAllocator(uint64_t size) : m_size{ size } {
+				if (size > 0)
+					m_freeRanges.insert({ 0, size });
+			}
+			/// <summary>
+			/// Allocate a range.
+			/// </summary>
+			/// <param name="size">Size of the range.</param>
+			/// <param name="alignment">Alignment of the start of the range. Must be a power of two.</param>
+			/// <param name="offset">Set to the start of the range if the allocation succeeds.</param>
+			/// <returns>False if there is no free range big enough.</returns>
+			inline bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset) {
+				for (auto itr = m_freeRanges.begin(); itr != m_freeRanges.end(); itr++) {
+					uint64_t rangeOffset = itr->first;
+					uint64_t rangeEnd = itr->first + itr->second;
+					uint64_t alignedOffset = (rangeOffset + alignment - 1) & ~(alignment - 1);
+
+					if (alignedOffset + size > rangeEnd)
+						continue;
+
+					m_freeRanges.erase(itr);
+
+					// Give back the padding in front of the allocation and the remainder after it.
+					if (alignedOffset > rangeOffset)
+						m_freeRanges.insert({ rangeOffset, alignedOffset - rangeOffset });
+					if (alignedOffset + size < rangeEnd)
+						m_freeRanges.insert({ alignedOffset + size, rangeEnd - (alignedOffset + size) });
+
+					m_used += size;
+					offset = alignedOffset;
+					return true;
+				}
+
+				return false;
+			}
+			/// <summary>
+			/// Give back a range returned by RangeAllocator::Allocate.
+			/// </summary>
+			inline void Free(uint64_t offset, uint64_t size) {
+				m_used -= size;
+				Insert(offset, size);
+			}
+			/// <summary>
+			/// Make the allocator bigger. The new space is added to the end of the range.
+			/// </summary>
+			/// <param name="newSize">Must be bigger than the current size.</param>
+			inline void Grow(uint64_t newSize) {
+				uint64_t oldSize = m_size;
+				m_size = newSize;
+				Insert(oldSize, newSize - oldSize);
+			}
+			/// <returns>Size of the range being handed out.</returns>
+			inline uint64_t GetSize() const { return m_size; }
+			/// <returns>Sum of the sizes of all allocated ranges.</returns>
+			inline uint64_t GetUsed() const { return m_used; }
+			/// <returns>Size of the biggest free range.</returns>
+			inline uint64_t GetLargestFreeRange() const {
+				uint64_t largest = 0;
+				for (const std::pair<const uint64_t, uint64_t>& range : m_freeRanges)
+					largest = std::max(largest, range.second);
+				return largest;
+			}
+			/// <returns>Free ranges sorted by offset (offset -> size).</returns>
+			inline const std::map<uint64_t, uint64_t>& GetFreeRanges() const { return m_freeRanges; }
+		private:
+			uint64_t m_size = 0;
+			uint64_t m_used = 0;
+			// offset -> size, sorted so neighbouring ranges can be coalesced.
+			std::map<uint64_t, uint64_t> m_freeRanges;
+
+			inline void Insert(uint64_t offset, uint64_t size) {
+				auto itr = m_freeRanges.insert({ offset, size }).first;
+
+				// Coalesce with the next range.
+				auto next = std::next(itr);
+				if (next != m_freeRanges.end() && itr->first + itr->second == next->first) {
+					itr->second += next->second;
+					m_freeRanges.erase(next);
+				}
+
+				// Coalesce with the previous range.
+				if (itr != m_freeRanges.begin()) {
+					auto prev = std::prev(itr);
+					if (prev->first + prev->second == itr->first) {
+						prev->second += itr->second;
+						m_freeRanges.erase(itr);
+					}
+				}
+			}
+		};
+	}
+}
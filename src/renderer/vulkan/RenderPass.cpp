@@ -22,7 +22,7 @@ namespace IRun {
 			// We don't know what layout it is before render pass starts
 			colourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 			// Layout after render pass (to change to)
-			colourAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			colourAttachment.finalLayout = swapchain.IsOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 			// Attachment reference uses an an attachment index in the attachment list passed to renderPassCreateInfo
 			VkAttachmentReference colourAttachmentReference{};
@@ -63,6 +63,12 @@ namespace IRun {
 			subpassDepedencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 			subpassDepedencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 
+			// Offscreen images are copied to a buffer after the render pass instead of presented.
+			if (swapchain.IsOffscreen()) {
+				subpassDepedencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				subpassDepedencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			}
+
 
 			VkRenderPassCreateInfo renderPassCreateInfo{};
 			renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
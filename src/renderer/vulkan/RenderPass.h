@@ -12,7 +12,7 @@ namespace IRun {
 			/// Create the VkRenderPass.
 			/// </summary>
 			/// <param name="device">A valid IRun::Vk::Device.</param>
-			/// <param name="swapchain">A valid IRun::Vk::Swapchain</param>
+			/// <param name="swapchain">A valid IRun::Vk::Swapchain. The images of an offscreen swapchain are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL instead of ready to present.</param>
 			RenderPass(Device& device, Swapchain& swapchain);
 			/// <summary>
 			/// Destroys the VkRenderPass;
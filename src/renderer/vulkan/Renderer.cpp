@@ -1,14 +1,48 @@
 #include "Renderer.h"
 
+#include "tools/Png.h"
+
 namespace IRun {
 	namespace Vk {
-		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+		// Per frame resources are created for this many frames so Renderer::SetFramesInFlight doesn't recreate descriptor sets that pipelines are created against.
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+		static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+		// Read back as is, so Renderer::ReadFrame returns RGBA without swizzling.
+		static constexpr VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+		static constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 1024;
+		// Scopes past this in a frame aren't measured, only matters with Gpu draw profiling.
+		static constexpr uint32_t GPU_PROFILER_MAX_SCOPES_PER_FRAME = 1024;
+		static constexpr uint32_t GPU_PROFILER_HISTORY_SIZE = 256;
+		static const std::string PIPELINE_CACHE_FILENAME = "shaders/cache/PipelineCache.bin";
+		// How often the pipeline cache is saved if new pipelines were created.
+		static constexpr std::chrono::milliseconds PIPELINE_CACHE_SAVE_INTERVAL{ 10000 };
+
+		/// <summary>
+		/// Make sure a persistently mapped host visible buffer can hold count elements. The buffer must not be in use by the Gpu.
+		/// </summary>
+		/// <returns>True if the buffer was recreated.</returns>
+		template<typename DataType>
+		static bool ReserveHostBuffer(Device& device, Allocator& allocator, Buffer<DataType>& buffer, size_t count, VkBufferUsageFlags usageFlags) {
+			if (buffer.GetSize() >= count)
+				return false;
+
+			size_t capacity = std::max(count, buffer.GetSize() * 2);
+
+			buffer.Destroy(device, allocator);
+			buffer = Buffer<DataType>{ device, allocator, nullptr, capacity, usageFlags, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, BufferFlags::PersistentMap };
+
+			return true;
+		}
 
+#ifdef IRUN_WINDOWED
 		Renderer::Renderer(IWindow::Window& window, ICamera& camera, ECS::Helper& helper, bool vSync) :
 			m_window{ &window },
 			m_helper{ &helper },
 			m_camera{ &camera },
 			m_currentFrame{ 0 },
+			m_frameNumber{ 0 },
+			m_framesInFlight{ DEFAULT_FRAMES_IN_FLIGHT },
+			m_swapchainImageCount{ 0 },
 			m_vSync{ vSync },
 			m_framebufferResized{ false },
 			m_oldFramebufferSize{ window.GetFramebufferSize() },
@@ -17,64 +51,138 @@ namespace IRun {
 			m_instance = Instance{ window };
 			m_surface = Surface{ window, m_instance };
 			m_device = Device{ m_instance, m_surface };
-			m_swapchain = Swapchain{ vSync, window, m_surface, m_device, nullptr };
+			m_allocator = Allocator{ m_device };
+			m_swapchain = Swapchain{ vSync, m_swapchainImageCount, window, m_surface, m_device, nullptr };
+
+			CreateResources();
+
+			Nv::SetLowLatencyMode(m_device.Get().first, m_device.GetDeviceProperties(), m_swapchain.Get(), Nv::LowLatencyMode::OnBoost);
+		}
+#endif
+
+		Renderer::Renderer(ICamera& camera, ECS::Helper& helper, uint32_t width, uint32_t height) :
+			m_window{ nullptr },
+			m_helper{ &helper },
+			m_camera{ &camera },
+			m_currentFrame{ 0 },
+			m_frameNumber{ 0 },
+			m_framesInFlight{ DEFAULT_FRAMES_IN_FLIGHT },
+			m_swapchainImageCount{ MAX_FRAMES_IN_FLIGHT },
+			m_vSync{ false },
+			m_framebufferResized{ false },
+			m_clearColor{ 0.0f, 0.0f, 0.0f }
+		{
+			m_instance = Instance{ nullptr };
+			// m_surface stays default constructed, which makes the device headless.
+			m_device = Device{ m_instance, m_surface };
+			m_allocator = Allocator{ m_device };
+			// One image per frame in flight, a frame renders to the image of its frame index once its fence has been waited on.
+			m_headlessExtent = { width, height };
+			m_swapchain = Swapchain{ m_headlessExtent, OFFSCREEN_FORMAT, MAX_FRAMES_IN_FLIGHT, m_device };
+
+			CreateResources();
+		}
+
+		void Renderer::CreateResources() {
 			m_renderPass = RenderPass{ m_device, m_swapchain };
 
+			m_framePacer = FramePacer{ m_device };
+			m_framePacer.SetSwapchain(m_swapchain.Get());
+
 			m_pipelineCache = PipelineCache{};
-			ErrorCode err = m_pipelineCache.RetrieveCache("shaders/cache/PipelineCache.bin", m_device);
+			ErrorCode err = m_pipelineCache.RetrieveCache(PIPELINE_CACHE_FILENAME, m_device);
 
 			// For first run or corrupted cache. Create empty cache for data to be stored in.
 			if ((int64_t)(err & ErrorCode::IoError) || (int64_t)(err & ErrorCode::Corrupt)) {
 				m_pipelineCache.CreateCache(m_device, nullptr, 0);
 			}
 
-			m_uniformBuffers.resize(m_swapchain.GetSwapchainImages().size());
-			m_descriptorSets.resize(m_swapchain.GetSwapchainImages().size());
-
-			VkDescriptorPoolSize poolSize{};
-			poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			poolSize.descriptorCount = (uint32_t)1;
-
-			m_descriptorPool = DescriptorPool{ m_device, 3, 1, &poolSize };
+			m_threadPipelineCaches = std::make_unique<ThreadPipelineCaches>();
+			m_threadPipelineCaches->Create(m_device, m_pipelineCache, PIPELINE_CACHE_FILENAME, PIPELINE_CACHE_SAVE_INTERVAL);
+
+			// Per frame in flight instead of per swapchain image, so they are safe to write once the frame's fence has been waited on.
+			m_uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+			m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+			std::array<VkDescriptorPoolSize, 2> poolSizes{};
+			poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			poolSizes[0].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+			poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			poolSizes[1].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+
+			m_descriptorPool = DescriptorPool{ m_device, MAX_FRAMES_IN_FLIGHT, poolSizes.size(), poolSizes.data() };
+
+			std::array<VkDescriptorSetLayoutBinding, 2> layoutBindings{};
+			// View projection
+			layoutBindings[0].binding = 0;
+			layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			layoutBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			layoutBindings[0].descriptorCount = (uint32_t)1;
+			// Model matrices, indexed with InstanceData::transformIndex
+			layoutBindings[1].binding = 1;
+			layoutBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			layoutBindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			layoutBindings[1].descriptorCount = (uint32_t)1;
 
-			VkDescriptorSetLayoutBinding mvpLayoutBinding{};
-			mvpLayoutBinding.binding = 0;
-			mvpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			mvpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-			mvpLayoutBinding.descriptorCount = (uint32_t)1;
-
-			m_mvp.model = glm::mat4{ 1.0f };
 			//m_mvp.proj = glm::ortho(100.0f, 100.0f, 100.0f, 100.0f, 0.0f, 100.0f);
 			m_mvp.proj = m_camera->GetProjection();
 			m_mvp.view = m_camera->GetView();
 
-			m_mvp.model = glm::scale(m_mvp.model, { 2.0f, 2.0f, 2.0f });
-
 			m_graphicsCommandPool = CommandPool{ m_device, m_device.GetQueueFamilies().graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT };
-			m_transferCommandPool = CommandPool{ m_device, m_device.GetQueueFamilies().transferFamily };
+			m_uploadManager = UploadManager{ m_device, m_allocator };
+
+			m_vertexArena = BufferArena<Vertex>{ m_device, m_allocator, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT };
+			m_indexArena = BufferArena<uint32_t>{ m_device, m_allocator, VK_BUFFER_USAGE_INDEX_BUFFER_BIT };
+
+			m_instanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+			m_transformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+			for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+				m_instanceBuffers[i] = Buffer<InstanceData>{ m_device, m_allocator, nullptr, INITIAL_INSTANCE_CAPACITY, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, BufferFlags::PersistentMap };
+				m_transformBuffers[i] = Buffer<glm::mat4>{ m_device, m_allocator, nullptr, INITIAL_INSTANCE_CAPACITY, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, BufferFlags::PersistentMap };
+			}
 
 			for (size_t i = 0; i < m_uniformBuffers.size(); i++) {
-				m_descriptorSets[i] = m_descriptorPool.CreateDescriptorSet(m_device, 1, &mvpLayoutBinding);
-				m_uniformBuffers[i] = Buffer<Mvp>{ m_device, &m_mvp, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+				m_descriptorSets[i] = m_descriptorPool.CreateDescriptorSet(m_device, layoutBindings.size(), layoutBindings.data());
+				m_uniformBuffers[i] = Buffer<Mvp>{ m_device, m_allocator, &m_mvp, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, BufferFlags::PersistentMap };
+				// Descriptors only change when a buffer is recreated, not every frame.
 				m_descriptorPool.WriteBufferToDescriptor(m_device, m_descriptorSets[i], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_uniformBuffers[i].Get(), 0, sizeof(Mvp));
+				m_descriptorPool.WriteBufferToDescriptor(m_device, m_descriptorSets[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_transformBuffers[i].Get(), 0, VK_WHOLE_SIZE);
 			}
 
+			PipelineCache* basePipelineCache = m_threadPipelineCaches->Acquire();
+
 			m_basePipeline = GraphicsPipeline{ 
 				"shaders/Vert.hlsl", 
 				"shaders/Frag.hlsl", 
 				ShaderLanguage::HLSL, 
 				m_device, m_swapchain, 
 				m_renderPass, 
-				m_pipelineCache,
+				*basePipelineCache,
 				std::nullopt,
 				std::make_optional(m_descriptorPool.GetDescriptorSetLayout(m_descriptorSets[0]))
 			};
+
+			m_threadPipelineCaches->Release(basePipelineCache, true);
+
+			Tools::SpirvCache::LogStats();
+
+			m_pipelineCompileQueue = std::make_unique<PipelineCompileQueue>();
+			m_pipelineCompileQueue->Create();
+
+			m_shaderWatcher.Create();
+			m_shaderHotReload = debugMode;
 			
 			m_framebuffers = Framebuffers{ m_swapchain, m_renderPass, m_device };
 
-			for (int i = 0; i < m_framebuffers.Get().size(); i++)
+			for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 				m_commandBuffers.emplace_back(m_graphicsCommandPool.CreateBuffer(m_device, IRun::Vk::CommandBufferLevel::Primary));
 
+			m_gpuProfiler = std::make_unique<GpuProfiler>();
+			m_gpuProfiler->Create(m_device, m_device.GetQueueFamilies().graphicsFamily, MAX_FRAMES_IN_FLIGHT, GPU_PROFILER_MAX_SCOPES_PER_FRAME, GPU_PROFILER_HISTORY_SIZE);
+			m_frameScope = m_gpuProfiler->GetScopeId("Frame");
+			m_renderPassScope = m_gpuProfiler->GetScopeId("RenderPass");
+
 			m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 			for (Sync<Semaphore>& semaphore : m_imageAvailableSemaphores)
 				semaphore = Sync<Semaphore>{ m_device };
@@ -94,8 +202,6 @@ namespace IRun {
 			m_renderPassBeginInfo.clearValueCount = 1;
 			m_renderPassBeginInfo.pClearValues = &clearColor;
 
-			Nv::SetLowLatencyMode(m_device.Get().first, m_device.GetDeviceProperties(), m_swapchain.Get(), Nv::LowLatencyMode::OnBoost);
-
 			VkSemaphoreTypeCreateInfo timelineInfo{};
 			timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
 			timelineInfo.pNext = nullptr;
@@ -106,72 +212,170 @@ namespace IRun {
 		}
 
 		void Renderer::AddEntity(ECS::Entity entity) {
-			m_entities.push_back(entity);
+			IRUN_PROFILE_FUNCTION();
 
-			auto [vertexData, indexData, shaders] = m_helper->get<ECS::VertexData, ECS::IndexData, ECS::Shader>(entity);
+			if (m_renderObjectIndices.contains(entity))
+				return;
 
-			if (!m_vertexDataBuffers.contains(entity)) {
+			// The index of the render object and its mesh have to fit in a render queue key.
+			bool needsMesh = !m_helper->has<ECS::Mesh>(entity) && m_freeMeshes.empty();
+			if (m_renderObjects.size() >= (1ull << RenderQueue::INDEX_BITS) || (needsMesh && m_meshes.size() >= (1ull << RenderQueue::MESH_BITS))) {
+				I_LOG_ERROR("IRun::Vk::Renderer::AddEntity failed. The renderer can't draw more than %llu entities or hold more than %llu meshes!", 1ull << RenderQueue::INDEX_BITS, 1ull << RenderQueue::MESH_BITS);
+				return;
+			}
 
-				DeviceLocalBuffer<Vertex> vertexDataBuffer{
-					m_device,
-					m_transferCommandPool,
-					vertexData.data.data(),
-					vertexData.data.size(),
-					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				};
+			auto [shaders] = m_helper->get<ECS::Shader>(entity);
 
-				m_vertexDataBuffers.insert({ entity, vertexDataBuffer });
-			}
+			RenderObject renderObject{};
+			renderObject.entity = entity;
 
-			if (!m_indexDataBuffers.contains(entity)) {
-				DeviceLocalBuffer<uint32_t> indexDataBuffer{
-					m_device,
-					m_transferCommandPool,
-					indexData.data.data(),
-					indexData.data.size(),
-					VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				};
+			// First, so a pipeline that doesn't fit in a render queue key skips the entity before anything else is acquired.
+			renderObject.pipeline = AcquireGraphicsPipeline(shaders);
+			if (renderObject.pipeline == UINT32_MAX)
+				return;
 
-				m_indexDataBuffers.insert({ entity, indexDataBuffer });
+			if (m_helper->has<ECS::Mesh>(entity)) {
+				auto [mesh] = m_helper->get<ECS::Mesh>(entity);
+				I_ASSERT_FATAL_ERROR(mesh.handle >= m_meshes.size() || m_meshes[mesh.handle].refCount == 0, "IRun::Vk::Renderer::AddEntity failed. Component IRun::ECS::Mesh must hold a handle returned by IRun::Vk::Renderer::CreateMesh!");
+				renderObject.mesh = mesh.handle;
+				m_meshes[mesh.handle].refCount++;
+			}
+			else {
+				// The mesh is only used by this entity, the entity takes over the reference of the handle.
+				auto [vertexData, indexData] = m_helper->get<ECS::VertexData, ECS::IndexData>(entity);
+				renderObject.mesh = CreateMesh(vertexData, indexData);
 			}
 
-			if (!m_graphicsPipelines.contains(shaders)) {
-				GraphicsPipeline graphicsPipeline{
-					shaders.vertexFilename,
-					shaders.fragmentFilename,
-					shaders.language,
-					m_device,
-					m_swapchain,
-					m_renderPass,
-					m_pipelineCache,
-					std::nullopt,
-					std::make_optional(m_descriptorPool.GetDescriptorSetLayout(m_descriptorSets[0])),
-					std::make_optional(m_basePipeline)
-				};
+			renderObject.hasTransform = m_helper->has<ECS::Transform>(entity);
 
-				m_graphicsPipelines.insert({ shaders, graphicsPipeline });
-			}
+			m_renderObjectIndices.insert({ entity, (uint32_t)m_renderObjects.size() });
+			m_renderObjects.push_back(renderObject);
 		}
 
 		void Renderer::RemoveEntity(ECS::Entity entity) {
-			auto [shaders] = m_helper->get<ECS::Shader>(entity);
+			uint32_t index = m_renderObjectIndices.at(entity);
+			RenderObject& renderObject = m_renderObjects[index];
 
-			DeviceLocalBuffer<Vertex>& vertexDataBuffer = m_vertexDataBuffers.at(entity);
-			vertexDataBuffer.Destroy(m_device);
-			m_vertexDataBuffers.erase(entity);
+			ReleaseMesh(renderObject.mesh);
+			ReleaseGraphicsPipeline(renderObject.pipeline);
+
+			// Keep the render objects packed.
+			renderObject = m_renderObjects.back();
+			m_renderObjectIndices[renderObject.entity] = index;
+			m_renderObjects.pop_back();
+			m_renderObjectIndices.erase(entity);
+		}
 
-			DeviceLocalBuffer<uint32_t>& indexDataBuffer = m_indexDataBuffers.at(entity);
-			indexDataBuffer.Destroy(m_device);
-			m_indexDataBuffers.erase(entity);
+		uint32_t Renderer::CreateMesh(const ECS::VertexData& vertexData, const ECS::IndexData& indexData) {
+			return CreateMesh(vertexData.data.data(), (uint32_t)vertexData.data.size(), indexData.data.data(), (uint32_t)indexData.data.size());
+		}
 
-			if (m_graphicsPipelines.count(shaders) == 1) {
-				GraphicsPipeline& graphicsPipeline = m_graphicsPipelines.at(shaders);
-				graphicsPipeline.Destroy(m_device);
-				m_graphicsPipelines.erase(shaders);
+		uint32_t Renderer::CreateMesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+			MeshSlot slot{};
+			slot.refCount = 1;
+			slot.range.vertexCount = vertexCount;
+			slot.range.indexCount = indexCount;
+			slot.range.vertexOffset = (int32_t)m_vertexArena.Allocate(m_device, m_allocator, m_uploadManager, m_deletionQueue, m_frameNumber, vertices, vertexCount);
+			slot.range.firstIndex = (uint32_t)m_indexArena.Allocate(m_device, m_allocator, m_uploadManager, m_deletionQueue, m_frameNumber, indices, indexCount);
+
+			uint32_t mesh;
+			if (!m_freeMeshes.empty()) {
+				mesh = m_freeMeshes.back();
+				m_freeMeshes.pop_back();
+				m_meshes[mesh] = slot;
+			}
+			else {
+				mesh = (uint32_t)m_meshes.size();
+				m_meshes.push_back(slot);
 			}
 
-			for (size_t i = 0; i < m_entities.size(); i++) 
-				if (m_entities[i] == entity) m_entities.erase(m_entities.begin() + i);
+			return mesh;
+		}
+
+		void Renderer::DestroyMesh(uint32_t mesh) {
+			ReleaseMesh(mesh);
+		}
+
+		std::vector<uint32_t> Renderer::CreateGraphicsPipelines(const std::vector<ECS::Shader>& shaders, std::vector<PipelineTiming>* timings) {
+			IRUN_PROFILE_FUNCTION();
+
+			Tools::Timer<Tools::Milliseconds> batchTimer{};
+			batchTimer.Start();
+
+			// Every shader pair without a pipeline is compiled once, even if it is in the list more than once.
+			std::vector<ECS::Shader> newShaders{};
+			std::unordered_map<ECS::Shader, uint32_t, ECS::Shader::HashFn> newShaderIndices{};
+			// Pipelines still compiling in the background are created here as well, so every returned handle is ready.
+			for (const ECS::Shader& shader : shaders) {
+				auto itr = m_graphicsPipelineHandles.find(shader);
+				if ((itr != m_graphicsPipelineHandles.end() && m_graphicsPipelines[itr->second].ready) || newShaderIndices.contains(shader))
+					continue;
+
+				newShaderIndices.insert({ shader, (uint32_t)newShaders.size() });
+				newShaders.push_back(shader);
+			}
+
+			std::vector<GraphicsPipeline> graphicsPipelines(newShaders.size());
+			std::vector<PipelineTiming> newTimings(newShaders.size());
+			VkDescriptorSetLayout descriptorSetLayout = m_descriptorPool.GetDescriptorSetLayout(m_descriptorSets[0]);
+
+			// Every thread creates its pipelines with a cache of its own, they are merged into the main cache when it is saved.
+			RunParallel((uint32_t)newShaders.size(), [&](uint32_t i) {
+				Tools::Timer<Tools::Milliseconds> timer{};
+
+				timer.Start();
+				std::array<std::vector<char>, 2> spirv = GraphicsPipeline::CompileShaders(newShaders[i].vertexFilename, newShaders[i].fragmentFilename, newShaders[i].language);
+				newTimings[i].compileMs = timer.Stop();
+
+				timer.Start();
+				PipelineCache* pipelineCache = m_threadPipelineCaches->Acquire();
+				graphicsPipelines[i] = GraphicsPipeline{ spirv, m_device, m_swapchain, m_renderPass, *pipelineCache, std::nullopt, std::make_optional(descriptorSetLayout), std::make_optional(m_basePipeline) };
+				m_threadPipelineCaches->Release(pipelineCache, true);
+				newTimings[i].createMs = timer.Stop();
+
+				newTimings[i].shaders = newShaders[i];
+			});
+
+			for (size_t i = 0; i < newShaders.size(); i++) {
+				auto itr = m_graphicsPipelineHandles.find(newShaders[i]);
+				if (itr == m_graphicsPipelineHandles.end()) {
+					// No slot left, never used so it can be destroyed right away.
+					if (InsertGraphicsPipeline(newShaders[i], graphicsPipelines[i]) == UINT32_MAX)
+						graphicsPipelines[i].Destroy(m_device);
+
+					continue;
+				}
+
+				// The background compile of this pipeline is destroyed by CollectCompiledPipelines when it finishes.
+				m_graphicsPipelines[itr->second].pipeline = graphicsPipelines[i];
+				m_graphicsPipelines[itr->second].ready = true;
+			}
+
+			std::vector<uint32_t> handles{};
+			for (const ECS::Shader& shader : shaders)
+				handles.push_back(AcquireGraphicsPipeline(shader));
+
+			I_LOG_INFO("Created %zu graphics pipelines in %.3f ms:", newShaders.size(), batchTimer.Stop());
+			for (const PipelineTiming& timing : newTimings)
+				I_LOG_INFO("    %s: compile %.3f ms, create %.3f ms", timing.shaders.ToString().c_str(), timing.compileMs, timing.createMs);
+
+			Tools::SpirvCache::LogStats();
+
+			// Saved in the background instead of waiting for the next interval.
+			if (!newShaders.empty())
+				m_threadPipelineCaches->RequestSave();
+
+			if (timings)
+				*timings = std::move(newTimings);
+
+			return handles;
+		}
+
+		void Renderer::DestroyGraphicsPipeline(uint32_t pipeline) {
+			if (pipeline == UINT32_MAX)
+				return;
+
+			ReleaseGraphicsPipeline(pipeline);
 		}
 
 		void Renderer::ClearColor(Math::Color color) {
@@ -179,37 +383,71 @@ namespace IRun {
 		}
 
 		void Renderer::Draw() {
-			IWindow::Vector2<int32_t> framebufferSize = m_window->GetFramebufferSize();
+			IRUN_PROFILE_FUNCTION();
 
-			if (m_oldFramebufferSize.x != framebufferSize.x || m_oldFramebufferSize.y != framebufferSize.y) {
-				m_framebufferResized = true;
-				m_oldFramebufferSize = framebufferSize;
+#ifdef IRUN_WINDOWED
+			if (!IsHeadless()) {
+				IWindow::Vector2<int32_t> framebufferSize = m_window->GetFramebufferSize();
+
+				if (m_oldFramebufferSize.x != framebufferSize.x || m_oldFramebufferSize.y != framebufferSize.y) {
+					m_framebufferResized = true;
+					m_oldFramebufferSize = framebufferSize;
+				}
 			}
+#endif
+
+			Tools::Timer<Tools::Milliseconds> frameTimer{};
+			frameTimer.Start();
+
+			Tools::Timer<Tools::Milliseconds> waitTimer{};
+			waitTimer.Start();
 
 			std::array<Fence, 1> fencesToWaitFor = {
 				m_drawFences[m_currentFrame].Get()
 			};
 
-			vkWaitForFences(m_device.Get().first, (uint32_t)fencesToWaitFor.size(), fencesToWaitFor.data(), true, UINT64_MAX);
+			{
+				IRUN_PROFILE_SCOPE("Renderer::WaitForFrame");
 
-			uint32_t imageIndex;
-			VkResult res = vkAcquireNextImageKHR(m_device.Get().first, m_swapchain.Get(), UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame].Get(), nullptr, &imageIndex);
-
-			// Recreate swapchain
-			if (res == VK_ERROR_OUT_OF_DATE_KHR || m_framebufferResized) {
-				RecreateSwapchain();
-				return;
+				m_framePacer.Wait(m_framesInFlight);
+				vkWaitForFences(m_device.Get().first, (uint32_t)fencesToWaitFor.size(), fencesToWaitFor.data(), true, UINT64_MAX);
 			}
-			else if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
-				I_LOG_FATAL_ERROR("Failed to acquire swapchain image at index: %u", imageIndex);
+
+			double waitMs = waitTimer.Stop();
+
+			m_gpuProfiler->CollectFrame(m_currentFrame);
+			m_frameTimings.gpuMs = m_gpuProfiler->GetLastMs(m_frameScope);
+
+			RetireResources();
+
+			if (m_shaderHotReload)
+				ReloadChangedShaders();
+
+			CollectCompiledPipelines();
+
+			// Headless frames render to the offscreen image of their frame index.
+			uint32_t imageIndex = m_currentFrame;
+
+			if (!IsHeadless()) {
+				waitTimer.Start();
+				VkResult res = vkAcquireNextImageKHR(m_device.Get().first, m_swapchain.Get(), UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame].Get(), nullptr, &imageIndex);
+				waitMs += waitTimer.Stop();
+
+				// Recreate swapchain
+				if (res == VK_ERROR_OUT_OF_DATE_KHR || m_framebufferResized) {
+					RecreateSwapchain();
+					return;
+				}
+				else if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
+					I_LOG_FATAL_ERROR("Failed to acquire swapchain image at index: %u", imageIndex);
+				}
 			}
 					
 			vkResetFences(m_device.Get().first, (uint32_t)fencesToWaitFor.size(), fencesToWaitFor.data());
 
 			m_mvp.proj = m_camera->GetProjection();
 			m_mvp.view = m_camera->GetView();
-			m_uniformBuffers[imageIndex].SetBufferData(m_device, &m_mvp);
-			m_descriptorPool.WriteBufferToDescriptor(m_device, m_descriptorSets[imageIndex], 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_uniformBuffers[imageIndex].Get(), 0, sizeof(Mvp));
+			m_uniformBuffers[m_currentFrame].SetBufferData(m_device, m_allocator, &m_mvp);
 
 			VkClearValue clearColor{};
 			clearColor.color = { { ((float)m_clearColor.r / 255.0f), (float)(m_clearColor.g / 255.0f), (float)(m_clearColor.b / 255.0f), 1.0f } };
@@ -220,9 +458,11 @@ namespace IRun {
 			m_renderPassBeginInfo.renderArea.extent = m_swapchain.GetChosenSwapchainDetails().first;
 			m_renderPassBeginInfo.framebuffer = m_framebuffers[imageIndex];
 
-			VkCommandBuffer vkCommandBuffer = m_graphicsCommandPool[m_commandBuffers[imageIndex]];
+			VkCommandBuffer vkCommandBuffer = m_graphicsCommandPool[m_commandBuffers[m_currentFrame]];
 
-			if (!m_window->IsKeyDown(IWindow::Key::N)) {
+#ifdef IRUN_WINDOWED
+			if (!IsHeadless() && !m_window->IsKeyDown(IWindow::Key::N)) {
+				waitTimer.Start();
 				Nv::LatencySleep(m_device.Get().first, m_device.GetDeviceProperties(), m_swapchain.Get(), m_nvLatencySleepSemaphore.Get());
 
 				VkSemaphoreWaitInfo nvLatencySleepSemaphoreWaitInfo{};
@@ -241,76 +481,124 @@ namespace IRun {
 				nvLatencySleepSemaphoreWaitInfo.pValues = nvLatencySleepSleepSemaphoreValues.data();
 
 				vkWaitSemaphores(m_device.Get().first, &nvLatencySleepSemaphoreWaitInfo, UINT64_MAX);
+				waitMs += waitTimer.Stop();
 			}
+#endif
 
-			m_graphicsCommandPool.BeginRecordingCommands(m_device, m_commandBuffers[imageIndex]);
+			m_drawStats = {};
 
-			vkCmdBeginRenderPass(vkCommandBuffer, &m_renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+			// There is one descriptor set per frame in flight and one pair of arenas, so both ids are 0 for now.
+			m_renderQueue.Clear();
+			for (uint32_t i = 0; i < (uint32_t)m_renderObjects.size(); i++) {
+				RenderObject& renderObject = m_renderObjects[i];
 
-			for (const ECS::Entity& entity : m_entities) {
-				auto [shaders] = m_helper->get<ECS::Shader>(entity);
+				// The slot of a compiling pipeline holds the base pipeline, so a fallback draw needs nothing else.
+				if (!m_graphicsPipelines[renderObject.pipeline].ready) {
+					renderObject.pipelineWaitFrames++;
+					m_drawStats.pendingPipelineEntities++;
 
-				vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipelines.at(shaders).Get());
+					if (m_pendingPipelineMode == PendingPipelineMode::Skip)
+						continue;
+				}
 
-				VkViewport viewport{};
-				viewport.x = 1.0f;
-				viewport.y = 0.0f;
-				viewport.width = (float)m_swapchain.GetChosenSwapchainDetails().first.width;
-				viewport.height = (float)m_swapchain.GetChosenSwapchainDetails().first.height;
-				viewport.minDepth = 0.0f;
-				viewport.maxDepth = 1.0f;
+				m_renderQueue.Push(RenderQueue::MakeKey(renderObject.pipeline, 0, 0, renderObject.mesh, i));
+			}
 
-				vkCmdSetViewport(vkCommandBuffer, 0, 1, &viewport);
+			m_renderQueue.Sort();
 
-				VkRect2D scissor{};
-				scissor.offset = { 0, 0 };
-				scissor.extent = { m_swapchain.GetChosenSwapchainDetails().first.width, m_swapchain.GetChosenSwapchainDetails().first.height };
+			const std::vector<uint64_t>& keys = m_renderQueue.Get();
 
-				vkCmdSetScissor(vkCommandBuffer, 0, 1, &scissor);
+			// Model matrices are written in one linear pass over the render objects and looked up by index in the vertex shader.
+			if (ReserveHostBuffer(m_device, m_allocator, m_transformBuffers[m_currentFrame], m_renderObjects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+				m_descriptorPool.WriteBufferToDescriptor(m_device, m_descriptorSets[m_currentFrame], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_transformBuffers[m_currentFrame].Get(), 0, VK_WHOLE_SIZE);
 
-				DeviceLocalBuffer<Vertex>& vertexDataBuffer = m_vertexDataBuffers.at(entity);
-				DeviceLocalBuffer<uint32_t>& indexDataBuffer = m_indexDataBuffers.at(entity);
+			glm::mat4* transforms = m_transformBuffers[m_currentFrame].GetMapped();
 
-				std::array<VkBuffer, 1> vertexBuffers = {
-					vertexDataBuffer.Get().Get(),
-				};
+			for (size_t i = 0; i < m_renderObjects.size(); i++) {
+				if (m_renderObjects[i].hasTransform) {
+					auto [transform] = m_helper->get<ECS::Transform>(m_renderObjects[i].entity);
+					transforms[i] = transform.GetModelMatrix();
+				}
+				else {
+					transforms[i] = glm::mat4{ 1.0f };
+				}
+			}
 
-				std::array<VkDeviceSize, 1> offsets = {
-					0
-				};
+			m_transformBuffers[m_currentFrame].Flush(m_device, m_allocator, 0, m_renderObjects.size());
 
-				vkCmdBindVertexBuffers(vkCommandBuffer, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+			// Instances are written in sorted order so every batch reads a contiguous range of instances.
+			ReserveHostBuffer(m_device, m_allocator, m_instanceBuffers[m_currentFrame], keys.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+			InstanceData* instances = m_instanceBuffers[m_currentFrame].GetMapped();
 
-				vkCmdBindIndexBuffer(vkCommandBuffer, indexDataBuffer.Get().Get(), 0, VK_INDEX_TYPE_UINT32);
+			for (size_t i = 0; i < keys.size(); i++)
+				instances[i].transformIndex = RenderQueue::GetIndex(keys[i]);
 
-				std::array<VkDescriptorSet, 1> descriptorSets = {
-					m_descriptorPool.GetDescriptorSet(m_descriptorSets[imageIndex])
-				};
+			m_instanceBuffers[m_currentFrame].Flush(m_device, m_allocator, 0, keys.size());
+
+			m_graphicsCommandPool.BeginRecordingCommands(m_device, m_commandBuffers[m_currentFrame]);
 
-				vkCmdBindDescriptorSets(vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipelines.at(shaders).GetLayout(), 0, (uint32_t)descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+			if (m_gpuDrawProfiling)
+				ResolveDrawScopes();
 
-				vkCmdDrawIndexed(vkCommandBuffer, (uint32_t)indexDataBuffer.Get().GetSize(), 1, 0, 0, 0);
+			m_gpuProfiler->BeginFrame(vkCommandBuffer, m_currentFrame, m_frameNumber);
+			uint32_t frameScope = m_gpuProfiler->BeginScope(vkCommandBuffer, m_currentFrame, m_frameScope);
+			uint32_t renderPassScope = m_gpuProfiler->BeginScope(vkCommandBuffer, m_currentFrame, m_renderPassScope);
+
+			if (m_recordingThreadCount > 1) {
+				vkCmdBeginRenderPass(vkCommandBuffer, &m_renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				RecordDrawsParallel(vkCommandBuffer, m_framebuffers[imageIndex]);
+			}
+			else {
+				vkCmdBeginRenderPass(vkCommandBuffer, &m_renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+				RecordDraws(vkCommandBuffer, 0, keys.size(), m_drawStats);
 			}
 
 			vkCmdEndRenderPass(vkCommandBuffer);
+			// Begin and end render pass.
+			m_drawStats.commands += 2;
+
+			m_gpuProfiler->EndScope(vkCommandBuffer, m_currentFrame, renderPassScope);
+			m_gpuProfiler->EndScope(vkCommandBuffer, m_currentFrame, frameScope);
 
-			m_graphicsCommandPool.EndRecordingCommands(m_commandBuffers[imageIndex]);
+			m_graphicsCommandPool.EndRecordingCommands(m_commandBuffers[m_currentFrame]);
+
+			// Submit every upload enqueued since the last frame (AddEntity etc.) in one batch.
+			uint64_t uploadValue = m_uploadManager.Flush(m_device);
 
 			VkSubmitInfo submitInfo{};
 			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-			std::array<VkSemaphore, 1> submitWaitSemaphores = {
-				m_imageAvailableSemaphores[m_currentFrame].Get()
+			std::array<VkSemaphore, 2> submitWaitSemaphores = {
+				m_imageAvailableSemaphores[m_currentFrame].Get(),
+				m_uploadManager.GetSemaphore()
 			};
 
-			submitInfo.waitSemaphoreCount = (uint32_t)submitWaitSemaphores.size();
-			submitInfo.pWaitSemaphores = submitWaitSemaphores.data();
+			// Headless frames have no image to wait for.
+			uint32_t firstWaitSemaphore = IsHeadless() ? 1 : 0;
+
+			submitInfo.waitSemaphoreCount = (uint32_t)submitWaitSemaphores.size() - firstWaitSemaphore;
+			submitInfo.pWaitSemaphores = submitWaitSemaphores.data() + firstWaitSemaphore;
 
 			VkPipelineStageFlags waitStages[] = {
-				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				// Vertex and index buffers must be uploaded before they are read.
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
 			};
 			// 1:1 with pWaitSemaphores
-			submitInfo.pWaitDstStageMask = waitStages;
+			submitInfo.pWaitDstStageMask = waitStages + firstWaitSemaphore;
+
+			// The value for the binary image available semaphore is ignored.
+			std::array<uint64_t, 2> waitSemaphoreValues = {
+				0,
+				uploadValue
+			};
+
+			VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+			timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineSubmitInfo.waitSemaphoreValueCount = (uint32_t)waitSemaphoreValues.size() - firstWaitSemaphore;
+			timelineSubmitInfo.pWaitSemaphoreValues = waitSemaphoreValues.data() + firstWaitSemaphore;
+
+			submitInfo.pNext = &timelineSubmitInfo;
 
 			submitInfo.commandBufferCount = 1;
 			submitInfo.pCommandBuffers = &vkCommandBuffer;
@@ -319,62 +607,107 @@ namespace IRun {
 				m_renderFinishedSemaphores[m_currentFrame].Get() 
 			};
 
-			submitInfo.signalSemaphoreCount = (uint32_t)submitSignalSemaphores.size();
+			// Nothing waits for a headless frame but its fence.
+			submitInfo.signalSemaphoreCount = IsHeadless() ? 0 : (uint32_t)submitSignalSemaphores.size();
 			submitInfo.pSignalSemaphores = submitSignalSemaphores.data();
 
-			if (Nv::CheckIfVendorNv(m_device.GetDeviceProperties())) {
-				VkLatencySubmissionPresentIdNV latencySubmissionPresentID{};
+			// Must outlive vkQueueSubmit.
+			VkLatencySubmissionPresentIdNV latencySubmissionPresentID{};
+			if (!IsHeadless() && Nv::CheckIfVendorNv(m_device.GetDeviceProperties())) {
 				latencySubmissionPresentID.sType = VK_STRUCTURE_TYPE_LATENCY_SUBMISSION_PRESENT_ID_NV;
 				latencySubmissionPresentID.pNext = nullptr;
 				latencySubmissionPresentID.presentID = imageIndex;
 
-				submitInfo.pNext = &latencySubmissionPresentID;
+				timelineSubmitInfo.pNext = &latencySubmissionPresentID;
 			}
 
 			VK_CHECK(vkQueueSubmit(m_device.GetQueues().at(IRun::Vk::QueueType::Graphics), 1, &submitInfo, fencesToWaitFor[0]), "Failed to sumbit semaphore and command buffer info to graphics queue!");
 
 
-			VkPresentInfoKHR presentInfo{};
-			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-			presentInfo.waitSemaphoreCount = (uint32_t)submitSignalSemaphores.size();
-			presentInfo.pWaitSemaphores = submitSignalSemaphores.data();
+			m_lastImageIndex = imageIndex;
 
-			std::array<VkSwapchainKHR, 1> swapchainsToPresentTo = {
-				m_swapchain.Get()
-			};
+			if (IsHeadless()) {
+				// Nothing is presented, the present interval is the time between submits.
+				m_framePacer.Presented();
+			}
+			else {
+				VkPresentInfoKHR presentInfo{};
+				presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+				presentInfo.waitSemaphoreCount = (uint32_t)submitSignalSemaphores.size();
+				presentInfo.pWaitSemaphores = submitSignalSemaphores.data();
+
+				std::array<VkSwapchainKHR, 1> swapchainsToPresentTo = {
+					m_swapchain.Get()
+				};
+
+				presentInfo.swapchainCount = (uint32_t)swapchainsToPresentTo.size();
+				presentInfo.pSwapchains = swapchainsToPresentTo.data();
 
-			presentInfo.swapchainCount = (uint32_t)swapchainsToPresentTo.size();
-			presentInfo.pSwapchains = swapchainsToPresentTo.data();
+				presentInfo.pImageIndices = &imageIndex;
 
-			presentInfo.pImageIndices = &imageIndex;
+				// Must outlive vkQueuePresentKHR.
+				uint64_t presentId = m_framePacer.NextPresentId();
+				VkPresentIdKHR presentIdInfo{};
+				if (m_framePacer.UsesPresentWait()) {
+					presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+					presentIdInfo.pNext = nullptr;
+					presentIdInfo.swapchainCount = 1;
+					presentIdInfo.pPresentIds = &presentId;
 
-			res = vkQueuePresentKHR(m_device.GetQueues().at(IRun::Vk::QueueType::Presentation), &presentInfo);
+					presentInfo.pNext = &presentIdInfo;
+				}
 
-			if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR)
-				RecreateSwapchain();
-			else
-				VK_CHECK(res, "Failed to present Vulkan swapchain image!");
+				VkResult res = vkQueuePresentKHR(m_device.GetQueues().at(IRun::Vk::QueueType::Presentation), &presentInfo);
 
-			m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+				m_framePacer.Presented();
+
+				if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR)
+					RecreateSwapchain();
+				else
+					VK_CHECK(res, "Failed to present Vulkan swapchain image!");
+			}
+
+			m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+			m_frameNumber++;
+
+			m_frameTimings.waitMs = waitMs;
+			m_frameTimings.cpuMs = frameTimer.Stop() - waitMs;
+			m_frameTimings.presentIntervalMs = m_framePacer.GetPresentIntervalMs();
 
 		}
 
 		void Renderer::Destroy()
 		{
-			m_pipelineCache.SaveCache("shaders/cache/PipelineCache.bin", m_device);
+			// Stop compiling before the pipeline cache is saved and destroyed.
+			std::vector<PipelineCompileQueue::Result> compiledPipelines{};
+			m_pipelineCompileQueue->Destroy(compiledPipelines);
+
+			for (PipelineCompileQueue::Result& result : compiledPipelines)
+				if (result.pipeline.Get() != VK_NULL_HANDLE)
+					result.pipeline.Destroy(m_device);
+
+			m_shaderWatcher.Destroy();
+
+			// Saves the pipeline cache if pipelines were created since the last save.
+			m_threadPipelineCaches->Destroy();
 
 			vkQueueWaitIdle(m_device.GetQueues().at(QueueType::Graphics));
+			m_uploadManager.Destroy(m_device, m_allocator);
 
 			for (Buffer<Mvp>& buffer : m_uniformBuffers) 
-				buffer.Destroy(m_device);
+				buffer.Destroy(m_device, m_allocator);
 
 			m_descriptorPool.Destroy(m_device);
 
-			for (auto& [entity, vertexBuffer] : m_vertexDataBuffers)
-				vertexBuffer.Destroy(m_device);
+			m_deletionQueue.Destroy(m_device, m_allocator);
+
+			for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+				m_instanceBuffers[i].Destroy(m_device, m_allocator);
+				m_transformBuffers[i].Destroy(m_device, m_allocator);
+			}
 
-			for (auto& [entity, indexBuffer] : m_indexDataBuffers)
-				indexBuffer.Destroy(m_device);
+			m_vertexArena.Destroy(m_device, m_allocator);
+			m_indexArena.Destroy(m_device, m_allocator);
 
 			for (Sync<Semaphore>& semaphore : m_imageAvailableSemaphores)
 				semaphore.Destroy(m_device);
@@ -385,35 +718,606 @@ namespace IRun {
 			for (Sync<Fence>& fence : m_drawFences)
 				fence.Destroy(m_device);
 
-			m_transferCommandPool.Destroy(m_device);
+			m_gpuProfiler->Destroy(m_device);
+
+			DestroyRecordingContexts();
 			m_graphicsCommandPool.Destroy(m_device);
 			m_framebuffers.Destroy(m_device);
 
-			for (auto& [shader, graphicsPipeline]: m_graphicsPipelines) 
-				graphicsPipeline.Destroy(m_device);
+			// Slots that aren't ready hold the base pipeline.
+			for (GraphicsPipelineSlot& slot : m_graphicsPipelines)
+				if (slot.refCount > 0 && slot.ready)
+					slot.pipeline.Destroy(m_device);
 			
 			m_basePipeline.Destroy(m_device);
 			m_pipelineCache.Destroy(m_device);
 			m_renderPass.Destroy(m_device);
 			m_swapchain.Destroy(m_device, false);
+			m_allocator.Destroy(m_device);
 			m_device.Destroy();
-			m_surface.Destroy(m_instance);
+
+			if (!IsHeadless())
+				m_surface.Destroy(m_instance);
+
 			m_instance.Destroy();
 		}
 
+		void Renderer::RetireResources() {
+			IRUN_PROFILE_FUNCTION();
+
+			// The fence of the current frame was just waited on, so every frame up to m_framesInFlight frames ago has finished.
+			if (m_frameNumber < m_framesInFlight)
+				return;
+
+			uint64_t completedFrame = m_frameNumber - m_framesInFlight;
+
+			m_deletionQueue.Flush(m_device, m_allocator, completedFrame);
+
+			for (size_t i = 0; i < m_retiredMeshRanges.size();) {
+				auto& [frame, meshRange] = m_retiredMeshRanges[i];
+
+				if (frame > completedFrame) {
+					i++;
+					continue;
+				}
+
+				m_vertexArena.Free((size_t)meshRange.vertexOffset, meshRange.vertexCount);
+				m_indexArena.Free(meshRange.firstIndex, meshRange.indexCount);
+
+				m_retiredMeshRanges[i] = m_retiredMeshRanges.back();
+				m_retiredMeshRanges.pop_back();
+			}
+		}
+
+		uint32_t Renderer::AcquireGraphicsPipeline(const ECS::Shader& shaders) {
+			auto itr = m_graphicsPipelineHandles.find(shaders);
+			if (itr != m_graphicsPipelineHandles.end()) {
+				m_graphicsPipelines[itr->second].refCount++;
+				return itr->second;
+			}
+
+			// Entities use the base pipeline until the pipeline has been compiled in the background and swapped in by CollectCompiledPipelines.
+			uint32_t pipeline = InsertGraphicsPipeline(shaders, m_basePipeline);
+			if (pipeline == UINT32_MAX)
+				return UINT32_MAX;
+
+			m_graphicsPipelines[pipeline].ready = false;
+			m_graphicsPipelines[pipeline].refCount++;
+
+			QueueGraphicsPipelineCompile(shaders, true);
+
+			return pipeline;
+		}
+
+		uint32_t Renderer::InsertGraphicsPipeline(const ECS::Shader& shaders, const GraphicsPipeline& graphicsPipeline) {
+			GraphicsPipelineSlot slot{};
+			slot.shaders = shaders;
+			slot.pipeline = graphicsPipeline;
+			// The caller takes the first reference.
+			slot.refCount = 0;
+			slot.ready = true;
+			slot.requestFrame = m_frameNumber;
+			slot.pendingReloads = 0;
+
+			// The slot index has to fit in a render queue key.
+			if (m_freeGraphicsPipelines.empty() && m_graphicsPipelines.size() >= (1ull << RenderQueue::PIPELINE_BITS)) {
+				I_LOG_ERROR("IRun::Vk::Renderer failed to create the pipeline of %s. The renderer can't hold more than %llu pipelines!", shaders.ToString().c_str(), 1ull << RenderQueue::PIPELINE_BITS);
+				return UINT32_MAX;
+			}
+
+			uint32_t pipeline;
+			if (!m_freeGraphicsPipelines.empty()) {
+				pipeline = m_freeGraphicsPipelines.back();
+				m_freeGraphicsPipelines.pop_back();
+				m_graphicsPipelines[pipeline] = slot;
+			}
+			else {
+				pipeline = (uint32_t)m_graphicsPipelines.size();
+				m_graphicsPipelines.push_back(slot);
+			}
+
+			m_graphicsPipelineHandles.insert({ shaders, pipeline });
+
+			m_shaderWatcher.Watch(shaders.vertexFilename);
+			m_shaderWatcher.Watch(shaders.fragmentFilename);
+
+			return pipeline;
+		}
+
+		void Renderer::ReleaseGraphicsPipeline(uint32_t pipeline) {
+			GraphicsPipelineSlot& slot = m_graphicsPipelines[pipeline];
+
+			if (--slot.refCount > 0)
+				return;
+
+			m_graphicsPipelineHandles.erase(slot.shaders);
+			m_freeGraphicsPipelines.push_back(pipeline);
+			m_drawScopes.clear();
+
+			// Still compiling, the pipeline is destroyed by CollectCompiledPipelines when it finishes.
+			if (!slot.ready)
+				return;
+
+			// Frames in flight may still be using the pipeline.
+			m_deletionQueue.Push(m_frameNumber, [graphicsPipeline = slot.pipeline](Device& device, Allocator& allocator) mutable {
+				graphicsPipeline.Destroy(device);
+			});
+		}
+
+		void Renderer::QueueGraphicsPipelineCompile(const ECS::Shader& shaders, bool exitOnError) {
+			// Everything is captured by value, the compile thread must not touch the renderer.
+			m_pipelineCompileQueue->Push(shaders, [
+				shaders,
+				exitOnError,
+				device = m_device,
+				swapchain = m_swapchain,
+				renderPass = m_renderPass,
+				// Owned by the renderer through a pointer, so it stays where it is if the renderer is moved.
+				threadPipelineCaches = m_threadPipelineCaches.get(),
+				descriptorSetLayout = m_descriptorPool.GetDescriptorSetLayout(m_descriptorSets[0]),
+				basePipeline = m_basePipeline
+			]() mutable {
+				std::array<std::vector<char>, 2> spirv = GraphicsPipeline::CompileShaders(shaders.vertexFilename, shaders.fragmentFilename, shaders.language, exitOnError);
+
+				// Only possible without exitOnError. The empty pipeline tells CollectCompiledPipelines to keep the previous one.
+				if (spirv[0].empty() || spirv[1].empty())
+					return GraphicsPipeline{};
+
+				PipelineCache* pipelineCache = threadPipelineCaches->Acquire();
+
+				GraphicsPipeline graphicsPipeline{
+					spirv,
+					device,
+					swapchain,
+					renderPass,
+					*pipelineCache,
+					std::nullopt,
+					std::make_optional(descriptorSetLayout),
+					std::make_optional(basePipeline)
+				};
+
+				threadPipelineCaches->Release(pipelineCache, true);
+
+				return graphicsPipeline;
+			});
+		}
+
+		void Renderer::CollectCompiledPipelines() {
+			IRUN_PROFILE_FUNCTION();
+
+			std::vector<PipelineCompileQueue::Result> compiledPipelines{};
+			m_pipelineCompileQueue->PopFinished(compiledPipelines);
+
+			for (PipelineCompileQueue::Result& result : compiledPipelines) {
+				auto itr = m_graphicsPipelineHandles.find(result.shaders);
+				GraphicsPipelineSlot* slot = itr == m_graphicsPipelineHandles.end() ? nullptr : &m_graphicsPipelines[itr->second];
+
+				// Compiles finish in the order they were queued, so the last reload of a slot is always swapped in last.
+				bool reload = slot && slot->ready && slot->pendingReloads > 0;
+				if (reload)
+					slot->pendingReloads--;
+
+				if (result.pipeline.Get() == VK_NULL_HANDLE) {
+					I_LOG_ERROR("Failed to rebuild graphics pipeline %s, the previous pipeline is kept.", result.shaders.ToString().c_str());
+					continue;
+				}
+
+				// Every entity using it was removed, or CreateGraphicsPipelines created it first. The Gpu never used it.
+				if (!slot || (slot->ready && !reload)) {
+					result.pipeline.Destroy(m_device);
+					continue;
+				}
+
+				if (reload) {
+					// Frames in flight may still be drawing with the old pipeline.
+					m_deletionQueue.Push(m_frameNumber, [graphicsPipeline = slot->pipeline](Device& device, Allocator& allocator) mutable {
+						graphicsPipeline.Destroy(device);
+					});
+
+					slot->pipeline = result.pipeline;
+
+					I_LOG_INFO("Reloaded graphics pipeline %s in %.3f ms", result.shaders.ToString().c_str(), result.compileMs);
+					continue;
+				}
+
+				// Swapped in before the render queue is built, so every draw of this frame uses the new pipeline.
+				slot->pipeline = result.pipeline;
+				slot->ready = true;
+
+				I_LOG_INFO("Graphics pipeline %s ready after %llu frames, compiled in %.3f ms", result.shaders.ToString().c_str(), (unsigned long long)(m_frameNumber - slot->requestFrame), result.compileMs);
+			}
+		}
+
+		void Renderer::ReloadChangedShaders() {
+			IRUN_PROFILE_FUNCTION();
+
+			std::vector<std::string> changedFiles = m_shaderWatcher.Poll();
+			if (changedFiles.empty())
+				return;
+
+			for (const std::string& file : changedFiles)
+				I_LOG_INFO("Shader changed: %s", file.c_str());
+
+			// Only pipelines using a changed file are rebuilt, and the spirv cache returns the unchanged stage without compiling it.
+			for (auto& [shaders, pipeline] : m_graphicsPipelineHandles) {
+				bool changed = std::find_if(changedFiles.begin(), changedFiles.end(), [&shaders](const std::string& file) {
+					return file == shaders.vertexFilename || file == shaders.fragmentFilename;
+				}) != changedFiles.end();
+
+				if (!changed)
+					continue;
+
+				m_graphicsPipelines[pipeline].pendingReloads++;
+				QueueGraphicsPipelineCompile(shaders, false);
+			}
+		}
+
+		void Renderer::ReleaseMesh(uint32_t mesh) {
+			MeshSlot& slot = m_meshes[mesh];
+
+			if (--slot.refCount > 0)
+				return;
+
+			// Frames in flight may still be drawing the mesh and its upload may still be pending, 
+			// so the ranges are only reused once the next frame (which waits for pending uploads) has finished.
+			m_retiredMeshRanges.push_back({ m_frameNumber, slot.range });
+			m_freeMeshes.push_back(mesh);
+		}
+
+		void Renderer::ResolveDrawScopes() {
+			IRUN_PROFILE_FUNCTION();
+
+			const std::vector<uint64_t>& keys = m_renderQueue.Get();
+
+			// Once per batch, and the scope names are only built the first time a pair is drawn.
+			for (size_t i = 0; i < keys.size(); i++) {
+				if (i > 0 && RenderQueue::GetBatch(keys[i]) == RenderQueue::GetBatch(keys[i - 1]))
+					continue;
+
+				uint32_t pipeline = RenderQueue::GetPipeline(keys[i]), mesh = RenderQueue::GetMesh(keys[i]);
+				uint64_t drawKey = (uint64_t)pipeline << 32 | mesh;
+
+				if (m_drawScopes.contains(drawKey))
+					continue;
+
+				const ECS::Shader& shaders = m_graphicsPipelines[pipeline].shaders;
+				m_drawScopes[drawKey] = m_gpuProfiler->GetScopeId("Draw " + shaders.vertexFilename + " " + shaders.fragmentFilename + " mesh " + std::to_string(mesh));
+			}
+		}
+
+		void Renderer::RecordDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end, DrawStats& stats) {
+			IRUN_PROFILE_FUNCTION();
+
+			const std::vector<uint64_t>& keys = m_renderQueue.Get();
+
+			// Viewport and scissor are dynamic state of every pipeline, so they stay set across pipeline binds.
+			// Secondary command buffers don't inherit them, so every command buffer sets them.
+			VkViewport viewport{};
+			viewport.x = 1.0f;
+			viewport.y = 0.0f;
+			viewport.width = (float)m_swapchain.GetChosenSwapchainDetails().first.width;
+			viewport.height = (float)m_swapchain.GetChosenSwapchainDetails().first.height;
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+			VkRect2D scissor{};
+			scissor.offset = { 0, 0 };
+			scissor.extent = { m_swapchain.GetChosenSwapchainDetails().first.width, m_swapchain.GetChosenSwapchainDetails().first.height };
+
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+			stats.commands += 2;
+
+			uint32_t boundPipeline = UINT32_MAX, boundDescriptorSet = UINT32_MAX, boundBuffer = UINT32_MAX;
+
+			for (size_t first = begin; first < end;) {
+				uint64_t key = keys[first];
+
+				// Every draw with the same pipeline, descriptor set, buffers and mesh is one instanced draw.
+				size_t last = first + 1;
+				while (last < end && RenderQueue::GetBatch(keys[last]) == RenderQueue::GetBatch(key))
+					last++;
+
+				// Keys are sorted so state only changes between runs of equal fields.
+				if (RenderQueue::GetPipeline(key) != boundPipeline) {
+					boundPipeline = RenderQueue::GetPipeline(key);
+					vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipelines[boundPipeline].pipeline.Get());
+					stats.pipelineBinds++;
+					stats.commands++;
+				}
+
+				// Every pipeline is created with the same descriptor set layout so the set stays bound across pipeline binds.
+				if (RenderQueue::GetDescriptorSet(key) != boundDescriptorSet) {
+					boundDescriptorSet = RenderQueue::GetDescriptorSet(key);
+
+					std::array<VkDescriptorSet, 1> descriptorSets = {
+						m_descriptorPool.GetDescriptorSet(m_descriptorSets[m_currentFrame])
+					};
+
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipelines[boundPipeline].pipeline.GetLayout(), 0, (uint32_t)descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+					stats.descriptorSetBinds++;
+					stats.commands++;
+				}
+
+				// Every mesh lives in the arenas, meshes are selected with firstIndex and vertexOffset.
+				if (RenderQueue::GetBuffer(key) != boundBuffer) {
+					boundBuffer = RenderQueue::GetBuffer(key);
+
+					std::array<VkBuffer, 2> vertexBuffers = {
+						m_vertexArena.Get().Get(),
+						m_instanceBuffers[m_currentFrame].Get()
+					};
+
+					std::array<VkDeviceSize, 2> offsets = {
+						0,
+						0
+					};
+
+					vkCmdBindVertexBuffers(commandBuffer, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+
+					vkCmdBindIndexBuffer(commandBuffer, m_indexArena.Get().Get(), 0, VK_INDEX_TYPE_UINT32);
+					stats.bufferBinds++;
+					stats.commands += 2;
+				}
+
+				const MeshRange& mesh = m_meshes[RenderQueue::GetMesh(key)].range;
+
+				uint32_t drawScope = UINT32_MAX;
+				if (m_gpuDrawProfiling) {
+					uint32_t scopeId = m_drawScopes.find((uint64_t)boundPipeline << 32 | RenderQueue::GetMesh(key))->second;
+					drawScope = m_gpuProfiler->BeginScope(commandBuffer, m_currentFrame, scopeId);
+				}
+
+				vkCmdDrawIndexed(commandBuffer, mesh.indexCount, (uint32_t)(last - first), mesh.firstIndex, mesh.vertexOffset, (uint32_t)first);
+
+				m_gpuProfiler->EndScope(commandBuffer, m_currentFrame, drawScope);
+				stats.drawCalls++;
+				stats.instances += (uint32_t)(last - first);
+				stats.commands++;
+
+				first = last;
+			}
+
+		}
+
+		void Renderer::RecordDrawsParallel(VkCommandBuffer primaryCommandBuffer, VkFramebuffer framebuffer) {
+			IRUN_PROFILE_FUNCTION();
+
+			const std::vector<uint64_t>& keys = m_renderQueue.Get();
+			uint32_t threadCount = m_recordingThreadCount;
+
+			// Split the sorted draws into one chunk per thread. Chunks end on batch boundaries so no instanced draw is split in two.
+			std::vector<size_t> chunkBegins(threadCount + 1);
+			size_t chunkSize = (keys.size() + threadCount - 1) / threadCount;
+			chunkBegins[0] = 0;
+			for (uint32_t i = 1; i < threadCount; i++) {
+				size_t chunkBegin = std::max(chunkBegins[i - 1], std::min(keys.size(), chunkSize * i));
+				while (chunkBegin > 0 && chunkBegin < keys.size() && RenderQueue::GetBatch(keys[chunkBegin]) == RenderQueue::GetBatch(keys[chunkBegin - 1]))
+					chunkBegin++;
+				chunkBegins[i] = chunkBegin;
+			}
+			chunkBegins[threadCount] = keys.size();
+
+			VkCommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = m_renderPass.Get();
+			inheritanceInfo.subpass = 0;
+			inheritanceInfo.framebuffer = framebuffer;
+
+			std::vector<DrawStats> threadStats(threadCount);
+
+			// Each thread records into its own command pool so no pool is used by two threads at once.
+			auto recordChunk = [this, threadCount, &chunkBegins, &inheritanceInfo, &threadStats](uint32_t thread) {
+				RecordingContext& context = m_recordingContexts[m_currentFrame * threadCount + thread];
+
+				context.commandPool.Reset(m_device);
+				context.commandPool.BeginRecordingCommands(m_device, context.commandBuffer, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, inheritanceInfo);
+				RecordDraws(context.commandPool[context.commandBuffer], chunkBegins[thread], chunkBegins[thread + 1], threadStats[thread]);
+				context.commandPool.EndRecordingCommands(context.commandBuffer);
+			};
+
+			RunParallel(threadCount, recordChunk);
+
+			std::vector<VkCommandBuffer> secondaryCommandBuffers{};
+			for (uint32_t i = 0; i < threadCount; i++) {
+				RecordingContext& context = m_recordingContexts[m_currentFrame * threadCount + i];
+				secondaryCommandBuffers.push_back(context.commandPool[context.commandBuffer]);
+
+				m_drawStats.drawCalls += threadStats[i].drawCalls;
+				m_drawStats.instances += threadStats[i].instances;
+				m_drawStats.pipelineBinds += threadStats[i].pipelineBinds;
+				m_drawStats.descriptorSetBinds += threadStats[i].descriptorSetBinds;
+				m_drawStats.bufferBinds += threadStats[i].bufferBinds;
+				m_drawStats.commands += threadStats[i].commands;
+			}
+
+			vkCmdExecuteCommands(primaryCommandBuffer, (uint32_t)secondaryCommandBuffers.size(), secondaryCommandBuffers.data());
+			m_drawStats.commands++;
+		}
+
+		void Renderer::SetRecordingThreadCount(uint32_t threadCount) {
+			threadCount = std::max(threadCount, 1u);
+
+			if (threadCount == m_recordingThreadCount)
+				return;
+
+			// The command pools of every frame in flight are recreated.
+			vkQueueWaitIdle(m_device.GetQueues().at(QueueType::Graphics));
+
+			DestroyRecordingContexts();
+			m_recordingThreadCount = threadCount;
+			CreateRecordingContexts();
+		}
+
+		void Renderer::SetFramesInFlight(uint32_t framesInFlight) {
+			framesInFlight = std::clamp(framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+
+			if (framesInFlight == m_framesInFlight)
+				return;
+
+			// Every frame must have finished so no frame is still using the resources of a frame index that changes meaning.
+			vkDeviceWaitIdle(m_device.Get().first);
+
+			for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+				m_gpuProfiler->CollectFrame(i);
+
+			m_framesInFlight = framesInFlight;
+			m_currentFrame = 0;
+		}
+
+		void Renderer::SetSwapchainImageCount(uint32_t imageCount) {
+			// A headless renderer always has an image per frame in flight.
+			if (imageCount == m_swapchainImageCount || IsHeadless())
+				return;
+
+			m_swapchainImageCount = imageCount;
+			RecreateSwapchain();
+		}
+
+		std::vector<uint8_t> Renderer::ReadFrame() {
+			IRUN_PROFILE_FUNCTION();
+
+			I_ASSERT_FATAL_ERROR(!IsHeadless(), "IRun::Vk::Renderer::ReadFrame failed. Only a headless renderer can read back frames!");
+
+			if (m_lastImageIndex == UINT32_MAX)
+				return {};
+
+			VkExtent2D extent = m_swapchain.GetChosenSwapchainDetails().first;
+			size_t size = (size_t)extent.width * extent.height * 4;
+
+			// Host coherent, so the copy is visible through the mapping without invalidating it.
+			Buffer<uint8_t> readbackBuffer{ m_device, m_allocator, nullptr, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, BufferFlags::PersistentMap };
+
+			CommandBuffer commandBuffer = m_graphicsCommandPool.CreateBuffer(m_device, CommandBufferLevel::Primary);
+			VkCommandBuffer vkCommandBuffer = m_graphicsCommandPool[commandBuffer];
+
+			m_graphicsCommandPool.BeginRecordingCommands(m_device, commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+			// The render pass left the image in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, and its external dependency orders the copy after the frame's writes.
+			VkBufferImageCopy region{};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = 0;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { extent.width, extent.height, 1 };
+
+			vkCmdCopyImageToBuffer(vkCommandBuffer, m_swapchain.GetSwapchainImages()[m_lastImageIndex].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.Get(), 1, &region);
+
+			VkMemoryBarrier hostReadBarrier{};
+			hostReadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			hostReadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			hostReadBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+			vkCmdPipelineBarrier(vkCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostReadBarrier, 0, nullptr, 0, nullptr);
+
+			m_graphicsCommandPool.EndRecordingCommands(commandBuffer);
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &vkCommandBuffer;
+
+			Sync<Fence> readbackFence{ m_device };
+			Fence fence = readbackFence.Get();
+
+			VK_CHECK(vkQueueSubmit(m_device.GetQueues().at(QueueType::Graphics), 1, &submitInfo, fence), "Failed to submit frame readback to graphics queue!");
+			vkWaitForFences(m_device.Get().first, 1, &fence, VK_TRUE, UINT64_MAX);
+
+			const uint8_t* mapped = readbackBuffer.GetMapped();
+			std::vector<uint8_t> pixels{ mapped, mapped + size };
+
+			readbackFence.Destroy(m_device);
+			m_graphicsCommandPool.DestroyCommandBuffer(m_device, commandBuffer);
+			readbackBuffer.Destroy(m_device, m_allocator);
+
+			return pixels;
+		}
+
+		bool Renderer::SaveFrame(const std::string& filename) {
+			std::vector<uint8_t> pixels = ReadFrame();
+
+			if (pixels.empty()) {
+				I_LOG_ERROR("IRun::Vk::Renderer::SaveFrame failed. No frame has been drawn yet!");
+				return false;
+			}
+
+			VkExtent2D extent = m_swapchain.GetChosenSwapchainDetails().first;
+
+			return Tools::WritePng(filename, extent.width, extent.height, pixels.data());
+		}
+
+		void Renderer::Resize(uint32_t width, uint32_t height) {
+			I_ASSERT_FATAL_ERROR(!IsHeadless(), "IRun::Vk::Renderer::Resize failed. Only a headless renderer can be resized, a window resizes its swapchain!");
+
+			m_headlessExtent = { width, height };
+			RecreateSwapchain();
+		}
+
+		void Renderer::RunParallel(uint32_t taskCount, const std::function<void(uint32_t task)>& task) {
+			if (taskCount == 0)
+				return;
+
+			// The calling thread runs the first task instead of waiting.
+			if (m_jobSystem) {
+				Tools::JobCounter counter = 0;
+				for (uint32_t i = 1; i < taskCount; i++)
+					m_jobSystem->Run([&task, i]() { task(i); }, &counter);
+
+				task(0);
+				m_jobSystem->Wait(counter);
+			}
+			else {
+				std::vector<std::future<void>> workers{};
+				for (uint32_t i = 1; i < taskCount; i++)
+					workers.push_back(std::async(std::launch::async, task, i));
+
+				task(0);
+
+				for (std::future<void>& worker : workers)
+					worker.get();
+			}
+		}
+
+		void Renderer::CreateRecordingContexts() {
+			if (m_recordingThreadCount <= 1)
+				return;
+
+			m_recordingContexts.resize(MAX_FRAMES_IN_FLIGHT * m_recordingThreadCount);
+
+			for (RecordingContext& context : m_recordingContexts) {
+				// The pool is reset as a whole every frame, individual command buffers are never reset.
+				context.commandPool = CommandPool{ m_device, m_device.GetQueueFamilies().graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT };
+				context.commandBuffer = context.commandPool.CreateBuffer(m_device, CommandBufferLevel::Secondary);
+			}
+		}
+
+		void Renderer::DestroyRecordingContexts() {
+			for (RecordingContext& context : m_recordingContexts)
+				context.commandPool.Destroy(m_device);
+
+			m_recordingContexts.clear();
+		}
+
 		void Renderer::RecreateSwapchain() {
 			m_framebufferResized = false;
-			IWindow::Vector2<int32_t> size = m_window->GetFramebufferSize();
 
-			while (size.x == 0 || size.y == 0) {
-				m_window->WaitForEvent();
+#ifdef IRUN_WINDOWED
+			if (!IsHeadless()) {
+				IWindow::Vector2<int32_t> size = m_window->GetFramebufferSize();
+
+				while (size.x == 0 || size.y == 0) {
+					m_window->WaitForEvent();
 
-				size = m_window->GetWindowSize();
+					size = m_window->GetWindowSize();
+				}
 			}
+#endif
 
 			vkDeviceWaitIdle(m_device.Get().first);
 
-			m_device.ResetSwapchainDetails(m_surface);
+			if (!IsHeadless())
+				m_device.ResetSwapchainDetails(m_surface);
 
 			for (Sync<Semaphore>& semaphore : m_imageAvailableSemaphores)
 				semaphore.Destroy(m_device);
@@ -424,9 +1328,20 @@ namespace IRun {
 			for (Sync<Fence>& fence : m_drawFences)
 				fence.Destroy(m_device);
 
-			m_oldSwapchain = m_swapchain;
-			m_swapchain = Swapchain{ m_vSync, *m_window, m_surface, m_device, &m_oldSwapchain };
-			m_oldSwapchain.Destroy(m_device, false);
+			if (IsHeadless()) {
+				// The images are new, there is no frame to read back until the next one is drawn.
+				m_swapchain.Destroy(m_device, false);
+				m_swapchain = Swapchain{ m_headlessExtent, OFFSCREEN_FORMAT, MAX_FRAMES_IN_FLIGHT, m_device };
+				m_lastImageIndex = UINT32_MAX;
+			}
+#ifdef IRUN_WINDOWED
+			else {
+				m_oldSwapchain = m_swapchain;
+				m_swapchain = Swapchain{ m_vSync, m_swapchainImageCount, *m_window, m_surface, m_device, &m_oldSwapchain };
+				m_oldSwapchain.Destroy(m_device, false);
+			}
+#endif
+			m_framePacer.SetSwapchain(m_swapchain.Get());
 			m_framebuffers.Destroy(m_device);
 			m_framebuffers = Framebuffers{ m_swapchain, m_renderPass, m_device };
 
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "Core.h"
+
+#ifdef IRUN_WINDOWED
 #include <IWindow.h>
+#endif
 
 #include "Instance.h"
 #include "Surface.h"
@@ -11,29 +15,94 @@
 #include "Framebuffers.h"
 #include "CommandPool.h"
 #include "Sync.h"
-#include "DeviceLocalBuffer.h"
+#include "BufferArena.h"
+#include "DeletionQueue.h"
+#include "UploadManager.h"
+#include "PipelineCompileQueue.h"
+#include "ThreadPipelineCaches.h"
+#include "FramePacer.h"
+#include "GpuProfiler.h"
 #include "DescriptorPool.h"
+#include "Allocator.h"
 #include "nvidia/LowLatencyMode.h"
 #include "renderer/camera/ICamera.h"
+#include "renderer/RenderQueue.h"
 
 #include "ecs/Components.h"
 
 #include "tools/Timer.h"
+#include "tools/Profiler.h"
+#include "tools/JobSystem.h"
+#include "tools/SpirvCache.h"
+#include "tools/FileWatcher.h"
 
 #include <unordered_map>
 #include <mutex>
 #include <future>
+#include <memory>
 
 
 
 namespace IRun {
 	namespace Vk {
+		/// <summary>
+		/// Number of draw calls and state changes recorded in a frame.
+		/// </summary>
+		struct DrawStats {
+			uint32_t drawCalls = 0;
+			uint32_t instances = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t descriptorSetBinds = 0;
+			uint32_t bufferBinds = 0;
+			// Entities drawn with the base pipeline or skipped because their own pipeline is still compiling.
+			uint32_t pendingPipelineEntities = 0;
+			// vkCmd* calls recorded by Renderer::Draw, without the timestamps of the Gpu profiler.
+			uint32_t commands = 0;
+		};
+
+		/// <summary>
+		/// How long a frame took on the Cpu, on the Gpu and on screen.
+		/// </summary>
+		struct FrameTimings {
+			// Time Renderer::Draw spent recording and submitting, without the time blocked on the frame pacer, fences and image acquisition.
+			double cpuMs = 0.0;
+			// The "Frame" scope of the Gpu profiler. Read without stalling, so it is of the frame
+			// Renderer::GetFramesInFlight frames before the last one. 0 if the graphics queue has no timestamps.
+			double gpuMs = 0.0;
+			// Time between the last two presents, see IRun::Vk::FramePacer::GetPresentIntervalMs.
+			double presentIntervalMs = 0.0;
+			// Time Renderer::Draw was blocked on the frame pacer, fences and image acquisition.
+			double waitMs = 0.0;
+		};
+
+		/// <summary>
+		/// What to do with an entity whose graphics pipeline is still being compiled in the background.
+		/// </summary>
+		enum struct PendingPipelineMode {
+			// Draw it with the base pipeline (shaders/Vert.hlsl and shaders/Frag.hlsl).
+			Fallback,
+			// Don't draw it.
+			Skip
+		};
+
+		/// <summary>
+		/// How long creating one graphics pipeline took.
+		/// </summary>
+		struct PipelineTiming {
+			ECS::Shader shaders;
+			// Hlsl to spirv compilation, or reading the spirv files.
+			double compileMs = 0.0;
+			// vkCreateShaderModule, vkCreatePipelineLayout and vkCreateGraphicsPipelines.
+			double createMs = 0.0;
+		};
+
 		/// <summary>
 		/// Create renderer using the Vulkan graphics API.
 		/// </summary>
 		class Renderer {
 		public:
 			Renderer() = default;
+#ifdef IRUN_WINDOWED
 			/// <summary>
 			/// Init renderer.
 			/// </summary>
@@ -41,12 +110,27 @@ namespace IRun {
 			/// <param name="helper">A valid IRun::ECS::Helper.</param>
 			/// <param name="vSync">If set to true the framerate of the application will be locked to the monitors refresh rate. Fixes screen tearing but may cause input lag.</param>
 			Renderer(IWindow::Window& window, ICamera& camera, ECS::Helper& helper, bool vSync);
+#endif
+			/// <summary>
+			/// Init a headless renderer, which renders into offscreen images instead of a window and presents nothing.
+			/// Needs no display, no surface and no VK_KHR_swapchain, so it runs on software implementations like lavapipe.
+			/// The only renderer where IRUN_WINDOWED isn't defined, see Core.h.
+			/// Read the frames back with Renderer::ReadFrame or Renderer::SaveFrame.
+			/// </summary>
+			/// <param name="helper">A valid IRun::ECS::Helper.</param>
+			/// <param name="width">Width of the rendered frames in pixels.</param>
+			/// <param name="height">Height of the rendered frames in pixels.</param>
+			Renderer(ICamera& camera, ECS::Helper& helper, uint32_t width, uint32_t height);
 			/// <summary>
 			/// Add an entity that is to be rendered.
 			/// </summary>
 			/// <param name="entity">
 			/// An IRun::ECS::Entity that is created by the IRun::ECS::Helper passed into the constructor.
-			/// This entity must have components IRun::ECS::VertexData and IRun::ECS::Shader.
+			/// This entity must have components IRun::ECS::Shader and either IRun::ECS::Mesh or IRun::ECS::VertexData and IRun::ECS::IndexData.
+			/// If the shader pair has no pipeline yet it is compiled in the background, see Renderer::SetPendingPipelineMode.
+			/// If the entity has an IRun::ECS::Transform component it is used as the model matrix of the entity.
+			/// The vertex and index data is uploaded in the background, this function does not wait for the Gpu.
+			/// The entity is skipped with a logged error if the renderer is full, its index, mesh and pipeline must fit in a render queue key.
 			/// </param>
 			void AddEntity(ECS::Entity entity);
 			/// <summary>
@@ -55,12 +139,141 @@ namespace IRun {
 			/// <param name="entity">Entity to be removed.</param>
 			void RemoveEntity(ECS::Entity entity);
 			/// <summary>
+			/// Upload a mesh that can be shared by many entities through the IRun::ECS::Mesh component.
+			/// Entities with the same mesh and shader are drawn with one instanced draw call.
+			/// </summary>
+			/// <param name="vertexData">Vertex data of the mesh. Can be freed once this function returns.</param>
+			/// <param name="indexData">Index data of the mesh. Can be freed once this function returns.</param>
+			/// <returns>Handle to the mesh, to be put in IRun::ECS::Mesh::handle.</returns>
+			uint32_t CreateMesh(const ECS::VertexData& vertexData, const ECS::IndexData& indexData);
+			/// <summary>
+			/// Upload a mesh from raw arrays, for example a mesh of a mapped IRun::Tools::AssetPack. The data is copied straight into
+			/// the staging buffer, so a mapped file is read once by the OS and never copied into vectors.
+			/// </summary>
+			/// <param name="vertices">Can be freed (or unmapped) once this function returns.</param>
+			/// <param name="indices">Can be freed (or unmapped) once this function returns.</param>
+			/// <returns>Handle to the mesh, to be put in IRun::ECS::Mesh::handle.</returns>
+			uint32_t CreateMesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+			/// <summary>
+			/// Release a mesh created with Renderer::CreateMesh. The mesh is destroyed once no entities use it anymore.
+			/// </summary>
+			/// <param name="mesh">Handle returned by Renderer::CreateMesh.</param>
+			void DestroyMesh(uint32_t mesh);
+			/// <summary>
+			/// Create the graphics pipelines of many shader pairs at once, so AddEntity doesn't have to compile them one at a time.
+			/// Shaders are compiled and pipelines are created in parallel on the job system (or std::async if none is set) against the shared pipeline cache.
+			/// Shader pairs that already have a pipeline are not compiled again.
+			/// </summary>
+			/// <param name="shaders">Shader pairs to create pipelines for. Can contain duplicates.</param>
+			/// <param name="timings">If not nullptr, set to the timings of every pipeline that was created.</param>
+			/// <returns>
+			/// A handle per shader pair that keeps its pipeline alive until it is passed to Renderer::DestroyGraphicsPipeline.
+			/// UINT32_MAX for a shader pair that didn't get a pipeline because the renderer already holds as many as a render queue key can address.
+			/// </returns>
+			std::vector<uint32_t> CreateGraphicsPipelines(const std::vector<ECS::Shader>& shaders, std::vector<PipelineTiming>* timings = nullptr);
+			/// <summary>
+			/// Release a pipeline created with Renderer::CreateGraphicsPipelines. The pipeline is destroyed once no entities use it anymore.
+			/// </summary>
+			/// <param name="pipeline">Handle returned by Renderer::CreateGraphicsPipelines. UINT32_MAX is ignored.</param>
+			void DestroyGraphicsPipeline(uint32_t pipeline);
+			/// <summary>
 			/// What colour to clear the background of the window to.
 			/// </summary>
 			/// <param name="color">Must be a valid IRun::Math::Color.</param>
 			void ClearColor(Math::Color color);
 
 			void VSync(bool vSync);
+			/// <summary>
+			/// Record draws on threadCount threads, each into its own secondary command buffer, which are executed by the primary command buffer.
+			/// With 1 thread every draw is recorded straight into the primary command buffer. Waits for the Gpu to be idle.
+			/// </summary>
+			/// <param name="threadCount">Number of threads including the thread calling Renderer::Draw. 0 is treated as 1.</param>
+			void SetRecordingThreadCount(uint32_t threadCount);
+			/// <returns>Number of threads draws are recorded on.</returns>
+			inline uint32_t GetRecordingThreadCount() const { return m_recordingThreadCount; }
+			/// <summary>
+			/// Record draws as jobs of jobSystem instead of on threads started every frame.
+			/// </summary>
+			/// <param name="jobSystem">A created IRun::Tools::JobSystem that outlives the renderer, or nullptr to use std::async.</param>
+			inline void SetJobSystem(Tools::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+			/// <summary>
+			/// Set what is drawn for entities whose pipeline is still compiling. Defaults to PendingPipelineMode::Fallback.
+			/// </summary>
+			inline void SetPendingPipelineMode(PendingPipelineMode mode) { m_pendingPipelineMode = mode; }
+			/// <returns>What is drawn for entities whose pipeline is still compiling.</returns>
+			inline PendingPipelineMode GetPendingPipelineMode() const { return m_pendingPipelineMode; }
+			/// <summary>
+			/// Watch the shader files of every pipeline. When one is written to, the pipelines using it are rebuilt in the background
+			/// and swapped in once they are ready. A shader that fails to compile is logged and the previous pipeline is kept. Enabled in debug builds.
+			/// </summary>
+			inline void SetShaderHotReload(bool enabled) { m_shaderHotReload = enabled; }
+			/// <returns>If shader files are watched and their pipelines rebuilt when they change.</returns>
+			inline bool GetShaderHotReload() const { return m_shaderHotReload; }
+			/// <returns>Number of pipelines that are queued or compiling in the background.</returns>
+			inline uint32_t GetPendingPipelineCount() const { return m_pipelineCompileQueue->GetPendingCount(); }
+			/// <param name="entity">An entity added with Renderer::AddEntity.</param>
+			/// <returns>Number of frames entity was drawn with the base pipeline or skipped while its pipeline was compiling.</returns>
+			inline uint32_t GetPipelineWaitFrames(ECS::Entity entity) const { return m_renderObjects[m_renderObjectIndices.at(entity)].pipelineWaitFrames; }
+
+			/// <summary>
+			/// Set how many frames the Cpu may record ahead of the Gpu. Fewer frames lower latency, more frames keep the Gpu busy when frame times vary.
+			/// Clamped to 1 - 4, defaults to 2. Waits for the Gpu to be idle.
+			/// </summary>
+			void SetFramesInFlight(uint32_t framesInFlight);
+			/// <returns>Number of frames the Cpu may record ahead of the Gpu.</returns>
+			inline uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+			/// <summary>
+			/// Set the number of swapchain images to ask for. More images let the Gpu render ahead of the display at the cost of latency.
+			/// Clamped to what the surface supports. 0 asks for the minimum plus one, which is the default. Recreates the swapchain.
+			/// Does nothing for a headless renderer, which has an image per frame in flight.
+			/// </summary>
+			void SetSwapchainImageCount(uint32_t imageCount);
+			/// <returns>Number of images of the current swapchain.</returns>
+			inline uint32_t GetSwapchainImageCount() const { return (uint32_t)m_swapchain.GetSwapchainImages().size(); }
+			/// <summary>
+			/// Don't start frames more often than framesPerSecond. 0 for no limit, which is the default.
+			/// </summary>
+			inline void SetFrameRateLimit(double framesPerSecond) { m_framePacer.SetFrameRateLimit(framesPerSecond); }
+			/// <returns>If frames are paced with VK_KHR_present_wait rather than on the Cpu.</returns>
+			inline bool UsesPresentWait() const { return m_framePacer.UsesPresentWait(); }
+			/// <returns>Cpu, Gpu and present timings of the last frame.</returns>
+			inline const FrameTimings& GetFrameTimings() const { return m_frameTimings; }
+			/// <summary>
+			/// Gpu timings of the scopes "Frame" (the whole primary command buffer) and "RenderPass", and of every draw if Renderer::SetGpuDrawProfiling is enabled.
+			/// </summary>
+			inline GpuProfiler& GetGpuProfiler() { return *m_gpuProfiler; }
+			/// <summary>
+			/// Measure the Gpu time of every instanced draw as a scope of the Gpu profiler, named after its shaders and mesh. Disabled by default.
+			/// Draws overlap on the Gpu, so the times of draws don't add up to the time of the render pass.
+			/// </summary>
+			inline void SetGpuDrawProfiling(bool enabled) { m_gpuDrawProfiling = enabled; }
+			/// <returns>If every draw is measured by the Gpu profiler.</returns>
+			inline bool GetGpuDrawProfiling() const { return m_gpuDrawProfiling; }
+
+			/// <returns>Gpu memory usage of the renderer's buffers.</returns>
+			inline AllocatorStats GetMemoryStats() const { return m_allocator.GetStats(); }
+			/// <returns>Draw calls and state changes of the last recorded frame.</returns>
+			inline const DrawStats& GetDrawStats() const { return m_drawStats; }
+
+			/// <returns>Name, vendor and driver version of the Gpu the renderer runs on.</returns>
+			inline const VkPhysicalDeviceProperties& GetDeviceProperties() const { return m_device.GetDeviceProperties(); }
+
+			/// <returns>If the renderer renders offscreen without a window.</returns>
+			inline bool IsHeadless() const { return m_swapchain.IsOffscreen(); }
+			/// <summary>
+			/// Read back the last frame drawn by a headless renderer. Waits for the frame to finish on the Gpu.
+			/// </summary>
+			/// <returns>Width * height RGBA pixels, rows from top to bottom. Empty if no frame has been drawn yet.</returns>
+			std::vector<uint8_t> ReadFrame();
+			/// <summary>
+			/// Resize the offscreen images of a headless renderer. They are recreated the way the swapchain is when a window is resized. Waits for the Gpu to be idle.
+			/// </summary>
+			void Resize(uint32_t width, uint32_t height);
+			/// <summary>
+			/// Write the last frame drawn by a headless renderer to a png file. Waits for the frame to finish on the Gpu.
+			/// </summary>
+			/// <returns>False if no frame has been drawn yet or the file couldn't be written.</returns>
+			bool SaveFrame(const std::string& filename);
 
 			/// <summary>
 			/// render all entities.
@@ -79,13 +292,16 @@ namespace IRun {
 			Instance m_instance;
 			Surface m_surface;
 			Device m_device;
+			Allocator m_allocator;
 			Swapchain m_oldSwapchain;
 			Swapchain m_swapchain;
 			RenderPass m_renderPass;
 			PipelineCache m_pipelineCache;
+			// Pipelines are created with these and merged into m_pipelineCache when it is saved. Behind a pointer since it owns a thread.
+			std::unique_ptr<ThreadPipelineCaches> m_threadPipelineCaches;
 			Framebuffers m_framebuffers;
 			CommandPool m_graphicsCommandPool;
-			CommandPool m_transferCommandPool;
+			UploadManager m_uploadManager;
 			GraphicsPipeline m_basePipeline;
 
 			std::vector<Sync<Semaphore>> m_imageAvailableSemaphores{};
@@ -94,11 +310,108 @@ namespace IRun {
 
 			Sync<Semaphore> m_nvLatencySleepSemaphore;
 
+			// One primary command buffer per frame in flight.
 			std::vector<CommandBuffer> m_commandBuffers;
 
-			std::unordered_map<ECS::Shader, GraphicsPipeline, ECS::Shader::HashFn> m_graphicsPipelines;
-			std::unordered_map<ECS::Entity, DeviceLocalBuffer<Vertex>> m_vertexDataBuffers;
-			std::unordered_map<ECS::Entity, DeviceLocalBuffer<uint32_t>> m_indexDataBuffers;
+			FramePacer m_framePacer;
+			FrameTimings m_frameTimings;
+			// Behind a pointer since recording threads write to it and the renderer is move assigned.
+			std::unique_ptr<GpuProfiler> m_gpuProfiler;
+			uint32_t m_frameScope;
+			uint32_t m_renderPassScope;
+			bool m_gpuDrawProfiling = false;
+			// Scope of every drawn pipeline and mesh pair, keyed by pipeline << 32 | mesh. Filled by ResolveDrawScopes before recording
+			// starts, recording threads only read it. Cleared when a pipeline slot is freed, a reused slot has other shaders.
+			std::unordered_map<uint64_t, uint32_t> m_drawScopes{};
+
+			/// <summary>
+			/// Command pool and secondary command buffer of one recording thread in one frame in flight.
+			/// </summary>
+			struct RecordingContext {
+				CommandPool commandPool;
+				CommandBuffer commandBuffer;
+			};
+
+			// MAX_FRAMES_IN_FLIGHT * m_recordingThreadCount contexts, indexed with m_currentFrame * m_recordingThreadCount + thread. Empty with 1 thread.
+			std::vector<RecordingContext> m_recordingContexts;
+			uint32_t m_recordingThreadCount = 1;
+			Tools::JobSystem* m_jobSystem = nullptr;
+
+			/// <summary>
+			/// Where the mesh of an entity lives in the vertex and index arenas.
+			/// </summary>
+			struct MeshRange {
+				int32_t vertexOffset;
+				uint32_t vertexCount;
+				uint32_t firstIndex;
+				uint32_t indexCount;
+			};
+
+			struct MeshSlot {
+				MeshRange range;
+				// Number of entities using the mesh plus one for the handle returned by CreateMesh. The slot is free when it is 0.
+				uint32_t refCount;
+			};
+
+			struct GraphicsPipelineSlot {
+				GraphicsPipeline pipeline;
+				ECS::Shader shaders;
+				// Number of entities using the pipeline. The slot is free when it is 0.
+				uint32_t refCount;
+				// False while the pipeline is compiling in the background, pipeline is m_basePipeline until then.
+				bool ready;
+				// Frame number the background compile was queued in.
+				uint64_t requestFrame;
+				// Number of hot reload compiles queued for this pipeline that haven't finished yet.
+				uint32_t pendingReloads;
+			};
+
+			/// <summary>
+			/// Everything needed to draw an entity, looked up once in AddEntity so the draw loop doesn't touch the ECS.
+			/// </summary>
+			struct RenderObject {
+				ECS::Entity entity;
+				// Index into m_meshes.
+				uint32_t mesh;
+				// Index into m_graphicsPipelines.
+				uint32_t pipeline;
+				bool hasTransform;
+				// Frames drawn with the base pipeline or skipped while the pipeline was compiling.
+				uint32_t pipelineWaitFrames;
+			};
+
+			// Pipelines are referred to by their index so the draw loop never hashes shader filenames.
+			std::vector<GraphicsPipelineSlot> m_graphicsPipelines;
+			std::vector<uint32_t> m_freeGraphicsPipelines;
+			std::unordered_map<ECS::Shader, uint32_t, ECS::Shader::HashFn> m_graphicsPipelineHandles;
+			// Behind a pointer since it owns a thread and a mutex and the renderer is move assigned.
+			std::unique_ptr<PipelineCompileQueue> m_pipelineCompileQueue;
+			PendingPipelineMode m_pendingPipelineMode = PendingPipelineMode::Fallback;
+			// Shader files of every pipeline.
+			Tools::FileWatcher m_shaderWatcher;
+			bool m_shaderHotReload = false;
+
+			// Every mesh is placed in these so the draw loop only binds one vertex and one index buffer.
+			BufferArena<Vertex> m_vertexArena;
+			BufferArena<uint32_t> m_indexArena;
+			std::vector<MeshSlot> m_meshes;
+			std::vector<uint32_t> m_freeMeshes;
+
+			// Host visible, one per frame in flight. Filled in sorted draw order every frame so each instanced draw reads a contiguous range.
+			std::vector<Buffer<InstanceData>> m_instanceBuffers;
+			// Host visible storage buffers, one per frame in flight. Model matrix of every render object, in the same order as m_renderObjects.
+			std::vector<Buffer<glm::mat4>> m_transformBuffers;
+
+			// Densely packed, removing an entity moves the last render object into its place.
+			std::vector<RenderObject> m_renderObjects;
+			std::unordered_map<ECS::Entity, uint32_t> m_renderObjectIndices;
+			RenderQueue m_renderQueue;
+			// Ranges of destroyed meshes, given back to the arenas once the frame number has finished.
+			std::vector<std::pair<uint64_t, MeshRange>> m_retiredMeshRanges;
+
+			DeletionQueue m_deletionQueue;
+
+			DrawStats m_drawStats;
 
 			std::vector<Buffer<Mvp>> m_uniformBuffers;
 			std::vector<DescriptorSet> m_descriptorSets;
@@ -111,17 +424,40 @@ namespace IRun {
 			VkRenderPassBeginInfo m_renderPassBeginInfo{};
 
 			uint32_t m_currentFrame;
-
-			std::vector<ECS::Entity> m_entities;
-
-			Tools::Timer<Tools::Milliseconds> timer{};
+			// Resources are created for MAX_FRAMES_IN_FLIGHT frames, the first m_framesInFlight of them are used.
+			uint32_t m_framesInFlight;
+			// Requested swapchain image count, 0 for the default.
+			uint32_t m_swapchainImageCount;
+			// Number of the next frame to be submitted. Resources retired before it is submitted are destroyed once it has finished.
+			uint64_t m_frameNumber;
+			// Swapchain image of the last submitted frame, UINT32_MAX before the first frame.
+			uint32_t m_lastImageIndex = UINT32_MAX;
+			// Size of the offscreen images of a headless renderer.
+			VkExtent2D m_headlessExtent{};
 
 			bool m_vSync;
 
+			void CreateResources();
 			void RecreateSwapchain();
+			void RetireResources();
+			uint32_t AcquireGraphicsPipeline(const ECS::Shader& shaders);
+			uint32_t InsertGraphicsPipeline(const ECS::Shader& shaders, const GraphicsPipeline& graphicsPipeline);
+			void ReleaseGraphicsPipeline(uint32_t pipeline);
+			void QueueGraphicsPipelineCompile(const ECS::Shader& shaders, bool exitOnError);
+			void CollectCompiledPipelines();
+			void ReloadChangedShaders();
+			void ReleaseMesh(uint32_t mesh);
+			void ResolveDrawScopes();
+			void RecordDraws(VkCommandBuffer commandBuffer, size_t begin, size_t end, DrawStats& stats);
+			void RecordDrawsParallel(VkCommandBuffer primaryCommandBuffer, VkFramebuffer framebuffer);
+			void CreateRecordingContexts();
+			void DestroyRecordingContexts();
+			void RunParallel(uint32_t taskCount, const std::function<void(uint32_t task)>& task);
 
 			bool m_framebufferResized;
-			IWindow::Vector2<int32_t> m_oldFramebufferSize;
+#ifdef IRUN_WINDOWED
+			IWindow::Vector2<int32_t> m_oldFramebufferSize{};
+#endif
 
 #ifdef DEBUG
 			bool debugMode = true;
@@ -1,8 +1,13 @@
 #pragma once
 
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan.h>
+
+#include "Core.h"
+
+#ifdef IRUN_WINDOWED
 #include <IWindow.h>
 #include <IWindowVK.h>
+#endif
 
 #include "Instance.h"
 #include "Check.h"
@@ -12,12 +17,14 @@ namespace IRun {
 		class Surface {
 		public:
 			Surface() = default;
+#ifdef IRUN_WINDOWED
 			/// <summary>
 			/// Create the surface.
 			/// </summary>
 			/// <param name="window">Window to be rendered to.</param>
 			/// <param name="instance">Vulkan instance this surface is created under.</param>
 			Surface(IWindow::Window& window, Instance& instance);
+#endif
 			/// <summary>
 			/// Destroy the surface.
 			/// </summary>
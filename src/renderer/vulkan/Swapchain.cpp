@@ -4,15 +4,22 @@
 
 namespace IRun {
 	namespace Vk {
-		Swapchain::Swapchain(bool vSync, IWindow::Window& window, const Surface& surface, const Device& device, Swapchain* oldSwapchain) {
+#ifdef IRUN_WINDOWED
+		Swapchain::Swapchain(bool vSync, uint32_t imageCount, IWindow::Window& window, const Surface& surface, const Device& device, Swapchain* oldSwapchain) {
 			m_surfaceFormat = ChooseBestSurfaceFormat(device);
 			VkPresentModeKHR presentMode = ChooseBestPresentationMode(vSync, device);
 			m_imageExtent = ChooseSwapchainImageResolution(window, device);
 
-			uint32_t imageCount = device.GetSwapchainDetails().capabilities.minImageCount + 1;
+			const VkSurfaceCapabilitiesKHR& capabilities = device.GetSwapchainDetails().capabilities;
 
-			if (device.GetSwapchainDetails().capabilities.maxImageCount > 0 && imageCount > device.GetSwapchainDetails().capabilities.maxImageCount) 
-				imageCount = device.GetSwapchainDetails().capabilities.maxImageCount;
+			if (imageCount == 0)
+				imageCount = capabilities.minImageCount + 1;
+
+			if (imageCount < capabilities.minImageCount)
+				imageCount = capabilities.minImageCount;
+
+			if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) 
+				imageCount = capabilities.maxImageCount;
 			
 
 			VkSwapchainCreateInfoKHR swapchainCreateInfo{};
@@ -87,10 +94,81 @@ namespace IRun {
 				m_images.push_back(swapchainImage);
 			}
 		}
+#endif
+
+		Swapchain::Swapchain(VkExtent2D extent, VkFormat format, uint32_t imageCount, const Device& device) :
+			m_offscreen{ true },
+			m_imageExtent{ extent },
+			m_surfaceFormat{ format, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }
+		{
+			VkPhysicalDeviceMemoryProperties memoryProperties{};
+			vkGetPhysicalDeviceMemoryProperties(device.Get().second, &memoryProperties);
+
+			for (uint32_t i = 0; i < imageCount; i++) {
+				VkImageCreateInfo createInfo{};
+				createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				createInfo.imageType = VK_IMAGE_TYPE_2D;
+				createInfo.format = format;
+				createInfo.extent = { extent.width, extent.height, 1 };
+				createInfo.mipLevels = 1;
+				createInfo.arrayLayers = 1;
+				createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				// Transfer source so the rendered frame can be read back.
+				createInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+				SwapchainImage swapchainImage{};
+				VK_CHECK(vkCreateImage(device.Get().first, &createInfo, nullptr, &swapchainImage.image), "Failed to create Vulkan offscreen image!");
+				I_DEBUG_LOG_TRACE("Created Vulkan offscreen image: 0x%p", swapchainImage.image);
+
+				VkMemoryRequirements requirements{};
+				vkGetImageMemoryRequirements(device.Get().first, swapchainImage.image, &requirements);
+
+				// A few images that live as long as the renderer, like swapchain images they get their own memory instead of going through IRun::Vk::Allocator.
+				uint32_t memoryTypeIndex = UINT32_MAX;
+				for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+					if ((requirements.memoryTypeBits & (1u << type)) && (memoryProperties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+						memoryTypeIndex = type;
+						break;
+					}
+				}
+
+				I_ASSERT_FATAL_ERROR(memoryTypeIndex == UINT32_MAX, "No device local memory type for the offscreen images! Abort!");
+
+				VkMemoryAllocateInfo allocateInfo{};
+				allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocateInfo.allocationSize = requirements.size;
+				allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				VK_CHECK(vkAllocateMemory(device.Get().first, &allocateInfo, nullptr, &memory), "Failed to allocate Vulkan offscreen image memory!");
+				VK_CHECK(vkBindImageMemory(device.Get().first, swapchainImage.image, memory, 0), "Failed to bind Vulkan offscreen image memory!");
+				m_imageMemory.push_back(memory);
+
+				swapchainImage.view = CreateImageView(swapchainImage.image, format, device);
+				I_DEBUG_LOG_TRACE("Created Vulkan image view: 0x%p (image: 0x%p)", swapchainImage.view, swapchainImage.image);
+				m_images.push_back(swapchainImage);
+			}
+		}
 
 		void Swapchain::Destroy(const Device& device, bool isOldSwapchain) {
 			for (const SwapchainImage& image : m_images)
 				vkDestroyImageView(device.Get().first, image.view, nullptr);
+
+			if (m_offscreen) {
+				for (const SwapchainImage& image : m_images) {
+					I_DEBUG_LOG_TRACE("Destroyed Vulkan offscreen image: 0x%p", image.image);
+					vkDestroyImage(device.Get().first, image.image, nullptr);
+				}
+
+				for (VkDeviceMemory memory : m_imageMemory)
+					vkFreeMemory(device.Get().first, memory, nullptr);
+
+				return;
+			}
+
 			if (!isOldSwapchain)
 				vkDestroySwapchainKHR(device.Get().first, m_swapchain, nullptr); 
 		}
@@ -166,6 +244,7 @@ namespace IRun {
 		#undef max
 		#undef min
 
+#ifdef IRUN_WINDOWED
 		VkExtent2D Swapchain::ChooseSwapchainImageResolution(IWindow::Window& window, const Device& device)
 		{
 			VkSurfaceCapabilitiesKHR capabilites = device.GetSwapchainDetails().capabilities;
@@ -184,6 +263,7 @@ namespace IRun {
 			
 			return capabilites.currentExtent;
 		}
+#endif
 		VkImageView Swapchain::CreateImageView(VkImage image, VkFormat format, const Device& device)
 		{
 			VkImageViewCreateInfo createInfo{};
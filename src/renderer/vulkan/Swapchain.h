@@ -11,12 +11,24 @@ namespace IRun {
 		class Swapchain {
 		public:
 			Swapchain() = default;
+#ifdef IRUN_WINDOWED
 			/// <summary>
 			/// Create the swapchain, obtain the swapchain images, and create image views.
 			/// </summary>
+			/// <param name="imageCount">Number of swapchain images to ask for, clamped to what the surface supports. 0 asks for the minimum plus one.</param>
 			/// <param name="surface">Surface to be presented to.</param>
 			/// <param name="device">Device that will render the swapchain images.</param>
-			Swapchain(bool vSync, IWindow::Window& window, const Surface& surface, const Device& device, Swapchain* oldSwapchain);
+			Swapchain(bool vSync, uint32_t imageCount, IWindow::Window& window, const Surface& surface, const Device& device, Swapchain* oldSwapchain);
+#endif
+			/// <summary>
+			/// Create device local images that are rendered to like swapchain images but never presented, for headless rendering.
+			/// Needs no surface and no VK_KHR_swapchain. The images can be copied from after a render pass, see IRun::Vk::RenderPass.
+			/// </summary>
+			/// <param name="extent">Size of the images in pixels.</param>
+			/// <param name="format">Format of the images, must support VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT.</param>
+			/// <param name="imageCount">Number of images.</param>
+			/// <param name="device">Device that will render the images.</param>
+			Swapchain(VkExtent2D extent, VkFormat format, uint32_t imageCount, const Device& device);
 			/// <summary>
 			/// Destroys the swapchain, images, and image views.
 			/// </summary>
@@ -28,18 +40,23 @@ namespace IRun {
 			/// </summary>
 			/// <returns>native swapchain handle.</returns>
 			inline VkSwapchainKHR Get() const { return m_swapchain; }
+			/// <returns>If the images are offscreen images that are never presented. Get returns VK_NULL_HANDLE if they are.</returns>
+			inline bool IsOffscreen() const { return m_offscreen; }
 			/// <summary>
 			/// Get the chosen swapchain details.
 			/// </summary>
 			/// <returns>pair of VkExtent2D and VKSurfaceFormatKHR</returns>
-			const inline std::pair<VkExtent2D, VkSurfaceFormatKHR>& GetChosenSwapchainDetails() const { return { m_imageExtent, m_surfaceFormat }; }
+			inline std::pair<VkExtent2D, VkSurfaceFormatKHR> GetChosenSwapchainDetails() const { return { m_imageExtent, m_surfaceFormat }; }
 			/// <summary>
 			/// Get the images and image views associated with this swapchain.
 			/// </summary>
 			/// <returns>Images and image views associated with this swapchain</returns>
 			const inline std::vector<SwapchainImage>& GetSwapchainImages() const { return m_images; }
 		private:
-			VkSwapchainKHR m_swapchain;
+			VkSwapchainKHR m_swapchain = VK_NULL_HANDLE;
+			bool m_offscreen = false;
+			// Memory of the offscreen images, one dedicated allocation per image.
+			std::vector<VkDeviceMemory> m_imageMemory;
 
 			VkExtent2D m_imageExtent;
 			VkSurfaceFormatKHR m_surfaceFormat;
@@ -48,7 +65,9 @@ namespace IRun {
 
 			VkSurfaceFormatKHR ChooseBestSurfaceFormat(const Device& device);
 			VkPresentModeKHR ChooseBestPresentationMode(bool vSync, const Device& device);
+#ifdef IRUN_WINDOWED
 			VkExtent2D ChooseSwapchainImageResolution(IWindow::Window& window, const Device& device);
+#endif
 
 			VkImageView CreateImageView(VkImage image, VkFormat format, const Device& device);
 		};
@@ -0,0 +1,157 @@
+#include "ThreadPipelineCaches.h"
+
+#include "tools/Hash.h"
+#include "tools/Profiler.h"
+#include "tools/Timer.h"
+
+#include <vector>
+
+namespace IRun {
+	namespace Vk {
+		void ThreadPipelineCaches::Create(const Device& device, const PipelineCache& mainCache, const std::string& filename, std::chrono::milliseconds saveInterval) {
+			I_ASSERT_FATAL_ERROR(m_running, "IRun::Vk::ThreadPipelineCaches::Create: the thread pipeline caches have already been created!");
+
+			m_device = device;
+			m_mainCache = mainCache;
+			m_filename = filename;
+			m_saveInterval = saveInterval;
+			// Zero if the cache wasn't loaded from the file.
+			m_savedHash = mainCache.Get().first.dataHash;
+
+			m_running = true;
+			m_thread = std::thread{ &ThreadPipelineCaches::ThreadMain, this };
+		}
+
+		PipelineCache* ThreadPipelineCaches::Acquire() {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			if (!m_freeCaches.empty()) {
+				ThreadCache* threadCache = m_freeCaches.back();
+				m_freeCaches.pop_back();
+				return &threadCache->cache;
+			}
+
+			std::unique_ptr<ThreadCache> threadCache = std::make_unique<ThreadCache>();
+			threadCache->cache.CreateCache(m_device, nullptr, 0);
+
+			// Every thread cache holds a copy of the main cache so the pipelines of earlier runs are found in it.
+			VkPipelineCache mainCache = m_mainCache.Get().second;
+			VK_CHECK(vkMergePipelineCaches(m_device.Get().first, threadCache->cache.Get().second, 1, &mainCache), "Failed to merge the main pipeline cache into a thread pipeline cache!");
+
+			m_threadCaches.push_back(std::move(threadCache));
+
+			return &m_threadCaches.back()->cache;
+		}
+
+		void ThreadPipelineCaches::Release(PipelineCache* cache, bool changed) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			for (std::unique_ptr<ThreadCache>& threadCache : m_threadCaches) {
+				if (&threadCache->cache != cache)
+					continue;
+
+				if (changed) {
+					threadCache->changed = true;
+					m_changed = true;
+				}
+
+				m_freeCaches.push_back(threadCache.get());
+				return;
+			}
+
+			I_DEBUG_LOG_ERROR("IRun::Vk::ThreadPipelineCaches::Release: cache was not returned by IRun::Vk::ThreadPipelineCaches::Acquire!");
+		}
+
+		void ThreadPipelineCaches::RequestSave() {
+			{
+				std::lock_guard<std::mutex> lock{ m_wakeMutex };
+				m_saveRequested = true;
+			}
+			m_wakeCondition.notify_one();
+		}
+
+		void ThreadPipelineCaches::Destroy() {
+			if (!m_running)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock{ m_wakeMutex };
+				m_running = false;
+			}
+			m_wakeCondition.notify_one();
+
+			m_thread.join();
+
+			Save();
+
+			for (std::unique_ptr<ThreadCache>& threadCache : m_threadCaches)
+				threadCache->cache.Destroy(m_device);
+
+			m_threadCaches.clear();
+			m_freeCaches.clear();
+		}
+
+		void ThreadPipelineCaches::ThreadMain() {
+			Tools::Profiler::SetThreadName("Pipeline cache save");
+
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock{ m_wakeMutex };
+					m_wakeCondition.wait_for(lock, m_saveInterval, [this]() { return !m_running || m_saveRequested; });
+
+					// Destroy saves one last time itself.
+					if (!m_running)
+						break;
+
+					m_saveRequested = false;
+				}
+
+				Save();
+			}
+		}
+
+		void ThreadPipelineCaches::Save() {
+			IRUN_PROFILE_FUNCTION();
+
+			if (!m_changed.exchange(false))
+				return;
+
+			Tools::Timer<Tools::Milliseconds> timer{};
+			timer.Start();
+
+			std::vector<uint8_t> data{};
+
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+
+				std::vector<VkPipelineCache> changedCaches{};
+				for (std::unique_ptr<ThreadCache>& threadCache : m_threadCaches)
+					if (threadCache->changed.exchange(false))
+						changedCaches.push_back(threadCache->cache.Get().second);
+
+				// Acquired caches may be creating pipelines right now, Vulkan synchronizes the source caches of a merge internally.
+				VK_CHECK(vkMergePipelineCaches(m_device.Get().first, m_mainCache.Get().second, (uint32_t)changedCaches.size(), changedCaches.data()), "Failed to merge thread pipeline caches!");
+
+				size_t dataSize = 0;
+				VK_CHECK(vkGetPipelineCacheData(m_device.Get().first, m_mainCache.Get().second, &dataSize, nullptr), "Failed to get pipeline cache data!");
+				data.resize(dataSize);
+				VK_CHECK(vkGetPipelineCacheData(m_device.Get().first, m_mainCache.Get().second, &dataSize, data.data()), "Failed to get pipeline cache data!");
+				data.resize(dataSize);
+			}
+
+			// Pipelines that were all found in the cache add nothing to it.
+			uint64_t hash = Tools::XXHash64(data.data(), data.size());
+			if (hash == m_savedHash) {
+				I_DEBUG_LOG_TRACE("Pipeline cache unchanged, not saved.");
+				return;
+			}
+
+			if (PipelineCache::WriteCacheFile(m_filename, m_device.GetDeviceProperties(), data.data(), data.size()) != ErrorCode::Success)
+				return;
+
+			m_savedHash = hash;
+
+			I_LOG_INFO("Saved pipeline cache (%zu bytes) in %.3f ms", data.size(), timer.Stop());
+		}
+	}
+}
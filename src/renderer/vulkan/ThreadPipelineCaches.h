@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Device.h"
+#include "PipelineCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Gives every thread that creates pipelines a VkPipelineCache of its own, so pipelines created in parallel don't contend on one cache.
+		/// Caches are pooled, there are as many as the most threads that ever created pipelines at the same time.
+		/// Thread caches that created pipelines are merged into the main cache with vkMergePipelineCaches and saved to disk on a background thread,
+		/// periodically and when ThreadPipelineCaches::RequestSave is called. Nothing is merged or written if no pipeline was created since the last save.
+		/// </summary>
+		class ThreadPipelineCaches {
+		public:
+			ThreadPipelineCaches() = default;
+			ThreadPipelineCaches(const ThreadPipelineCaches&) = delete;
+			ThreadPipelineCaches& operator=(const ThreadPipelineCaches&) = delete;
+			/// <summary>
+			/// Start the save thread.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="mainCache">Cache loaded from filename, or an empty one. Must outlive this object and must not be used by anything else.</param>
+			/// <param name="filename">File the main cache is saved to.</param>
+			/// <param name="saveInterval">How often the save thread checks for new pipelines.</param>
+			void Create(const Device& device, const PipelineCache& mainCache, const std::string& filename, std::chrono::milliseconds saveInterval);
+			/// <summary>
+			/// Take a cache to create pipelines with. A new cache is created if every cache is in use, it is filled with the main cache
+			/// so pipelines saved in earlier runs are still found.
+			/// </summary>
+			/// <returns>Cache that only the calling thread uses until it is passed to ThreadPipelineCaches::Release.</returns>
+			PipelineCache* Acquire();
+			/// <summary>
+			/// Give a cache back.
+			/// </summary>
+			/// <param name="cache">Cache returned by ThreadPipelineCaches::Acquire.</param>
+			/// <param name="changed">True if pipelines were created with the cache, so it is merged and saved.</param>
+			void Release(PipelineCache* cache, bool changed);
+			/// <summary>
+			/// Wake the save thread now instead of waiting for the next interval. Does not block.
+			/// </summary>
+			void RequestSave();
+			/// <summary>
+			/// Stop the save thread, save one last time if anything changed and destroy every thread cache. The main cache is not destroyed.
+			/// No thread may create pipelines with a thread cache anymore.
+			/// </summary>
+			void Destroy();
+		private:
+			struct ThreadCache {
+				PipelineCache cache;
+				// Set when a pipeline was created with the cache, cleared when it is merged into the main cache.
+				std::atomic<bool> changed = false;
+			};
+
+			Device m_device;
+			PipelineCache m_mainCache;
+			std::string m_filename;
+			std::chrono::milliseconds m_saveInterval;
+
+			// Guards the thread caches and every use of the main cache, which must be externally synchronized when it is merged into.
+			std::mutex m_mutex;
+			std::vector<std::unique_ptr<ThreadCache>> m_threadCaches;
+			// Caches not acquired by any thread.
+			std::vector<ThreadCache*> m_freeCaches;
+			// Hash of the data in the file, a merge that added nothing new doesn't rewrite it.
+			uint64_t m_savedHash = 0;
+
+			std::atomic<bool> m_changed = false;
+
+			std::mutex m_wakeMutex;
+			std::condition_variable m_wakeCondition;
+			bool m_saveRequested = false;
+			bool m_running = false;
+			std::thread m_thread;
+
+			void ThreadMain();
+			void Save();
+		};
+	}
+}
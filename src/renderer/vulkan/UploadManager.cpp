@@ -0,0 +1,226 @@
+#include "UploadManager.h"
+
+namespace IRun {
+	namespace Vk {
+		// Keeps staging offsets friendly for any kind of copy.
+		static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+		UploadManager::UploadManager(Device& device, Allocator& allocator, VkDeviceSize stagingSize) :
+			m_capacity{ stagingSize },
+			m_mutex{ std::make_unique<std::mutex>() }
+		{
+			m_stagingBuffer = Buffer<uint8_t>{ device, allocator, nullptr, (size_t)stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, BufferFlags::PersistentMap };
+			// Stays mapped for the lifetime of the upload manager.
+			m_mapped = m_stagingBuffer.GetMapped();
+
+			// Command buffers are reused once their submission finished.
+			m_commandPool = CommandPool{ device, device.GetQueueFamilies().transferFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT };
+
+			VkSemaphoreTypeCreateInfo timelineInfo{};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			timelineInfo.pNext = nullptr;
+			timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			timelineInfo.initialValue = 0;
+
+			m_timelineSemaphore = Sync<Semaphore>{ device, 0, &timelineInfo };
+		}
+
+		uint64_t UploadManager::Enqueue(Device& device, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			// Large uploads are split so a single upload never needs the whole ring.
+			VkDeviceSize maxChunkSize = m_capacity / 4;
+			VkDeviceSize copied = 0;
+
+			while (copied < size) {
+				VkDeviceSize chunkSize = std::min(size - copied, maxChunkSize);
+				VkDeviceSize stagingOffset = AllocateStaging(device, chunkSize);
+
+				memcpy(m_mapped + stagingOffset, (const uint8_t*)data + copied, (size_t)chunkSize);
+
+				PendingCopy copy{};
+				copy.srcBuffer = m_stagingBuffer.Get();
+				copy.dstBuffer = dstBuffer;
+				copy.region.srcOffset = stagingOffset;
+				copy.region.dstOffset = dstOffset + copied;
+				copy.region.size = chunkSize;
+				m_pendingCopies.push_back(copy);
+
+				copied += chunkSize;
+			}
+
+			return m_nextValue;
+		}
+
+		uint64_t UploadManager::EnqueueCopy(Device& device, VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+
+			PendingCopy copy{};
+			copy.srcBuffer = srcBuffer;
+			copy.dstBuffer = dstBuffer;
+			copy.region.srcOffset = srcOffset;
+			copy.region.dstOffset = dstOffset;
+			copy.region.size = size;
+			m_pendingCopies.push_back(copy);
+
+			return m_nextValue;
+		}
+
+		uint64_t UploadManager::Flush(Device& device) {
+			std::lock_guard<std::mutex> lock{ *m_mutex };
+			return FlushLocked(device);
+		}
+
+		bool UploadManager::IsComplete(const Device& device, uint64_t value) const {
+			uint64_t completedValue = 0;
+			vkGetSemaphoreCounterValue(device.Get().first, m_timelineSemaphore.Get(), &completedValue);
+			return completedValue >= value;
+		}
+
+		void UploadManager::Wait(const Device& device, uint64_t value) const {
+			VkSemaphore semaphore = m_timelineSemaphore.Get();
+
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &semaphore;
+			waitInfo.pValues = &value;
+
+			VK_CHECK(vkWaitSemaphores(device.Get().first, &waitInfo, UINT64_MAX), "Failed to wait for Vulkan timeline semaphore!");
+		}
+
+		void UploadManager::Destroy(Device& device, Allocator& allocator) {
+			Wait(device, GetLastSubmittedValue());
+
+			m_pendingCopies.clear();
+			m_submissions.clear();
+			m_freeCommandBuffers.clear();
+
+			m_timelineSemaphore.Destroy(device);
+			m_commandPool.Destroy(device);
+
+			m_stagingBuffer.Destroy(device, allocator);
+			m_mapped = nullptr;
+		}
+
+		uint64_t UploadManager::FlushLocked(Device& device) {
+			RetireSubmissions(device, false);
+
+			if (m_pendingCopies.empty())
+				return GetLastSubmittedValue();
+
+			CommandBuffer commandBuffer;
+			if (!m_freeCommandBuffers.empty()) {
+				commandBuffer = m_freeCommandBuffers.back();
+				m_freeCommandBuffers.pop_back();
+			}
+			else {
+				commandBuffer = m_commandPool.CreateBuffer(device, CommandBufferLevel::Primary);
+			}
+
+			m_commandPool.BeginRecordingCommands(device, commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+			// Copies between device buffers may read what an earlier copy (or an earlier submission) wrote and later copies may write to what they read,
+			// so they are fenced off with a transfer to transfer barrier on both sides. Staging copies never depend on each other.
+			VkMemoryBarrier transferBarrier{};
+			transferBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			transferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			transferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			// Consecutive copies between the same buffers are submitted with a single vkCmdCopyBuffer.
+			std::vector<VkBufferCopy> regions{};
+			for (size_t i = 0; i < m_pendingCopies.size(); i++) {
+				const PendingCopy& copy = m_pendingCopies[i];
+				bool deviceCopy = copy.srcBuffer != m_stagingBuffer.Get();
+
+				if (deviceCopy && regions.empty())
+					vkCmdPipelineBarrier(m_commandPool[commandBuffer], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &transferBarrier, 0, nullptr, 0, nullptr);
+
+				regions.push_back(copy.region);
+
+				if (i + 1 == m_pendingCopies.size() || m_pendingCopies[i + 1].srcBuffer != copy.srcBuffer || m_pendingCopies[i + 1].dstBuffer != copy.dstBuffer) {
+					vkCmdCopyBuffer(m_commandPool[commandBuffer], copy.srcBuffer, copy.dstBuffer, (uint32_t)regions.size(), regions.data());
+					regions.clear();
+
+					if (deviceCopy)
+						vkCmdPipelineBarrier(m_commandPool[commandBuffer], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &transferBarrier, 0, nullptr, 0, nullptr);
+				}
+			}
+
+			m_commandPool.EndRecordingCommands(commandBuffer);
+
+			uint64_t signalValue = m_nextValue++;
+
+			// The semaphore signal makes the transfer writes available to whoever waits on it, so no buffer barriers are recorded here.
+			VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+			timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineSubmitInfo.signalSemaphoreValueCount = 1;
+			timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+
+			std::array<VkSemaphore, 1> signalSemaphores = {
+				m_timelineSemaphore.Get()
+			};
+
+			std::array<VkCommandBuffer, 1> submitCommandBuffers = {
+				m_commandPool[commandBuffer]
+			};
+
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.pNext = &timelineSubmitInfo;
+			submitInfo.commandBufferCount = (uint32_t)submitCommandBuffers.size();
+			submitInfo.pCommandBuffers = submitCommandBuffers.data();
+			submitInfo.signalSemaphoreCount = (uint32_t)signalSemaphores.size();
+			submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+			VK_CHECK(vkQueueSubmit(device.GetQueues().at(QueueType::Transfer), 1, &submitInfo, nullptr), "Failed to submit uploads to the transfer queue!");
+
+			m_submissions.push_back({ signalValue, m_head, commandBuffer });
+			m_pendingCopies.clear();
+
+			return signalValue;
+		}
+
+		VkDeviceSize UploadManager::AllocateStaging(Device& device, VkDeviceSize size) {
+			size = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+			while (true) {
+				uint64_t head = m_head;
+				VkDeviceSize position = head % m_capacity;
+
+				// Don't split an allocation across the end of the ring, skip to the start instead.
+				if (position + size > m_capacity)
+					head += m_capacity - position;
+
+				if (head + size - m_tail <= m_capacity) {
+					m_head = head + size;
+					return head % m_capacity;
+				}
+
+				// Out of space. Data that has not been flushed can't be reclaimed, so submit it first and then wait for the oldest upload.
+				if (!m_pendingCopies.empty())
+					FlushLocked(device);
+
+				RetireSubmissions(device, true);
+			}
+		}
+
+		void UploadManager::RetireSubmissions(const Device& device, bool waitForOldest) {
+			if (waitForOldest && !m_submissions.empty())
+				Wait(device, m_submissions.front().value);
+
+			uint64_t completedValue = 0;
+			vkGetSemaphoreCounterValue(device.Get().first, m_timelineSemaphore.Get(), &completedValue);
+
+			while (!m_submissions.empty() && m_submissions.front().value <= completedValue) {
+				m_tail = m_submissions.front().ringEnd;
+				m_freeCommandBuffers.push_back(m_submissions.front().commandBuffer);
+				m_submissions.pop_front();
+			}
+
+			// Nothing in flight and nothing pending, the whole ring is free.
+			if (m_submissions.empty() && m_pendingCopies.empty())
+				m_tail = m_head;
+		}
+	}
+}
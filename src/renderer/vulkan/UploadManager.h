@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Device.h"
+#include "Allocator.h"
+#include "Buffer.h"
+#include "CommandPool.h"
+#include "Sync.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace IRun {
+	namespace Vk {
+		/// <summary>
+		/// Batches host to device buffer uploads.
+		/// Data is copied into a persistently mapped staging ring buffer when it is enqueued and all pending copies are recorded into one command buffer when flushed.
+		/// Completion is tracked with a timeline semaphore so nothing on the Cpu has to wait for the transfer queue.
+		/// </summary>
+		class UploadManager {
+		public:
+			/// <summary>
+			/// Default size of the staging ring buffer in bytes.
+			/// </summary>
+			static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 16ull * 1024ull * 1024ull;
+
+			UploadManager() = default;
+			/// <summary>
+			/// Create the staging ring buffer, transfer command pool and timeline semaphore.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">A valid IRun::Vk::Allocator.</param>
+			/// <param name="stagingSize">Size of the staging ring buffer in bytes.</param>
+			UploadManager(Device& device, Allocator& allocator, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+			/// <summary>
+			/// Copy data into the staging ring and enqueue a copy of it into dstBuffer. The data can be freed as soon as this function returns.
+			/// May flush or wait for older uploads if the staging ring is full.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="dstBuffer">Buffer to copy the data to. Must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT.</param>
+			/// <param name="dstOffset">Offset in bytes into dstBuffer.</param>
+			/// <param name="data">Data to upload.</param>
+			/// <param name="size">Size of data in bytes.</param>
+			/// <returns>The timeline semaphore value that will be signalled once the copy has finished.</returns>
+			uint64_t Enqueue(Device& device, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+			/// <summary>
+			/// Enqueue a copy between two device buffers. The copy is ordered after every copy enqueued before it and before every copy enqueued after it,
+			/// so data uploaded into srcBuffer earlier is moved along with it.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="srcBuffer">Buffer to copy from. Must have been created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT.</param>
+			/// <param name="srcOffset">Offset in bytes into srcBuffer.</param>
+			/// <param name="dstBuffer">Buffer to copy to. Must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT.</param>
+			/// <param name="dstOffset">Offset in bytes into dstBuffer.</param>
+			/// <param name="size">Size in bytes of the copy.</param>
+			/// <returns>The timeline semaphore value that will be signalled once the copy has finished.</returns>
+			uint64_t EnqueueCopy(Device& device, VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size);
+			/// <summary>
+			/// Record all pending copies into one command buffer and submit it to the transfer queue.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <returns>The timeline semaphore value that will be signalled once every upload enqueued so far has finished.</returns>
+			uint64_t Flush(Device& device);
+			/// <returns>True if the upload signalling value has finished.</returns>
+			bool IsComplete(const Device& device, uint64_t value) const;
+			/// <summary>
+			/// Block until the upload signalling value has finished.
+			/// </summary>
+			void Wait(const Device& device, uint64_t value) const;
+			/// <returns>The timeline semaphore that is signalled by every flush. Wait on it before using the uploaded data on another queue.</returns>
+			inline VkSemaphore GetSemaphore() const { return m_timelineSemaphore.Get(); }
+			/// <returns>The timeline semaphore value signalled by the last flush.</returns>
+			inline uint64_t GetLastSubmittedValue() const { return m_nextValue - 1; }
+			/// <summary>
+			/// Wait for all uploads and destroy the staging ring buffer, command pool and timeline semaphore.
+			/// </summary>
+			/// <param name="device">A valid IRun::Vk::Device.</param>
+			/// <param name="allocator">The IRun::Vk::Allocator this upload manager was created with.</param>
+			void Destroy(Device& device, Allocator& allocator);
+		private:
+			struct PendingCopy {
+				// The staging buffer or another device buffer.
+				VkBuffer srcBuffer;
+				VkBuffer dstBuffer;
+				VkBufferCopy region;
+			};
+
+			struct Submission {
+				uint64_t value;
+				// Position of the ring head when the submission was flushed. Everything before it can be reused once the submission finished.
+				uint64_t ringEnd;
+				CommandBuffer commandBuffer;
+			};
+
+			Buffer<uint8_t> m_stagingBuffer;
+			uint8_t* m_mapped = nullptr;
+			VkDeviceSize m_capacity = 0;
+			// Monotonic byte counters, the position in the ring is counter % m_capacity.
+			uint64_t m_head = 0, m_tail = 0;
+
+			std::vector<PendingCopy> m_pendingCopies;
+			std::deque<Submission> m_submissions;
+			std::vector<CommandBuffer> m_freeCommandBuffers;
+
+			CommandPool m_commandPool;
+			Sync<Semaphore> m_timelineSemaphore;
+			uint64_t m_nextValue = 1;
+
+			// Heap allocated so the upload manager can still be moved.
+			std::unique_ptr<std::mutex> m_mutex;
+
+			uint64_t FlushLocked(Device& device);
+			VkDeviceSize AllocateStaging(Device& device, VkDeviceSize size);
+			void RetireSubmissions(const Device& device, bool waitForOldest);
+		};
+	}
+}
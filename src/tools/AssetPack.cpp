@@ -0,0 +1,169 @@
+#include "AssetPack.h"
+
+#include "File.h"
+#include "Hash.h"
+
+#include <ILog.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace IRun {
+	namespace Tools {
+		static size_t AlignUp(size_t offset, size_t alignment) {
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		static bool InFile(uint64_t offset, uint64_t size, size_t fileSize) {
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+
+		ErrorCode AssetPack::Open(const std::string& filename) {
+			m_file = MapFile(filename);
+
+			if (!m_file.IsValid())
+				return ErrorCode::IoError;
+
+			const uint8_t* data = m_file.GetData();
+			size_t size = m_file.GetSize();
+
+			AssetPackHeader header{};
+			bool badPack = size < sizeof(header);
+
+			if (!badPack)
+				memcpy(&header, data, sizeof(header));
+
+			if (!badPack && header.magic != MAGIC) badPack = true;
+
+			if (!badPack && header.version != VERSION) badPack = true;
+
+			size_t tocSize = (size_t)header.meshCount * sizeof(AssetPackMeshEntry) + header.nameTableSize;
+
+			if (!badPack && !InFile(sizeof(header), tocSize, size)) badPack = true;
+
+			if (!badPack && XXHash64(data + sizeof(header), tocSize) != header.tocHash) badPack = true;
+
+			if (badPack) {
+				Destroy();
+				return ErrorCode::Corrupt;
+			}
+
+			const uint8_t* entries = data + sizeof(header);
+			const char* names = (const char*)entries + (size_t)header.meshCount * sizeof(AssetPackMeshEntry);
+
+			m_meshes.resize(header.meshCount);
+
+			for (uint32_t i = 0; i < header.meshCount; i++) {
+				AssetPackMeshEntry entry{};
+				memcpy(&entry, entries + i * sizeof(AssetPackMeshEntry), sizeof(entry));
+
+				// The blobs are used in place, so they must be in the file and aligned for their type.
+				if (!InFile(entry.vertexOffset, (uint64_t)entry.vertexCount * sizeof(Vertex), size) || entry.vertexOffset % ASSET_PACK_ALIGNMENT != 0 ||
+					!InFile(entry.indexOffset, (uint64_t)entry.indexCount * sizeof(uint32_t), size) || entry.indexOffset % ASSET_PACK_ALIGNMENT != 0 ||
+					!InFile(entry.nameOffset, entry.nameLength, header.nameTableSize)) {
+					Destroy();
+					return ErrorCode::Corrupt;
+				}
+
+				m_meshes[i] = {
+					std::string_view{ names + entry.nameOffset, entry.nameLength },
+					(const Vertex*)(data + entry.vertexOffset),
+					entry.vertexCount,
+					(const uint32_t*)(data + entry.indexOffset),
+					entry.indexCount
+				};
+			}
+
+			return ErrorCode::Success;
+		}
+
+		uint32_t AssetPack::FindMesh(std::string_view name) const {
+			for (uint32_t i = 0; i < (uint32_t)m_meshes.size(); i++) {
+				if (m_meshes[i].name == name)
+					return i;
+			}
+
+			return UINT32_MAX;
+		}
+
+		void AssetPack::Destroy() {
+			m_meshes.clear();
+			m_file.Destroy();
+		}
+
+		ErrorCode AssetPack::Write(const std::string& filename, const std::vector<AssetPackMesh>& meshes) {
+			AssetPackHeader header{};
+			header.magic = MAGIC;
+			header.version = VERSION;
+			header.meshCount = (uint32_t)meshes.size();
+
+			std::vector<uint8_t> toc(meshes.size() * sizeof(AssetPackMeshEntry));
+			std::string names{};
+
+			for (const AssetPackMesh& mesh : meshes) {
+				names += mesh.name;
+				header.nameTableSize += (uint32_t)mesh.name.size();
+			}
+
+			// Lay out the blobs after the table of contents, each on ASSET_PACK_ALIGNMENT.
+			size_t offset = AlignUp(sizeof(header) + toc.size() + names.size(), ASSET_PACK_ALIGNMENT);
+			uint32_t nameOffset = 0;
+
+			for (size_t i = 0; i < meshes.size(); i++) {
+				AssetPackMeshEntry entry{};
+				entry.vertexCount = meshes[i].vertexCount;
+				entry.indexCount = meshes[i].indexCount;
+				entry.nameOffset = nameOffset;
+				entry.nameLength = (uint32_t)meshes[i].name.size();
+				nameOffset += entry.nameLength;
+
+				entry.vertexOffset = offset;
+				offset = AlignUp(offset + (size_t)entry.vertexCount * sizeof(Vertex), ASSET_PACK_ALIGNMENT);
+				entry.indexOffset = offset;
+				offset = AlignUp(offset + (size_t)entry.indexCount * sizeof(uint32_t), ASSET_PACK_ALIGNMENT);
+
+				memcpy(toc.data() + i * sizeof(AssetPackMeshEntry), &entry, sizeof(entry));
+			}
+
+			toc.insert(toc.end(), names.begin(), names.end());
+			header.tocHash = XXHash64(toc.data(), toc.size());
+
+			std::ofstream file{ filename, std::ios::binary | std::ios::trunc };
+
+			if (!file.is_open()) {
+				I_LOG_ERROR("Failed to open asset pack: %s", filename.c_str());
+				return ErrorCode::IoError;
+			}
+
+			static constexpr char padding[ASSET_PACK_ALIGNMENT]{};
+			size_t written = sizeof(header) + toc.size();
+
+			file.write((const char*)&header, sizeof(header));
+			file.write((const char*)toc.data(), toc.size());
+
+			for (const AssetPackMesh& mesh : meshes) {
+				const std::pair<const void*, size_t> blobs[] = {
+					{ mesh.vertices, (size_t)mesh.vertexCount * sizeof(Vertex) },
+					{ mesh.indices, (size_t)mesh.indexCount * sizeof(uint32_t) }
+				};
+
+				for (const std::pair<const void*, size_t>& blob : blobs) {
+					file.write(padding, AlignUp(written, ASSET_PACK_ALIGNMENT) - written);
+					written = AlignUp(written, ASSET_PACK_ALIGNMENT);
+
+					file.write((const char*)blob.first, blob.second);
+					written += blob.second;
+				}
+			}
+
+			file.close();
+
+			if (!file) {
+				I_LOG_ERROR("Failed to write asset pack: %s", filename.c_str());
+				return ErrorCode::IoError;
+			}
+
+			return ErrorCode::Success;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Error.h"
+#include "MappedFile.h"
+#include "renderer/Vertex.h"
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Start of an asset pack. Followed by meshCount IRun::Tools::AssetPackMeshEntry, the name table and the vertex and index blobs.
+		/// Everything is in native byte order and blobs start on ASSET_PACK_ALIGNMENT, so they can be used straight from a mapping of the file.
+		/// </summary>
+		struct AssetPackHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t meshCount;
+			// Size of the mesh names, stored one after another right after the table of contents.
+			uint32_t nameTableSize;
+			// XXHash64 of the table of contents and the name table. The blobs aren't hashed, that would read the whole file on open.
+			uint64_t tocHash;
+		};
+		static_assert(sizeof(AssetPackHeader) == 24, "IRun::Tools::AssetPackHeader is written to disk as is, its size must not change.");
+
+		struct AssetPackMeshEntry {
+			// Offsets in bytes from the start of the file.
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			// Offset in bytes into the name table.
+			uint32_t nameOffset;
+			uint32_t nameLength;
+		};
+		static_assert(sizeof(AssetPackMeshEntry) == 32, "IRun::Tools::AssetPackMeshEntry is written to disk as is, its size must not change.");
+
+		/// <summary>
+		/// A mesh of an asset pack. The pointers point into the mapped file and are valid until AssetPack::Destroy.
+		/// </summary>
+		struct AssetPackMesh {
+			std::string_view name;
+			const Vertex* vertices;
+			uint32_t vertexCount;
+			const uint32_t* indices;
+			uint32_t indexCount;
+		};
+
+		/// <summary>
+		/// A memory mapped file of meshes. Opening a pack only reads and checks its table of contents, mesh data is paged in by the OS
+		/// when it is first read, so meshes can be handed to IRun::Vk::Renderer::CreateMesh without being copied into vectors or parsed.
+		/// </summary>
+		class AssetPack {
+		public:
+			static constexpr uint32_t MAGIC = 0x50415249; // "IRAP"
+			static constexpr uint32_t VERSION = 1;
+			static constexpr size_t ASSET_PACK_ALIGNMENT = 16;
+
+			AssetPack() = default;
+			/// <summary>
+			/// Map an asset pack and check its table of contents.
+			/// </summary>
+			/// <param name="filename">Pack written with AssetPack::Write.</param>
+			/// <returns>
+			/// Returns IRun::ErrorCode::Success if the function succeeds.
+			/// Returns IRun::ErrorCode::IoError if the file failed to open.
+			/// Returns IRun::ErrorCode::Corrupt if the file isn't an asset pack of this version or a blob is out of bounds.
+			/// </returns>
+			ErrorCode Open(const std::string& filename);
+			/// <returns>Number of meshes in the pack.</returns>
+			inline uint32_t GetMeshCount() const { return (uint32_t)m_meshes.size(); }
+			/// <param name="index">Less than AssetPack::GetMeshCount.</param>
+			inline const AssetPackMesh& GetMesh(uint32_t index) const { return m_meshes[index]; }
+			/// <summary>
+			/// Find a mesh by name. Linear in the number of meshes, look meshes up once when a level is loaded.
+			/// </summary>
+			/// <returns>Index of the mesh, UINT32_MAX if the pack has no mesh with that name.</returns>
+			uint32_t FindMesh(std::string_view name) const;
+			/// <summary>
+			/// Unmap the pack. The pointers of its meshes must not be used anymore.
+			/// </summary>
+			void Destroy();
+
+			/// <summary>
+			/// Write meshes to an asset pack.
+			/// </summary>
+			/// <param name="filename">File to write, overwritten if it exists.</param>
+			/// <param name="meshes">Meshes to write, the pointers can point anywhere.</param>
+			/// <returns>
+			/// Returns IRun::ErrorCode::Success if the function succeeds.
+			/// Returns IRun::ErrorCode::IoError if the file failed to open or write.
+			/// </returns>
+			static ErrorCode Write(const std::string& filename, const std::vector<AssetPackMesh>& meshes);
+		private:
+			MappedFile m_file{};
+			std::vector<AssetPackMesh> m_meshes{};
+		};
+	}
+}
@@ -0,0 +1,221 @@
+#include "AsyncReader.h"
+
+#include "Profiler.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace IRun {
+	namespace Tools {
+		void AsyncReader::Create() {
+			I_ASSERT_FATAL_ERROR(m_running, "IRun::Tools::AsyncReader::Create: the reader has already been created!");
+
+			m_running = true;
+			m_thread = std::thread{ &AsyncReader::ReaderMain, this };
+		}
+
+		void AsyncReader::Destroy() {
+			if (!m_running)
+				return;
+
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_running = false;
+				m_cancelCurrent = true;
+			}
+			m_wakeCondition.notify_all();
+
+			m_thread.join();
+
+			m_queue.clear();
+			m_queuedPriorities.clear();
+			m_completions.clear();
+		}
+
+		IoRequest AsyncReader::Read(const std::string& filename, IoPriority priority, IoCallback callback, uint64_t offset, size_t size) {
+			I_DEBUG_ASSERT_FATAL_ERROR(!m_running, "IRun::Tools::AsyncReader::Read: the reader has not been created!");
+
+			IoRequest id = m_nextId++;
+
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_queue.insert({ { priority, id }, Request{ id, filename, std::move(callback), offset, size } });
+				m_queuedPriorities.insert({ id, priority });
+			}
+			m_wakeCondition.notify_one();
+
+			return id;
+		}
+
+		bool AsyncReader::Cancel(IoRequest request) {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+
+			auto itr = m_queuedPriorities.find(request);
+			if (itr != m_queuedPriorities.end()) {
+				m_queue.erase({ itr->second, request });
+				m_queuedPriorities.erase(itr);
+				return true;
+			}
+
+			// The reader thread drops the data of a cancelled read instead of completing it.
+			if (m_current == request) {
+				m_cancelCurrent = true;
+				return true;
+			}
+
+			auto completion = std::find_if(m_completions.begin(), m_completions.end(), [request](const Completion& completion) { return completion.request.id == request; });
+			if (completion != m_completions.end()) {
+				m_completions.erase(completion);
+				return true;
+			}
+
+			return false;
+		}
+
+		uint32_t AsyncReader::Poll() {
+			IRUN_PROFILE_FUNCTION();
+
+			std::vector<Completion> completions{};
+
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				completions.swap(m_completions);
+			}
+
+			for (Completion& completion : completions)
+				completion.request.callback(completion.request.id, completion.err, completion.data);
+
+			return (uint32_t)completions.size();
+		}
+
+		uint32_t AsyncReader::GetPendingCount() {
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			return (uint32_t)m_queue.size() + (m_current != 0 ? 1 : 0);
+		}
+
+		void AsyncReader::ReaderMain() {
+			Profiler::SetThreadName("Async reader");
+
+			while (true) {
+				Request request{};
+
+				{
+					std::unique_lock<std::mutex> lock{ m_mutex };
+					m_wakeCondition.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+
+					if (!m_running)
+						return;
+
+					auto first = m_queue.begin();
+					request = std::move(first->second);
+					m_queuedPriorities.erase(request.id);
+					m_queue.erase(first);
+
+					m_current = request.id;
+					m_cancelCurrent = false;
+				}
+
+				std::vector<uint8_t> data{};
+				ErrorCode err = ErrorCode::Success;
+
+				{
+					IRUN_PROFILE_SCOPE("AsyncReader::Read");
+					err = ReadNative(request.filename, request.offset, request.size, data, m_cancelCurrent);
+				}
+
+				if (err == ErrorCode::IoError)
+					I_LOG_ERROR("Failed to read file: %s", request.filename.c_str());
+
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_current = 0;
+
+				if (!m_cancelCurrent)
+					m_completions.push_back({ std::move(request), err, std::move(data) });
+			}
+		}
+
+		ErrorCode AsyncReader::ReadNative(const std::string& filename, uint64_t offset, size_t size, std::vector<uint8_t>& data, const std::atomic<bool>& cancel) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return ErrorCode::IoError;
+
+			LARGE_INTEGER fileSize{};
+			if (!GetFileSizeEx(file, &fileSize)) {
+				CloseHandle(file);
+				return ErrorCode::IoError;
+			}
+
+			uint64_t totalSize = (uint64_t)fileSize.QuadPart;
+#else
+			int file = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if (file < 0)
+				return ErrorCode::IoError;
+
+			struct stat status{};
+			if (fstat(file, &status) != 0) {
+				close(file);
+				return ErrorCode::IoError;
+			}
+
+			uint64_t totalSize = (uint64_t)status.st_size;
+#endif
+
+			size_t readSize = offset < totalSize ? (size_t)std::min<uint64_t>(size, totalSize - offset) : 0;
+			data.resize(readSize);
+
+			ErrorCode err = ErrorCode::Success;
+			size_t bytesRead = 0;
+
+			while (bytesRead < readSize && !cancel) {
+				size_t chunkSize = std::min(readSize - bytesRead, CHUNK_SIZE);
+				uint64_t chunkOffset = offset + bytesRead;
+
+#ifdef _WIN32
+				// An OVERLAPPED with an offset makes ReadFile read at that offset, like pread.
+				OVERLAPPED overlapped{};
+				overlapped.Offset = (DWORD)chunkOffset;
+				overlapped.OffsetHigh = (DWORD)(chunkOffset >> 32);
+
+				DWORD chunkRead = 0;
+				if (!::ReadFile(file, data.data() + bytesRead, (DWORD)chunkSize, &chunkRead, &overlapped) || chunkRead == 0) {
+					err = ErrorCode::IoError;
+					break;
+				}
+#else
+				ssize_t chunkRead = pread(file, data.data() + bytesRead, chunkSize, (off_t)chunkOffset);
+				if (chunkRead < 0 && errno == EINTR)
+					continue;
+
+				if (chunkRead <= 0) {
+					err = ErrorCode::IoError;
+					break;
+				}
+#endif
+
+				bytesRead += (size_t)chunkRead;
+			}
+
+#ifdef _WIN32
+			CloseHandle(file);
+#else
+			close(file);
+#endif
+
+			data.resize(bytesRead);
+
+			return err;
+		}
+	}
+}
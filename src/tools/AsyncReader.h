@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Error.h"
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Order in which queued reads are started. Reads of the same priority start in the order they were queued.
+		/// </summary>
+		enum struct IoPriority {
+			// Needed this frame, for example what the camera is looking at.
+			High,
+			Normal,
+			// Prefetching.
+			Low,
+			Max
+		};
+
+		/// <summary>
+		/// Handle to a read queued with AsyncReader::Read. 0 is never a valid handle.
+		/// </summary>
+		typedef uint64_t IoRequest;
+
+		/// <summary>
+		/// Called by AsyncReader::Poll once a read has finished.
+		/// </summary>
+		/// <param name="request">The request that finished.</param>
+		/// <param name="err">IRun::ErrorCode::IoError if the file couldn't be opened or read.</param>
+		/// <param name="data">What was read, the callback can move it out.</param>
+		typedef std::function<void(IoRequest request, ErrorCode err, std::vector<uint8_t>& data)> IoCallback;
+
+		/// <summary>
+		/// Reads files on a background thread so loading doesn't stall frames. Reads are started by priority and read with
+		/// positional reads (pread, or ReadFile with an offset on Windows) in chunks so a large read can be cancelled part way.
+		/// Callbacks are run by AsyncReader::Poll on the thread that calls it, so they can create meshes and pipelines on the renderer.
+		/// </summary>
+		class AsyncReader {
+		public:
+			// A read in flight checks for cancellation after every chunk.
+			static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+			AsyncReader() = default;
+			AsyncReader(const AsyncReader&) = delete;
+			AsyncReader& operator=(const AsyncReader&) = delete;
+			/// <summary>
+			/// Start the reader thread.
+			/// </summary>
+			void Create();
+			/// <summary>
+			/// Cancel every read and stop the reader thread. Callbacks of finished reads that weren't polled are not called.
+			/// </summary>
+			void Destroy();
+			/// <summary>
+			/// Queue a read. Can be called from any thread.
+			/// </summary>
+			/// <param name="filename">File to read.</param>
+			/// <param name="priority">Higher priority reads are started first. A read in flight isn't interrupted by a higher priority one.</param>
+			/// <param name="callback">Called by AsyncReader::Poll once the read has finished, unless it is cancelled first.</param>
+			/// <param name="offset">Offset in bytes to start reading at.</param>
+			/// <param name="size">Number of bytes to read, SIZE_MAX reads to the end of the file. Reads past the end are cut short.</param>
+			/// <returns>Handle to cancel the read with.</returns>
+			IoRequest Read(const std::string& filename, IoPriority priority, IoCallback callback, uint64_t offset = 0, size_t size = SIZE_MAX);
+			/// <summary>
+			/// Cancel a read that is queued, in flight or finished but not polled yet. Can be called from any thread.
+			/// </summary>
+			/// <returns>True if the callback of the read will not be called. False if it has already been called or the handle is unknown.</returns>
+			bool Cancel(IoRequest request);
+			/// <summary>
+			/// Run the callbacks of every finished read. Meant to be called once per frame.
+			/// </summary>
+			/// <returns>Number of callbacks run.</returns>
+			uint32_t Poll();
+			/// <returns>Number of reads queued or in flight.</returns>
+			uint32_t GetPendingCount();
+		private:
+			struct Request {
+				IoRequest id;
+				std::string filename;
+				IoCallback callback;
+				uint64_t offset;
+				size_t size;
+			};
+
+			struct Completion {
+				Request request;
+				ErrorCode err;
+				std::vector<uint8_t> data;
+			};
+
+			std::thread m_thread;
+			std::mutex m_mutex;
+			std::condition_variable m_wakeCondition;
+			bool m_running = false;
+
+			std::atomic<IoRequest> m_nextId = 1;
+			// Ordered by priority then by id, the first request is started next.
+			std::map<std::pair<IoPriority, IoRequest>, Request> m_queue;
+			std::unordered_map<IoRequest, IoPriority> m_queuedPriorities;
+			// Request the reader thread is reading, 0 if none.
+			IoRequest m_current = 0;
+			std::atomic<bool> m_cancelCurrent = false;
+			std::vector<Completion> m_completions;
+
+			void ReaderMain();
+			static ErrorCode ReadNative(const std::string& filename, uint64_t offset, size_t size, std::vector<uint8_t>& data, const std::atomic<bool>& cancel);
+		};
+	}
+}
@@ -1,5 +1,12 @@
 #include "File.h"
 
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <thread>
+
 namespace IRun {
 	namespace Tools {
 
@@ -14,7 +21,7 @@ namespace IRun {
 		{
 			std::ifstream file{};
 
-			file.open(filename, std::ios::ate | ConvertIoFlagsToStlFlags(flags));
+			file.open(filename, (std::ios::openmode)(std::ios::ate | ConvertIoFlagsToStlFlags(flags)));
 
 			if (!file.is_open()) {
 				I_LOG_ERROR("Failed to open file: %s", filename.c_str());
@@ -26,7 +33,7 @@ namespace IRun {
 			content.resize((size_t)file.tellg());
 			
 			file.seekg(std::ios_base::beg);
-			file.read((char*)content.c_str(), content.size());
+			file.read(content.data(), content.size());
 			file.close();
 
 			return content;
@@ -36,10 +43,11 @@ namespace IRun {
 		{
 			std::wifstream file{};
 
-			file.open(filename, std::ios::ate | ConvertIoFlagsToStlFlags(flags));
+			// Through std::filesystem::path, only MSVC opens streams from a std::wstring.
+			file.open(std::filesystem::path{ filename }, (std::ios::openmode)(std::ios::ate | ConvertIoFlagsToStlFlags(flags)));
 
 			if (!file.is_open()) {
-				I_LOG_ERROR("Failed to open file: %s", filename.c_str());
+				I_LOG_ERROR("Failed to open file: %ls", filename.c_str());
 				file.close();
 				return L"";
 			}
@@ -48,14 +56,14 @@ namespace IRun {
 			content.resize((size_t)file.tellg());
 
 			file.seekg(std::ios_base::beg);
-			file.read((wchar_t*)content.c_str(), content.size());
+			file.read(content.data(), content.size());
 			file.close();
 
 			return content;
 		}
 
 		void WriteFile(const std::string& filename, const std::string& content, IoFlags flags) {
-			WriteFile(filename, std::vector<char>{ content.begin(), content.end() }, flags);
+			WriteFile(filename, std::span<const uint8_t>{ (const uint8_t*)content.data(), content.size() }, flags);
 		}
 
 		void WriteFile(const std::wstring& filename, const std::wstring& content, IoFlags flags) {
@@ -63,49 +71,129 @@ namespace IRun {
 		}
 
 		void WriteFile(const std::string& filename, const std::vector<char>& content, IoFlags flags) {
-			std::fstream file{};
-
-			if (!(int64_t)(flags & IoFlags::Create)) {
-				file.open(filename, std::ios::in);
+			WriteFile(filename, std::span<const uint8_t>{ (const uint8_t*)content.data(), content.size() }, flags);
+		}
 
-				if (!file.is_open()) {
-					I_LOG_ERROR("Failed to open file: %s", filename.c_str());
-					file.close();
-					return;
-				}
+		void WriteFile(const std::string& filename, std::span<const uint8_t> content, IoFlags flags) {
+			// Checked without opening the file, opening it to check would open it twice.
+			std::error_code err{};
+			if (!(int64_t)(flags & IoFlags::Create) && !std::filesystem::exists(filename, err)) {
+				I_LOG_ERROR("Failed to open file: %s", filename.c_str());
+				return;
 			}
 
-			file.open(filename, std::ios::out | ConvertIoFlagsToStlFlags(flags));
+			std::ofstream file{ filename, (std::ios::openmode)(std::ios::out | ConvertIoFlagsToStlFlags(flags)) };
+
+			if (!file.is_open()) {
+				I_LOG_ERROR("Failed to open file: %s", filename.c_str());
+				return;
+			}
 
 			try {
-				file.write(content.data(), content.size() * sizeof(const char));
+				file.write((const char*)content.data(), content.size());
 			}
-			catch (std::exception e) {
+			catch (const std::exception& e) {
 				I_LOG_ERROR("WriteFile exception: %s", e.what());
 			}
 
 			file.close();
 		}
 
+		ErrorCode ReadFile(const std::string& filename, std::vector<uint8_t>& buffer) {
+			FILE* file = fopen(filename.c_str(), "rb");
 
-		void WriteFile(const std::wstring& filename, const std::vector<wchar_t>& content, IoFlags flags) {
-			std::wfstream file{};
+			if (!file) {
+				buffer.clear();
+				return ErrorCode::IoError;
+			}
+
+			// Unbuffered, fread reads straight into the buffer.
+			setvbuf(file, nullptr, _IONBF, 0);
+
+			std::error_code err{};
+			uintmax_t size = std::filesystem::file_size(filename, err);
+
+			if (err) {
+				fclose(file);
+				buffer.clear();
+				return ErrorCode::IoError;
+			}
 
-			if (!(int64_t)(flags & IoFlags::Create)) {
-				file.open(filename, std::ios::in);
+			// Not cleared first, resize only zero fills the bytes past the size of the previous file.
+			buffer.resize((size_t)size);
+			size_t bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+			fclose(file);
 
-				if (!file.is_open()) {
-					I_LOG_ERROR("Failed to open file: %s", filename.c_str());
-					file.close();
-					return;
-				}
+			if (bytesRead != buffer.size()) {
+				buffer.clear();
+				return ErrorCode::IoError;
 			}
 
-			file.open(filename, std::ios::out | ConvertIoFlagsToStlFlags(flags));
+			return ErrorCode::Success;
+		}
+
+		std::vector<ErrorCode> ReadFiles(const std::vector<std::string>& filenames, std::vector<std::vector<uint8_t>>& buffers, JobSystem* jobSystem) {
+			std::vector<ErrorCode> results(filenames.size(), ErrorCode::Success);
+			buffers.resize(filenames.size());
 
-			file.write(content.data(), content.size() * sizeof(const wchar_t));
+			if (jobSystem) {
+				jobSystem->ParallelFor(filenames.size(), 4, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++)
+						results[i] = ReadFile(filenames[i], buffers[i]);
+				});
+
+				return results;
+			}
+
+			// Every thread reads every threadCount-th file, the calling thread reads as well.
+			size_t threadCount = std::min<size_t>(filenames.size(), std::max(std::thread::hardware_concurrency(), 1u));
+			auto readFiles = [&](size_t thread) {
+				for (size_t i = thread; i < filenames.size(); i += threadCount)
+					results[i] = ReadFile(filenames[i], buffers[i]);
+			};
+
+			std::vector<std::future<void>> workers{};
+			for (size_t thread = 1; thread < threadCount; thread++)
+				workers.push_back(std::async(std::launch::async, readFiles, thread));
+
+			if (threadCount > 0)
+				readFiles(0);
+
+			for (std::future<void>& worker : workers)
+				worker.get();
+
+			return results;
+		}
+
+
+		void WriteFile(const std::wstring& filename, const std::vector<wchar_t>& content, IoFlags flags) {
+			// Checked without opening the file, opening it to check would open it twice.
+			std::error_code err{};
+			if (!(int64_t)(flags & IoFlags::Create) && !std::filesystem::exists(filename, err)) {
+				I_LOG_ERROR("Failed to open file: %ls", filename.c_str());
+				return;
+			}
+
+			std::wofstream file{ std::filesystem::path{ filename }, (std::ios::openmode)(std::ios::out | ConvertIoFlagsToStlFlags(flags)) };
+
+			if (!file.is_open()) {
+				I_LOG_ERROR("Failed to open file: %ls", filename.c_str());
+				return;
+			}
+
+			// A count of wchar_t, not of bytes.
+			file.write(content.data(), content.size());
 
 			file.close();
 		}
+
+		MappedFile MapFile(const std::string& filename) {
+			MappedFile file{ filename };
+
+			if (!file.IsValid())
+				I_LOG_ERROR("Failed to map file: %s", filename.c_str());
+
+			return file;
+		}
 	}
 }
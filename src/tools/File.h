@@ -4,11 +4,16 @@
 #include <fstream>
 #include <ILog.h>
 #include <filesystem>
+#include <span>
+#include <vector>
 
+#include "Error.h"
 #include "Flags.h"
+#include "MappedFile.h"
 
 namespace IRun {
 	namespace Tools {
+		class JobSystem;
 
 		enum struct IoFlags {
 			/// <summary>
@@ -41,6 +46,31 @@ namespace IRun {
 		void WriteFile(const std::wstring& filename, const std::wstring& content, IoFlags flags = IoFlags::None);
 		void WriteFile(const std::string& filename, const std::vector<char>& content, IoFlags flags = IoFlags::None);
 		void WriteFile(const std::wstring& filename, const std::vector<wchar_t>& content, IoFlags flags = IoFlags::None);
+		/// <summary>
+		/// Write bytes without copying them into another buffer first. The other narrow WriteFile overloads forward to this one.
+		/// </summary>
+		void WriteFile(const std::string& filename, std::span<const uint8_t> content, IoFlags flags = IoFlags::None);
+		/// <summary>
+		/// Read a whole file as binary into a caller provided buffer. The buffer is resized to the size of the file, reuse it between
+		/// reads so its memory is reused as well. Reads straight into the buffer, there is no stream buffer in between.
+		/// </summary>
+		/// <returns>IRun::ErrorCode::IoError if the file couldn't be opened or read, the buffer is empty then.</returns>
+		ErrorCode ReadFile(const std::string& filename, std::vector<uint8_t>& buffer);
+		/// <summary>
+		/// Read many files at once, several at a time on different threads. Meant for lots of small files like shaders and configs,
+		/// where the time is spent opening files rather than reading them.
+		/// </summary>
+		/// <param name="filenames">Files to read.</param>
+		/// <param name="buffers">Resized to the number of files, buffer i holds file i. Reuse it between calls to reuse the memory.</param>
+		/// <param name="jobSystem">A created IRun::Tools::JobSystem to read on, or nullptr to use std::async.</param>
+		/// <returns>The result of ReadFile for every file.</returns>
+		std::vector<ErrorCode> ReadFiles(const std::vector<std::string>& filenames, std::vector<std::vector<uint8_t>>& buffers, JobSystem* jobSystem = nullptr);
+		/// <summary>
+		/// Map a file read only into memory instead of reading it. Use for large binary files like asset packs, the data can be
+		/// passed on without being copied into a buffer first.
+		/// </summary>
+		/// <returns>The mapped file, MappedFile::IsValid is false if it couldn't be opened. Unmap it with MappedFile::Destroy.</returns>
+		MappedFile MapFile(const std::string& filename);
 	}
 }
 
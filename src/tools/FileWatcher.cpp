@@ -0,0 +1,138 @@
+#include "FileWatcher.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace IRun {
+	namespace Tools {
+		static std::filesystem::file_time_type GetLastWriteTime(const std::string& filename) {
+			std::error_code error{};
+			std::filesystem::file_time_type time = std::filesystem::last_write_time(filename, error);
+			// A file that is being replaced may not exist for a moment.
+			return error ? std::filesystem::file_time_type::min() : time;
+		}
+
+		void FileWatcher::Create() {
+#ifndef _WIN32
+			m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (m_inotify < 0)
+				I_LOG_ERROR("IRun::Tools::FileWatcher::Create: failed to create an inotify instance, files will not be watched.");
+#endif
+		}
+
+		void FileWatcher::Watch(const std::string& filename) {
+			if (m_fileIndices.contains(filename))
+				return;
+
+			std::filesystem::path directoryPath = std::filesystem::path{ filename }.parent_path();
+			std::string directory = directoryPath.empty() ? "." : directoryPath.string();
+
+			auto itr = m_directories.find(directory);
+			if (itr == m_directories.end()) {
+				WatchedDirectory watchedDirectory{};
+
+#ifdef _WIN32
+				HANDLE handle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+				if (handle == INVALID_HANDLE_VALUE) {
+					I_LOG_ERROR("IRun::Tools::FileWatcher::Watch: failed to watch directory: %s", directory.c_str());
+					return;
+				}
+				watchedDirectory.handle = handle;
+#else
+				// Editors often save by writing a new file and renaming it over the old one.
+				int handle = m_inotify < 0 ? -1 : inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+				if (handle < 0) {
+					I_LOG_ERROR("IRun::Tools::FileWatcher::Watch: failed to watch directory: %s", directory.c_str());
+					return;
+				}
+				watchedDirectory.handle = handle;
+#endif
+
+				itr = m_directories.insert({ directory, watchedDirectory }).first;
+			}
+
+			m_fileIndices.insert({ filename, m_files.size() });
+			itr->second.files.push_back(m_files.size());
+			m_files.push_back({ filename, GetLastWriteTime(filename) });
+		}
+
+		std::vector<std::string> FileWatcher::Poll() {
+			std::vector<const WatchedDirectory*> changedDirectories{};
+
+#ifdef _WIN32
+			for (auto& [directory, watchedDirectory] : m_directories) {
+				if (WaitForSingleObject(watchedDirectory.handle, 0) != WAIT_OBJECT_0)
+					continue;
+
+				changedDirectories.push_back(&watchedDirectory);
+				FindNextChangeNotification(watchedDirectory.handle);
+			}
+#else
+			if (m_inotify < 0)
+				return {};
+
+			alignas(inotify_event) char buffer[4096];
+			std::vector<int> changedHandles{};
+
+			while (true) {
+				ssize_t size = read(m_inotify, buffer, sizeof(buffer));
+				if (size <= 0)
+					break;
+
+				for (ssize_t offset = 0; offset < size;) {
+					const inotify_event* event = (const inotify_event*)(buffer + offset);
+					changedHandles.push_back(event->wd);
+					offset += sizeof(inotify_event) + event->len;
+				}
+			}
+
+			for (auto& [directory, watchedDirectory] : m_directories)
+				if (std::find(changedHandles.begin(), changedHandles.end(), watchedDirectory.handle) != changedHandles.end())
+					changedDirectories.push_back(&watchedDirectory);
+#endif
+
+			std::vector<std::string> changedFiles{};
+
+			// Other files in the directory may have caused the notification, so the write time tells which files changed.
+			for (const WatchedDirectory* watchedDirectory : changedDirectories) {
+				for (size_t file : watchedDirectory->files) {
+					std::filesystem::file_time_type lastWriteTime = GetLastWriteTime(m_files[file].filename);
+
+					if (lastWriteTime == m_files[file].lastWriteTime || lastWriteTime == std::filesystem::file_time_type::min())
+						continue;
+
+					m_files[file].lastWriteTime = lastWriteTime;
+					changedFiles.push_back(m_files[file].filename);
+				}
+			}
+
+			return changedFiles;
+		}
+
+		void FileWatcher::Destroy() {
+#ifdef _WIN32
+			for (auto& [directory, watchedDirectory] : m_directories)
+				FindCloseChangeNotification(watchedDirectory.handle);
+#else
+			// Closing the inotify instance removes every watch.
+			if (m_inotify >= 0)
+				close(m_inotify);
+
+			m_inotify = -1;
+#endif
+
+			m_directories.clear();
+			m_fileIndices.clear();
+			m_files.clear();
+		}
+	}
+}
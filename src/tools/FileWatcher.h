@@ -0,0 +1,65 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Reports files that have been written to. The directory of every watched file is watched by the OS (inotify on Linux,
+		/// change notifications on Windows), only the files of a directory that changed have their write time checked.
+		/// Not thread safe, FileWatcher::Poll is meant to be called once per frame.
+		/// </summary>
+		class FileWatcher {
+		public:
+			FileWatcher() = default;
+			/// <summary>
+			/// Create the OS watch.
+			/// </summary>
+			void Create();
+			/// <summary>
+			/// Start watching a file. Watching a file twice does nothing.
+			/// </summary>
+			/// <param name="filename">Path to the file, it is returned exactly like this by FileWatcher::Poll.</param>
+			void Watch(const std::string& filename);
+			/// <summary>
+			/// Does not block.
+			/// </summary>
+			/// <returns>Every watched file that has been written to since the last call.</returns>
+			std::vector<std::string> Poll();
+			/// <summary>
+			/// Stop watching every file.
+			/// </summary>
+			void Destroy();
+		private:
+#ifdef _WIN32
+			// HANDLE of FindFirstChangeNotification.
+			typedef void* NativeHandle;
+#else
+			// inotify watch descriptor.
+			typedef int NativeHandle;
+#endif
+
+			struct WatchedDirectory {
+				NativeHandle handle;
+				// Indices into m_files.
+				std::vector<size_t> files;
+			};
+
+			struct WatchedFile {
+				std::string filename;
+				std::filesystem::file_time_type lastWriteTime;
+			};
+
+			std::vector<WatchedFile> m_files;
+			std::unordered_map<std::string, size_t> m_fileIndices;
+			std::unordered_map<std::string, WatchedDirectory> m_directories;
+
+#ifndef _WIN32
+			int m_inotify = -1;
+#endif
+		};
+	}
+}
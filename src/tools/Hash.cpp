@@ -0,0 +1,99 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace IRun {
+	namespace Tools {
+		static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+		static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+		static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+		static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+		static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+		static inline uint64_t RotateLeft(uint64_t value, uint32_t bits) {
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		// Unaligned little endian reads, every platform IRun runs on is little endian.
+		static inline uint64_t Read64(const uint8_t* bytes) {
+			uint64_t value;
+			memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		static inline uint32_t Read32(const uint8_t* bytes) {
+			uint32_t value;
+			memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		static inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+			accumulator += input * PRIME_2;
+			accumulator = RotateLeft(accumulator, 31);
+			return accumulator * PRIME_1;
+		}
+
+		static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+			accumulator ^= Round(0, value);
+			return accumulator * PRIME_1 + PRIME_4;
+		}
+
+		uint64_t XXHash64(const void* data, size_t size, uint64_t seed) {
+			const uint8_t* bytes = (const uint8_t*)data;
+			const uint8_t* end = bytes + size;
+			uint64_t hash;
+
+			if (size >= 32) {
+				uint64_t v1 = seed + PRIME_1 + PRIME_2;
+				uint64_t v2 = seed + PRIME_2;
+				uint64_t v3 = seed;
+				uint64_t v4 = seed - PRIME_1;
+
+				// Four independent lanes so the multiplies can run in parallel.
+				const uint8_t* limit = end - 32;
+				do {
+					v1 = Round(v1, Read64(bytes));
+					v2 = Round(v2, Read64(bytes + 8));
+					v3 = Round(v3, Read64(bytes + 16));
+					v4 = Round(v4, Read64(bytes + 24));
+					bytes += 32;
+				} while (bytes <= limit);
+
+				hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+				hash = MergeRound(hash, v1);
+				hash = MergeRound(hash, v2);
+				hash = MergeRound(hash, v3);
+				hash = MergeRound(hash, v4);
+			}
+			else {
+				hash = seed + PRIME_5;
+			}
+
+			hash += (uint64_t)size;
+
+			for (; bytes + 8 <= end; bytes += 8) {
+				hash ^= Round(0, Read64(bytes));
+				hash = RotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+			}
+
+			if (bytes + 4 <= end) {
+				hash ^= (uint64_t)Read32(bytes) * PRIME_1;
+				hash = RotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+				bytes += 4;
+			}
+
+			for (; bytes < end; bytes++) {
+				hash ^= (*bytes) * PRIME_5;
+				hash = RotateLeft(hash, 11) * PRIME_1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= PRIME_2;
+			hash ^= hash >> 29;
+			hash *= PRIME_3;
+			hash ^= hash >> 32;
+
+			return hash;
+		}
+	}
+}
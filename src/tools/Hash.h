@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// 64 bit xxHash (XXH64) of a buffer. Reads 32 bytes per step, fast enough to checksum large files as they are read.
+		/// </summary>
+		/// <param name="data">Bytes to hash.</param>
+		/// <param name="size">Number of bytes.</param>
+		/// <param name="seed">Different seeds give unrelated hashes of the same bytes.</param>
+		/// <returns>The hash, equal to the reference XXH64 implementation.</returns>
+		uint64_t XXHash64(const void* data, size_t size, uint64_t seed = 0);
+	}
+}
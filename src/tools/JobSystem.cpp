@@ -0,0 +1,168 @@
+#include "JobSystem.h"
+
+#include "Profiler.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+
+namespace IRun {
+	namespace Tools {
+		// Set on worker threads so jobs run from a worker go to the worker's own queue.
+		static thread_local const JobSystem* t_jobSystem = nullptr;
+		static thread_local uint32_t t_queueIndex = 0;
+
+		void JobSystem::Create(uint32_t workerCount) {
+			I_ASSERT_FATAL_ERROR(m_running, "IRun::Tools::JobSystem::Create: the job system has already been created!");
+
+			if (workerCount == 0)
+				workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+			for (uint32_t i = 0; i < workerCount + 1; i++)
+				m_queues.push_back(std::make_unique<JobQueue>());
+
+			m_running = true;
+
+			for (uint32_t i = 0; i < workerCount; i++)
+				m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+
+			I_LOG_INFO("Created job system with %u worker threads.", workerCount);
+		}
+
+		void JobSystem::Destroy() {
+			if (!m_running)
+				return;
+
+			// Drain the queues so no counter is left waiting on a job that never runs.
+			while (m_queuedJobs > 0)
+				if (!TryRunJob(GetQueueIndex()))
+					std::this_thread::yield();
+
+			{
+				std::lock_guard<std::mutex> lock{ m_sleepMutex };
+				m_running = false;
+			}
+			m_wakeCondition.notify_all();
+
+			for (std::thread& worker : m_workers)
+				worker.join();
+
+			m_workers.clear();
+			m_queues.clear();
+		}
+
+		void JobSystem::Run(std::function<void()> job, JobCounter* counter) {
+			I_DEBUG_ASSERT_FATAL_ERROR(!m_running, "IRun::Tools::JobSystem::Run: the job system has not been created!");
+
+			if (counter)
+				counter->fetch_add(1, std::memory_order_relaxed);
+
+			// Counted before the job is published, a worker can steal and run it as soon as it is in the queue and the decrement
+			// must not come first. Taking the sleep mutex makes sure a worker that just saw no jobs is already waiting and gets woken up.
+			{
+				std::lock_guard<std::mutex> lock{ m_sleepMutex };
+				m_queuedJobs++;
+			}
+
+			JobQueue& queue = *m_queues[GetQueueIndex()];
+			{
+				std::lock_guard<std::mutex> lock{ queue.mutex };
+				queue.jobs.push_back({ std::move(job), counter });
+			}
+
+			m_wakeCondition.notify_one();
+		}
+
+		void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function) {
+			if (count == 0)
+				return;
+
+			if (grainSize == 0)
+				grainSize = (count + GetThreadCount() - 1) / GetThreadCount();
+
+			JobCounter counter = 0;
+
+			// The first range is run by the calling thread after the rest have been queued.
+			for (size_t begin = grainSize; begin < count; begin += grainSize) {
+				size_t end = std::min(begin + grainSize, count);
+				Run([&function, begin, end]() { function(begin, end); }, &counter);
+			}
+
+			function(0, std::min(grainSize, count));
+
+			Wait(counter);
+		}
+
+		void JobSystem::Wait(const JobCounter& counter) {
+			uint32_t queueIndex = GetQueueIndex();
+
+			while (counter.load(std::memory_order_acquire) > 0)
+				if (!TryRunJob(queueIndex))
+					std::this_thread::yield();
+		}
+
+		void JobSystem::WorkerMain(uint32_t queueIndex) {
+			t_jobSystem = this;
+			t_queueIndex = queueIndex;
+
+			Profiler::SetThreadName("Job worker " + std::to_string(queueIndex));
+
+			while (true) {
+				if (TryRunJob(queueIndex))
+					continue;
+
+				std::unique_lock<std::mutex> lock{ m_sleepMutex };
+				m_wakeCondition.wait(lock, [this]() { return !m_running || m_queuedJobs > 0; });
+
+				if (!m_running)
+					break;
+			}
+
+			t_jobSystem = nullptr;
+		}
+
+		uint32_t JobSystem::GetQueueIndex() const {
+			// The last queue is shared by every thread that isn't a worker of this job system.
+			return t_jobSystem == this ? t_queueIndex : (uint32_t)m_queues.size() - 1;
+		}
+
+		bool JobSystem::TryRunJob(uint32_t queueIndex) {
+			Job job{};
+			bool found = false;
+
+			// Newest job of the own queue first, it is the most likely to still be in cache.
+			{
+				JobQueue& queue = *m_queues[queueIndex];
+				std::lock_guard<std::mutex> lock{ queue.mutex };
+				if (!queue.jobs.empty()) {
+					job = std::move(queue.jobs.back());
+					queue.jobs.pop_back();
+					found = true;
+				}
+			}
+
+			// Otherwise steal the oldest job of another queue.
+			for (uint32_t i = 1; i < (uint32_t)m_queues.size() && !found; i++) {
+				JobQueue& queue = *m_queues[(queueIndex + i) % m_queues.size()];
+				std::lock_guard<std::mutex> lock{ queue.mutex };
+				if (!queue.jobs.empty()) {
+					job = std::move(queue.jobs.front());
+					queue.jobs.pop_front();
+					found = true;
+				}
+			}
+
+			if (!found)
+				return false;
+
+			m_queuedJobs--;
+
+			job.function();
+
+			if (job.counter)
+				job.counter->fetch_sub(1, std::memory_order_release);
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Number of unfinished jobs that were run with it. Incremented when a job is run and decremented when the job has finished.
+		/// Wait on it with JobSystem::Wait, jobs can wait on the counters of other jobs to depend on them.
+		/// </summary>
+		typedef std::atomic<uint32_t> JobCounter;
+
+		/// <summary>
+		/// Runs jobs on a fixed set of worker threads. Every worker has its own deque, it runs the newest job of its own deque first
+		/// and steals the oldest job of another deque when its own is empty. Threads that wait on a JobCounter run jobs while they wait.
+		/// </summary>
+		class JobSystem {
+		public:
+			JobSystem() = default;
+			JobSystem(const JobSystem&) = delete;
+			JobSystem& operator=(const JobSystem&) = delete;
+			/// <summary>
+			/// Start the worker threads.
+			/// </summary>
+			/// <param name="workerCount">Number of worker threads. 0 creates one per core minus one for the thread calling JobSystem::Create.</param>
+			void Create(uint32_t workerCount = 0);
+			/// <summary>
+			/// Run every job that is still queued and stop the worker threads.
+			/// </summary>
+			void Destroy();
+			/// <summary>
+			/// Queue a job. Can be called from any thread, including from inside of a job.
+			/// </summary>
+			/// <param name="job">Function to run. Must not throw.</param>
+			/// <param name="counter">Incremented now and decremented once the job has finished. Can be nullptr.</param>
+			void Run(std::function<void()> job, JobCounter* counter = nullptr);
+			/// <summary>
+			/// Split [0, count) into ranges of at most grainSize elements, run function on every range and wait for all of them.
+			/// The calling thread runs ranges as well.
+			/// </summary>
+			/// <param name="count">Number of elements.</param>
+			/// <param name="grainSize">Maximum number of elements per job. 0 splits the elements evenly over every thread.</param>
+			/// <param name="function">Called with the begin and end of a range.</param>
+			void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& function);
+			/// <summary>
+			/// Run queued jobs until counter reaches 0.
+			/// </summary>
+			void Wait(const JobCounter& counter);
+			/// <returns>Number of worker threads. Does not include threads that wait on a counter.</returns>
+			inline uint32_t GetWorkerCount() const { return (uint32_t)m_workers.size(); }
+			/// <returns>Number of threads jobs are run on, the worker threads and the thread waiting on them.</returns>
+			inline uint32_t GetThreadCount() const { return GetWorkerCount() + 1; }
+		private:
+			struct Job {
+				std::function<void()> function;
+				JobCounter* counter;
+			};
+
+			struct JobQueue {
+				std::mutex mutex;
+				std::deque<Job> jobs;
+			};
+
+			// One per worker plus one shared by every thread that is not a worker.
+			std::vector<std::unique_ptr<JobQueue>> m_queues;
+			std::vector<std::thread> m_workers;
+
+			// Jobs queued but not yet started, workers sleep while it is 0.
+			std::atomic<uint32_t> m_queuedJobs = 0;
+			std::atomic<bool> m_running = false;
+			std::mutex m_sleepMutex;
+			std::condition_variable m_wakeCondition;
+
+			void WorkerMain(uint32_t queueIndex);
+			uint32_t GetQueueIndex() const;
+			bool TryRunJob(uint32_t queueIndex);
+		};
+	}
+}
@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace IRun {
+	namespace Tools {
+		MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return;
+
+			LARGE_INTEGER size{};
+			if (!GetFileSizeEx(file, &size)) {
+				CloseHandle(file);
+				return;
+			}
+
+			m_size = (size_t)size.QuadPart;
+
+			// A mapping of an empty file can't be created.
+			if (m_size > 0) {
+				m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				m_data = m_mapping ? (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+			}
+
+			// The mapping keeps the file open.
+			CloseHandle(file);
+
+			if (m_size > 0 && !m_data) {
+				if (m_mapping)
+					CloseHandle(m_mapping);
+
+				m_mapping = nullptr;
+				m_size = 0;
+				return;
+			}
+#else
+			int file = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+			if (file < 0)
+				return;
+
+			struct stat status{};
+			if (fstat(file, &status) != 0) {
+				close(file);
+				return;
+			}
+
+			m_size = (size_t)status.st_size;
+
+			if (m_size > 0) {
+				void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+				m_data = data == MAP_FAILED ? nullptr : (const uint8_t*)data;
+
+				if (m_data)
+					madvise((void*)m_data, m_size, MADV_SEQUENTIAL);
+			}
+
+			// The mapping keeps the file open.
+			close(file);
+
+			if (m_size > 0 && !m_data) {
+				m_size = 0;
+				return;
+			}
+#endif
+
+			m_valid = true;
+		}
+
+		void MappedFile::Destroy() {
+#ifdef _WIN32
+			if (m_data)
+				UnmapViewOfFile(m_data);
+
+			if (m_mapping)
+				CloseHandle(m_mapping);
+
+			m_mapping = nullptr;
+#else
+			if (m_data)
+				munmap((void*)m_data, m_size);
+#endif
+
+			m_data = nullptr;
+			m_size = 0;
+			m_valid = false;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// A file mapped read only into memory. Pages are read by the OS when they are first touched, nothing is copied into a heap buffer.
+		/// </summary>
+		class MappedFile {
+		public:
+			MappedFile() = default;
+			/// <summary>
+			/// Map a whole file. Check MappedFile::IsValid to see if it succeeded.
+			/// </summary>
+			/// <param name="filename">Path to the file.</param>
+			MappedFile(const std::string& filename);
+			/// <returns>True if the file was opened and mapped. An empty file is valid and has no data.</returns>
+			inline bool IsValid() const { return m_valid; }
+			/// <returns>First byte of the file, nullptr if the file is empty. Valid until MappedFile::Destroy.</returns>
+			inline const uint8_t* GetData() const { return m_data; }
+			/// <returns>Size of the file in bytes.</returns>
+			inline size_t GetSize() const { return m_size; }
+			/// <summary>
+			/// Unmap the file. Pointers returned by MappedFile::GetData must not be used anymore.
+			/// </summary>
+			void Destroy();
+		private:
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+			bool m_valid = false;
+
+#ifdef _WIN32
+			// HANDLE of CreateFileMapping.
+			void* m_mapping = nullptr;
+#endif
+		};
+	}
+}
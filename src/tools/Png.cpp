@@ -0,0 +1,143 @@
+#include "Png.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace IRun {
+	namespace Tools {
+		// Largest payload of a stored deflate block.
+		static constexpr size_t MAX_STORED_BLOCK_SIZE = 65535;
+
+		static const std::array<uint32_t, 256>& GetCrcTable() {
+			static const std::array<uint32_t, 256> table = []() {
+				std::array<uint32_t, 256> table{};
+
+				for (uint32_t i = 0; i < 256; i++) {
+					uint32_t crc = i;
+					for (uint32_t bit = 0; bit < 8; bit++)
+						crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+
+					table[i] = crc;
+				}
+
+				return table;
+			}();
+
+			return table;
+		}
+
+		static uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+			const std::array<uint32_t, 256>& table = GetCrcTable();
+
+			for (size_t i = 0; i < size; i++)
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+			return crc;
+		}
+
+		static void PushBigEndian(std::vector<uint8_t>& bytes, uint32_t value) {
+			bytes.push_back((uint8_t)(value >> 24));
+			bytes.push_back((uint8_t)(value >> 16));
+			bytes.push_back((uint8_t)(value >> 8));
+			bytes.push_back((uint8_t)value);
+		}
+
+		static void WriteChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data) {
+			std::vector<uint8_t> header{};
+			PushBigEndian(header, (uint32_t)data.size());
+			header.insert(header.end(), type, type + 4);
+
+			// The crc covers the type and the data, not the length.
+			uint32_t crc = UpdateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+			crc = UpdateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+
+			std::vector<uint8_t> footer{};
+			PushBigEndian(footer, crc);
+
+			file.write((const char*)header.data(), header.size());
+			file.write((const char*)data.data(), data.size());
+			file.write((const char*)footer.data(), footer.size());
+		}
+
+		bool WritePng(const std::string& filename, uint32_t width, uint32_t height, const uint8_t* rgba) {
+			std::ofstream file{ filename, std::ios::binary | std::ios::trunc };
+
+			if (!file.is_open()) {
+				I_LOG_ERROR("Failed to open png file: %s", filename.c_str());
+				return false;
+			}
+
+			static constexpr std::array<uint8_t, 8> signature = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			file.write((const char*)signature.data(), signature.size());
+
+			std::vector<uint8_t> header{};
+			PushBigEndian(header, width);
+			PushBigEndian(header, height);
+			// 8 bits per channel, RGBA, deflate, adaptive filtering, no interlacing.
+			header.insert(header.end(), { 8, 6, 0, 0, 0 });
+			WriteChunk(file, "IHDR", header);
+
+			// Every row starts with its filter type, 0 leaves the row as is.
+			size_t rowSize = (size_t)width * 4;
+			std::vector<uint8_t> scanlines{};
+			scanlines.reserve((rowSize + 1) * height);
+
+			for (uint32_t y = 0; y < height; y++) {
+				scanlines.push_back(0);
+				scanlines.insert(scanlines.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+			}
+
+			// A zlib stream of stored deflate blocks.
+			std::vector<uint8_t> imageData{};
+			imageData.reserve(scanlines.size() + scanlines.size() / MAX_STORED_BLOCK_SIZE * 5 + 16);
+			imageData.push_back(0x78);
+			imageData.push_back(0x01);
+
+			size_t offset = 0;
+			do {
+				size_t blockSize = std::min(scanlines.size() - offset, MAX_STORED_BLOCK_SIZE);
+				bool lastBlock = offset + blockSize == scanlines.size();
+
+				imageData.push_back(lastBlock ? 1 : 0);
+				imageData.push_back((uint8_t)blockSize);
+				imageData.push_back((uint8_t)(blockSize >> 8));
+				imageData.push_back((uint8_t)~blockSize);
+				imageData.push_back((uint8_t)(~blockSize >> 8));
+				imageData.insert(imageData.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+				offset += blockSize;
+			} while (offset < scanlines.size());
+
+			// Adler-32, reduced every 5552 bytes, the most that can be summed before b overflows.
+			uint32_t a = 1, b = 0;
+			for (size_t chunk = 0; chunk < scanlines.size(); chunk += 5552) {
+				size_t chunkEnd = std::min(chunk + 5552, scanlines.size());
+				for (size_t i = chunk; i < chunkEnd; i++) {
+					a += scanlines[i];
+					b += a;
+				}
+
+				a %= 65521;
+				b %= 65521;
+			}
+
+			PushBigEndian(imageData, (b << 16) | a);
+			WriteChunk(file, "IDAT", imageData);
+
+			WriteChunk(file, "IEND", {});
+
+			file.close();
+
+			if (!file) {
+				I_LOG_ERROR("Failed to write png file: %s", filename.c_str());
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Write 8 bit RGBA pixels to a png file. The image data is stored without compression, which is fast to write and needs no
+		/// dependencies, at the cost of files about as large as the pixels.
+		/// </summary>
+		/// <param name="filename">File to write, overwritten if it exists.</param>
+		/// <param name="width">Width in pixels.</param>
+		/// <param name="height">Height in pixels.</param>
+		/// <param name="rgba">width * height * 4 bytes, rows from top to bottom.</param>
+		/// <returns>False if the file couldn't be written.</returns>
+		bool WritePng(const std::string& filename, uint32_t width, uint32_t height, const uint8_t* rgba);
+	}
+}
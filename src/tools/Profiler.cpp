@@ -0,0 +1,208 @@
+#include "Profiler.h"
+
+#include <ILog.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace IRun {
+	namespace Tools {
+		namespace Profiler {
+			struct Event {
+				const char* name;
+				// Since the profiler's epoch.
+				uint64_t startNs;
+				uint64_t durationNs;
+			};
+
+			/// <summary>
+			/// An event in a ring buffer. Its fields are atomic because WriteChromeTrace may read an event while it is overwritten,
+			/// relaxed atomics compile to plain loads and stores.
+			/// </summary>
+			struct EventSlot {
+				std::atomic<const char*> name = nullptr;
+				std::atomic<uint64_t> startNs = 0;
+				std::atomic<uint64_t> durationNs = 0;
+			};
+
+			/// <summary>
+			/// Ring buffer of one thread. Only the owning thread writes events, WriteChromeTrace reads them while it does.
+			/// </summary>
+			struct ThreadBuffer {
+				std::unique_ptr<EventSlot[]> events;
+				// Number of events ever written, the next event goes to writeIndex % EVENTS_PER_THREAD.
+				std::atomic<uint64_t> writeIndex = 0;
+				// Number of events ever started to be written, one ahead of writeIndex while an event is written.
+				std::atomic<uint64_t> claimIndex = 0;
+				// Id of the thread in the trace.
+				uint32_t id = 0;
+				std::string name;
+				// Cleared when the thread exits so the buffer is reused by the next new thread instead of
+				// a buffer being created for every thread std::async starts.
+				std::atomic<bool> inUse = false;
+			};
+
+			struct Registry {
+				std::mutex mutex;
+				std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+				std::chrono::high_resolution_clock::time_point epoch = std::chrono::high_resolution_clock::now();
+			};
+
+			static Registry& GetRegistry() {
+				static Registry registry{};
+				return registry;
+			}
+
+			/// <summary>
+			/// Gives the buffer back when its thread exits.
+			/// </summary>
+			struct ThreadBufferHandle {
+				ThreadBuffer* buffer = nullptr;
+
+				~ThreadBufferHandle() {
+					if (buffer)
+						buffer->inUse.store(false, std::memory_order_release);
+				}
+			};
+
+			static thread_local ThreadBufferHandle t_threadBuffer{};
+
+			static ThreadBuffer& GetThreadBuffer() {
+				if (t_threadBuffer.buffer)
+					return *t_threadBuffer.buffer;
+
+				Registry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock{ registry.mutex };
+
+				for (std::unique_ptr<ThreadBuffer>& buffer : registry.buffers) {
+					bool inUse = false;
+					if (buffer->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+						t_threadBuffer.buffer = buffer.get();
+						return *buffer;
+					}
+				}
+
+				std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+				buffer->events = std::make_unique<EventSlot[]>(EVENTS_PER_THREAD);
+				buffer->id = (uint32_t)registry.buffers.size() + 1;
+				buffer->name = "Thread " + std::to_string(buffer->id);
+				buffer->inUse = true;
+
+				t_threadBuffer.buffer = buffer.get();
+				registry.buffers.push_back(std::move(buffer));
+
+				return *t_threadBuffer.buffer;
+			}
+
+			void Internal::Record(const char* name, std::chrono::high_resolution_clock::time_point start, double durationNs) {
+				ThreadBuffer& buffer = GetThreadBuffer();
+
+				uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+
+				// Tells WriteChromeTrace the slot is being overwritten before it is, like the sequence number of a seqlock.
+				buffer.claimIndex.store(index + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				EventSlot& event = buffer.events[index % EVENTS_PER_THREAD];
+				event.name.store(name, std::memory_order_relaxed);
+				event.startNs.store((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(start - GetRegistry().epoch).count(), std::memory_order_relaxed);
+				event.durationNs.store((uint64_t)durationNs, std::memory_order_relaxed);
+
+				// Publishes the event to WriteChromeTrace.
+				buffer.writeIndex.store(index + 1, std::memory_order_release);
+			}
+
+			void SetEnabled(bool enabled) {
+				// Creates the epoch before the first scope.
+				GetRegistry();
+				Internal::enabled.store(enabled, std::memory_order_relaxed);
+			}
+
+			void SetThreadName(const std::string& name) {
+				ThreadBuffer& buffer = GetThreadBuffer();
+
+				std::lock_guard<std::mutex> lock{ GetRegistry().mutex };
+				buffer.name = name;
+			}
+
+			static std::string EscapeJson(const char* string) {
+				std::string escaped{};
+
+				for (const char* c = string; *c != '\0'; c++) {
+					if (*c == '"' || *c == '\\')
+						escaped.push_back('\\');
+
+					escaped.push_back(*c);
+				}
+
+				return escaped;
+			}
+
+			bool WriteChromeTrace(const std::string& filename) {
+				std::ofstream file{ filename, std::ios::trunc };
+
+				if (!file.is_open()) {
+					I_LOG_ERROR("Failed to open trace file: %s", filename.c_str());
+					return false;
+				}
+
+				Registry& registry = GetRegistry();
+				std::lock_guard<std::mutex> lock{ registry.mutex };
+
+				// Timestamps are in microseconds, keep nanoseconds without switching to scientific notation.
+				file << std::fixed << std::setprecision(3);
+				file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+				bool first = true;
+				std::vector<Event> events{};
+				size_t eventCount = 0;
+
+				for (std::unique_ptr<ThreadBuffer>& buffer : registry.buffers) {
+					file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"" << EscapeJson(buffer->name.c_str()) << "\"}}";
+					first = false;
+
+					uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+					uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+
+					events.clear();
+					for (uint64_t i = begin; i < end; i++) {
+						const EventSlot& slot = buffer->events[i % EVENTS_PER_THREAD];
+						events.push_back({ slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed), slot.durationNs.load(std::memory_order_relaxed) });
+					}
+
+					// The owning thread may have overwritten the oldest events while they were copied. Every event it started
+					// to write by now is seen through claimIndex, the slots of those events don't hold the copied events anymore.
+					std::atomic_thread_fence(std::memory_order_acquire);
+					uint64_t claimed = buffer->claimIndex.load(std::memory_order_relaxed);
+					uint64_t firstIntact = claimed > EVENTS_PER_THREAD ? claimed - EVENTS_PER_THREAD : 0;
+
+					for (uint64_t i = std::max(begin, firstIntact); i < end; i++) {
+						const Event& event = events[(size_t)(i - begin)];
+
+						// Chrome nests complete events of a thread by their times, which gives the hierarchy.
+						file << ",\n{\"name\":\"" << EscapeJson(event.name) << "\",\"cat\":\"IRun\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+							<< ",\"ts\":" << (double)event.startNs / 1000.0 << ",\"dur\":" << (double)event.durationNs / 1000.0 << "}";
+
+						eventCount++;
+					}
+				}
+
+				file << "\n]}\n";
+				file.close();
+
+				if (!file) {
+					I_LOG_ERROR("Failed to write trace file: %s", filename.c_str());
+					return false;
+				}
+
+				I_LOG_INFO("Wrote %zu profiler scopes to %s", eventCount, filename.c_str());
+
+				return true;
+			}
+		}
+	}
+}
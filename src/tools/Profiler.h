@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <atomic>
+#include <string>
+
+namespace IRun {
+	namespace Tools {
+		/// <summary>
+		/// Cpu profiler. Scopes are written to a ring buffer of the thread they ran on, which only that thread writes to, so recording never locks.
+		/// The newest scopes of every thread can be written to a Chrome trace_event json file, open it in chrome://tracing or ui.perfetto.dev.
+		/// Disabled by default. A disabled scope costs one relaxed atomic load, so the macros can stay in release builds.
+		/// Define IRUN_DISABLE_PROFILER to compile them out.
+		/// </summary>
+		namespace Profiler {
+			/// <summary>
+			/// Scopes kept per thread, older ones are overwritten.
+			/// </summary>
+			inline constexpr uint32_t EVENTS_PER_THREAD = 16384;
+
+			namespace Internal {
+				inline std::atomic<bool> enabled = false;
+
+				void Record(const char* name, std::chrono::high_resolution_clock::time_point start, double durationNs);
+			}
+
+			/// <summary>
+			/// Start or stop recording scopes. Scopes recorded so far are kept.
+			/// </summary>
+			void SetEnabled(bool enabled);
+			/// <returns>If scopes are recorded.</returns>
+			inline bool IsEnabled() { return Internal::enabled.load(std::memory_order_relaxed); }
+			/// <summary>
+			/// Name the calling thread in the trace.
+			/// </summary>
+			void SetThreadName(const std::string& name);
+			/// <summary>
+			/// Write the scopes of every thread as a Chrome trace_event json file. Threads can keep recording while it is written,
+			/// scopes that are overwritten while they are copied are left out.
+			/// </summary>
+			/// <returns>False if the file couldn't be written.</returns>
+			bool WriteChromeTrace(const std::string& filename);
+
+			/// <summary>
+			/// Records the time from its construction to its destruction. Use IRUN_PROFILE_SCOPE or IRUN_PROFILE_FUNCTION.
+			/// </summary>
+			class Scope {
+			public:
+				/// <param name="name">Must outlive the profiler, like a string literal.</param>
+				inline Scope(const char* name) : m_name{ name }, m_enabled{ IsEnabled() } {
+					if (m_enabled)
+						m_timer.Start();
+				}
+				inline ~Scope() {
+					if (m_enabled)
+						Internal::Record(m_name, m_timer.GetStartTime(), m_timer.Stop());
+				}
+				Scope(const Scope&) = delete;
+				Scope& operator=(const Scope&) = delete;
+			private:
+				const char* m_name;
+				Timer<Nanosecond> m_timer;
+				bool m_enabled;
+			};
+		}
+	}
+}
+
+#define IRUN_PROFILE_CONCAT_INNER(a, b) a##b
+#define IRUN_PROFILE_CONCAT(a, b) IRUN_PROFILE_CONCAT_INNER(a, b)
+
+#ifndef IRUN_DISABLE_PROFILER
+// Profile the rest of the enclosing scope. name must outlive the profiler, like a string literal.
+#define IRUN_PROFILE_SCOPE(name) ::IRun::Tools::Profiler::Scope IRUN_PROFILE_CONCAT(profileScope, __LINE__){ name }
+// Profile the rest of the enclosing function, named after the function.
+#define IRUN_PROFILE_FUNCTION() IRUN_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define IRUN_PROFILE_SCOPE(name)
+#define IRUN_PROFILE_FUNCTION()
+#endif
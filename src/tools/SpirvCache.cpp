@@ -0,0 +1,213 @@
+#include "SpirvCache.h"
+
+#include "File.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+#include <ILog.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+namespace IRun {
+	namespace Tools {
+		namespace SpirvCache {
+			static constexpr uint32_t MAGIC = 0x56525053;
+			// Bump when the layout of the cache files changes.
+			static constexpr uint32_t VERSION = 1;
+
+			/// <summary>
+			/// Written in front of the spirv in every cache file.
+			/// </summary>
+			struct FileHeader {
+				uint32_t magic;
+				uint32_t version;
+				// Hash the file is named after, to catch hash collisions in file names.
+				uint64_t hash;
+				uint64_t spirvSize;
+				// How long the compiler took, used to report the time saved by a hit.
+				double compileMs;
+			};
+
+			static std::atomic<uint32_t> s_hits = 0;
+			static std::atomic<uint32_t> s_misses = 0;
+			static std::mutex s_savedMutex;
+			static double s_savedMs = 0.0;
+
+			// 64 bit FNV-1a.
+			static void HashBytes(uint64_t& hash, const void* data, size_t size) {
+				const uint8_t* bytes = (const uint8_t*)data;
+				for (size_t i = 0; i < size; i++) {
+					hash ^= bytes[i];
+					hash *= 0x100000001b3ull;
+				}
+			}
+
+			// Length prefixed so "ab" + "c" and "a" + "bc" don't hash the same.
+			static void HashString(uint64_t& hash, const std::string& string) {
+				uint64_t size = string.size();
+				HashBytes(hash, &size, sizeof(size));
+				HashBytes(hash, string.data(), string.size());
+			}
+
+			static void HashIncludes(uint64_t& hash, const std::filesystem::path& directory, const std::string& source, std::unordered_set<std::string>& visited) {
+				std::istringstream lines{ source };
+				std::string line{};
+
+				while (std::getline(lines, line)) {
+					size_t include = line.find("#include");
+					if (include == std::string::npos)
+						continue;
+
+					size_t begin = line.find('"', include);
+					size_t end = begin == std::string::npos ? std::string::npos : line.find('"', begin + 1);
+					if (end == std::string::npos)
+						continue;
+
+					std::filesystem::path path = directory / line.substr(begin + 1, end - begin - 1);
+					std::string pathString = path.lexically_normal().string();
+
+					if (!visited.insert(pathString).second)
+						continue;
+
+					HashString(hash, pathString);
+
+					// A missing include still changes the hash through its name, the compiler reports the error.
+					std::ifstream file{ path, std::ios::binary };
+					if (!file.is_open())
+						continue;
+
+					std::string includeSource{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+					HashString(hash, includeSource);
+					HashIncludes(hash, path.parent_path(), includeSource, visited);
+				}
+			}
+
+			static uint64_t HashKey(const Key& key) {
+				uint64_t hash = 0xcbf29ce484222325ull;
+
+				HashString(hash, key.source);
+				HashString(hash, key.entryPoint);
+				HashString(hash, key.profile);
+				HashString(hash, key.arguments);
+				HashString(hash, key.compilerVersion);
+
+				std::unordered_set<std::string> visited{};
+				HashIncludes(hash, std::filesystem::path{ key.filename }.parent_path(), key.source, visited);
+
+				return hash;
+			}
+
+			static std::string GetCacheFilename(uint64_t hash) {
+				char name[17]{};
+				snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+				return CACHE_DIRECTORY + name + ".spv";
+			}
+
+			static bool ReadCacheFile(const std::string& filename, uint64_t hash, std::vector<char>& spirv, double& compileMs) {
+				std::ifstream file{ filename, std::ios::binary };
+				if (!file.is_open())
+					return false;
+
+				FileHeader header{};
+				file.read((char*)&header, sizeof(header));
+
+				if (!file || header.magic != MAGIC || header.version != VERSION || header.hash != hash)
+					return false;
+
+				spirv.resize((size_t)header.spirvSize);
+				file.read(spirv.data(), spirv.size());
+
+				if (!file)
+					return false;
+
+				compileMs = header.compileMs;
+				return true;
+			}
+
+			static void WriteCacheFile(const std::string& filename, uint64_t hash, const std::vector<char>& spirv, double compileMs) {
+				std::error_code error{};
+				std::filesystem::create_directories(CACHE_DIRECTORY, error);
+
+				// Written to a file of its own first so other threads and processes never read half of a file.
+				std::string tempFilename = filename + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+				{
+					std::ofstream file{ tempFilename, std::ios::binary | std::ios::trunc };
+					if (!file.is_open()) {
+						I_LOG_WARNING("Failed to write spirv cache file: %s", tempFilename.c_str());
+						return;
+					}
+
+					FileHeader header{ MAGIC, VERSION, hash, (uint64_t)spirv.size(), compileMs };
+					file.write((const char*)&header, sizeof(header));
+					file.write(spirv.data(), spirv.size());
+				}
+
+				std::filesystem::rename(tempFilename, filename, error);
+				// Another thread may have written the same entry first.
+				if (error)
+					std::filesystem::remove(tempFilename, error);
+			}
+
+			std::vector<char> GetOrCompile(const Key& key, const std::function<std::vector<char>()>& compile) {
+				IRUN_PROFILE_SCOPE("SpirvCache::GetOrCompile");
+
+				Timer<Milliseconds> timer{};
+				timer.Start();
+
+				uint64_t hash = HashKey(key);
+				std::string filename = GetCacheFilename(hash);
+
+				std::vector<char> spirv{};
+				double compileMs = 0.0;
+
+				if (ReadCacheFile(filename, hash, spirv, compileMs)) {
+					double readMs = timer.Stop();
+
+					s_hits++;
+					{
+						std::lock_guard<std::mutex> lock{ s_savedMutex };
+						s_savedMs += std::max(compileMs - readMs, 0.0);
+					}
+
+					I_DEBUG_LOG_TRACE("Spirv cache hit: %s (%s)", key.filename.c_str(), filename.c_str());
+					return spirv;
+				}
+
+				timer.Start();
+				spirv = compile();
+				compileMs = timer.Stop();
+
+				s_misses++;
+
+				if (!spirv.empty())
+					WriteCacheFile(filename, hash, spirv, compileMs);
+
+				I_DEBUG_LOG_TRACE("Spirv cache miss: %s (%s), compiled in %.3f ms", key.filename.c_str(), filename.c_str(), compileMs);
+				return spirv;
+			}
+
+			Stats GetStats() {
+				Stats stats{};
+				stats.hits = s_hits;
+				stats.misses = s_misses;
+
+				std::lock_guard<std::mutex> lock{ s_savedMutex };
+				stats.savedMs = s_savedMs;
+
+				return stats;
+			}
+
+			void LogStats() {
+				Stats stats = GetStats();
+				I_LOG_INFO("Spirv cache: %u hits, %u misses, %.3f ms of compilation saved.", stats.hits, stats.misses, stats.savedMs);
+			}
+		}
+	}
+}
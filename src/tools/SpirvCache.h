@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace IRun {
+	namespace Tools {
+		namespace SpirvCache {
+			/// <summary>
+			/// Directory compiled shaders are stored in, next to the pipeline cache.
+			/// </summary>
+			inline const std::string CACHE_DIRECTORY = "shaders/cache/spirv/";
+
+			/// <summary>
+			/// Everything the spirv of a shader depends on. Two keys with the same contents always produce the same spirv.
+			/// </summary>
+			struct Key {
+				// Path of the shader, include files are looked up relative to it.
+				std::string filename;
+				// Contents of the shader file.
+				std::string source;
+				std::string entryPoint;
+				// e.g. vs_6_1 or the glslang stage.
+				std::string profile;
+				// Any other compiler arguments.
+				std::string arguments;
+				std::string compilerVersion;
+			};
+
+			/// <summary>
+			/// Hit and miss counts since the start of the application.
+			/// </summary>
+			struct Stats {
+				uint32_t hits = 0;
+				uint32_t misses = 0;
+				// Sum of the compile times recorded when the hit entries were compiled, minus the time spent reading them.
+				double savedMs = 0.0;
+			};
+
+			/// <summary>
+			/// Return the cached spirv of key, or compile it and store the result in the cache.
+			/// The cache key is a hash of every field of key and the contents of every file included with #include "...". Thread safe.
+			/// </summary>
+			/// <param name="key">Description of the shader.</param>
+			/// <param name="compile">Called on a miss. Must return the spirv byte code of key.</param>
+			/// <returns>Spirv byte code.</returns>
+			std::vector<char> GetOrCompile(const Key& key, const std::function<std::vector<char>()>& compile);
+			/// <returns>Hit and miss counts since the start of the application.</returns>
+			Stats GetStats();
+			/// <summary>
+			/// Log the hit and miss counts and the time saved with ILog.
+			/// </summary>
+			void LogStats();
+		}
+	}
+}
@@ -31,6 +31,8 @@ namespace IRun {
 				Period dur = (std::chrono::high_resolution_clock::now() - m_startTime);
 				return dur.count();
 			}
+			/// <returns>Time the timer was started at.</returns>
+			inline std::chrono::high_resolution_clock::time_point GetStartTime() const { return m_startTime; }
 		private:
 			std::chrono::high_resolution_clock::time_point m_startTime;
 		};
@@ -1,44 +1,127 @@
 #include "HLSLCompiler.h"
 
+#include "tools/SpirvCache.h"
+#include "tools/Profiler.h"
+
 
 namespace IRun {
 	namespace Tools {
 		namespace DXC {
-			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename)
-			{
-				std::string vertShaderSource = ReadFile(vertShaderFilename);
-				std::string fragShaderSource = ReadFile(fragmentShaderFilename);
+			/// <summary>
+			/// DXC instances of one thread. DXC objects must not be used by two threads at once, so every thread gets its own.
+			/// </summary>
+			struct Instances {
+				CComPtr<IDxcLibrary> library;
+				CComPtr<IDxcCompiler3> compiler;
+				CComPtr<IDxcUtils> utils;
 
-				HRESULT result;
+				Instances() {
+					HRESULT result;
 
-				// Init DXC
-				CComPtr<IDxcLibrary> library;
-				result = DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&library));
-				if (FAILED(result)) {
-					I_LOG_FATAL_ERROR("Failed to init dxc library! Abort!");
-					exit(EXIT_FAILURE);
-				}
+					// Init DXC
+					result = DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&library));
+					if (FAILED(result)) {
+						I_LOG_FATAL_ERROR("Failed to init dxc library! Abort!");
+						exit(EXIT_FAILURE);
+					}
 
+					// Init DXC compiler
+					result = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler));
+					if (FAILED(result)) {
+						I_LOG_FATAL_ERROR("Failed to init dxc compiler! Abort!");
+						exit(EXIT_FAILURE);
+					}
 
-				// Init DXC compiler
-				CComPtr<IDxcCompiler3> compiler;
-				result = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler));
-				if (FAILED(result)) {
-					I_LOG_FATAL_ERROR("Failed to init dxc utility! Abort!");
-					exit(EXIT_FAILURE);
+					// Initialize DXC utility
+					result = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils));
+					if (FAILED(result)) {
+						I_LOG_FATAL_ERROR("Failed to init dxc utility! Abort");
+						exit(EXIT_FAILURE);
+					}
 				}
+			};
+
+			// Created the first time a thread compiles a shader and reused for every compile after.
+			// Only created on a spirv cache miss, so a warm start never initializes DXC per thread.
+			static Instances& GetInstances() {
+				static thread_local Instances instances{};
+				return instances;
+			}
+
+			// Part of the spirv cache key so a new compiler never reuses spirv of an old one.
+			static const std::string& GetCompilerVersion() {
+				static const std::string version = []() {
+					std::string version = "dxc";
+
+					CComPtr<IDxcVersionInfo> versionInfo;
+					if (SUCCEEDED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&versionInfo)))) {
+						UINT32 major = 0, minor = 0;
+						versionInfo->GetVersion(&major, &minor);
+						version += " " + std::to_string(major) + "." + std::to_string(minor);
+					}
+
+					return version;
+				}();
+
+				return version;
+			}
+
+			static std::vector<char> CompileShader(IDxcCompiler3* compiler, const std::string& source, LPCWSTR* args, uint32_t argCount, const char* stageName, bool exitOnError) {
+				IRUN_PROFILE_SCOPE("DXC::CompileShader");
+
+				// Runs only on a spirv cache miss.
+				DxcBuffer sourceBuf{};
+				sourceBuf.Encoding = DXC_CP_ACP;
+				sourceBuf.Ptr = source.c_str();
+				sourceBuf.Size = source.size();
+
+				CComPtr<IDxcResult> binSource{ nullptr };
+				HRESULT result = compiler->Compile(
+					&sourceBuf,
+					args,
+					argCount,
+					nullptr,
+					IID_PPV_ARGS(&binSource)
+				);
+
+				if (SUCCEEDED(result))
+					binSource->GetStatus(&result);
 
-				// Initialize DXC utility
-				CComPtr<IDxcUtils> utils;
-				result = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils));
 				if (FAILED(result)) {
-					I_LOG_FATAL_ERROR("Failed to init dxc compiler! Abort");
-					exit(EXIT_FAILURE);
+					std::string errors = "Unknown error";
+
+					CComPtr<IDxcBlobEncoding> errorBuf;
+					if (binSource && SUCCEEDED(binSource->GetErrorBuffer(&errorBuf)) && errorBuf)
+						errors = std::string{ (const char*)errorBuf->GetBufferPointer(), errorBuf->GetBufferSize() };
+
+					if (exitOnError) {
+						I_LOG_FATAL_ERROR("Failed to compile %s shader:\n\n%s\n\nAbort!", stageName, errors.c_str());
+						exit(EXIT_FAILURE);
+					}
+
+					// An empty result is never stored in the spirv cache.
+					I_LOG_ERROR("Failed to compile %s shader:\n\n%s", stageName, errors.c_str());
+					return {};
 				}
 
+				CComPtr<IDxcBlob> code;
+				binSource->GetResult(&code);
+
+				return { (char*)code->GetBufferPointer(), (char*)code->GetBufferPointer() + code->GetBufferSize() };
+			}
+
+			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename, bool exitOnError)
+			{
+				IRUN_PROFILE_FUNCTION();
+
+				std::string vertShaderSource = ReadFile(vertShaderFilename);
+				std::string fragShaderSource = ReadFile(fragmentShaderFilename);
 
 				if (vertShaderSource == "" || fragShaderSource == "") {
-					I_LOG_FATAL_ERROR("Failed to read shader file(s): %s,\n%s\nAbort!", vertShaderFilename, fragmentShaderFilename);
+					if (!exitOnError)
+						return {};
+
+					I_LOG_FATAL_ERROR("Failed to read shader file(s): %s,\n%s\nAbort!", vertShaderFilename.c_str(), fragmentShaderFilename.c_str());
 					exit(EXIT_FAILURE);
 				}
 
@@ -48,9 +131,9 @@ namespace IRun {
 					// Target profile
 					L"-T", L"vs_6_1",
 					// Compile to SPRIV
-					L"-spirv", 
+					L"-spirv",
 					// Preprocessor so that the hlsl files know if we are compiling for Vulkan/GL or DirectX
-					L"-D",  L"KHR", 
+					L"-D",  L"KHR",
 				};
 
 				LPCWSTR fragArgs[] = {
@@ -64,80 +147,14 @@ namespace IRun {
 					L"-D",  L"KHR",
 				};
 
-				DxcBuffer vertBuf{};
-				vertBuf.Encoding = DXC_CP_ACP;
-				vertBuf.Ptr = vertShaderSource.c_str();
-				vertBuf.Size = vertShaderSource.size();
-
-				CComPtr<IDxcResult> vertBinSource{ nullptr };
-				result = compiler->Compile(
-					&vertBuf, 
-					vertArgs, 
-					sizeof(vertArgs) / sizeof(LPCWSTR), 
-					nullptr, 
-					IID_PPV_ARGS(&vertBinSource)
-				);
-
-				if (SUCCEEDED(result))
-					vertBinSource->GetStatus(&result);
+				// The profile and entry point are in the arguments, every argument is part of the cache key.
+				SpirvCache::Key vertKey{ vertShaderFilename, vertShaderSource, "main", "vs_6_1", "-spirv -D KHR", GetCompilerVersion() };
+				SpirvCache::Key fragKey{ fragmentShaderFilename, fragShaderSource, "main", "ps_6_1", "-spirv -D KHR", GetCompilerVersion() };
 
-				if (FAILED(result) && (vertBinSource)) {
-					CComPtr<IDxcBlobEncoding> errorBuf;
-					result = vertBinSource->GetErrorBuffer(&errorBuf);
-					if (SUCCEEDED(result) && errorBuf) {
-						I_LOG_FATAL_ERROR("Failed to compile vertex shader:\n\n%s\n\nAbort!", errorBuf->GetBufferPointer());
-						exit(EXIT_FAILURE);
-					}
-				
-				}
-
-				DxcBuffer fragBuf{};
-				fragBuf.Encoding = DXC_CP_ACP;
-				fragBuf.Ptr = fragShaderSource.c_str();
-				fragBuf.Size = fragShaderSource.size();
-
-
-				CComPtr<IDxcResult> fragBinSource{ nullptr };
-				result = compiler->Compile(
-					&fragBuf,
-					fragArgs,
-					sizeof(vertArgs) / sizeof(LPCWSTR),
-					nullptr,
-					IID_PPV_ARGS(&fragBinSource)
-				);
-
-				if (SUCCEEDED(result))
-					fragBinSource->GetStatus(&result);
-
-				if (FAILED(result) && (fragBinSource)) {
-					CComPtr<IDxcBlobEncoding> errorBuf;
-					result = fragBinSource->GetErrorBuffer(&errorBuf);
-					if (SUCCEEDED(result) && errorBuf) {
-						I_LOG_FATAL_ERROR("Failed to compile fragment shader:\n\n%s\n\nAbort!", errorBuf->GetBufferPointer());
-						exit(EXIT_FAILURE);
-					}
-				}
-
-
-				CComPtr<IDxcBlob> vertCode;
-				vertBinSource->GetResult(&vertCode);
-				CComPtr<IDxcBlob> fragCode;
-				fragBinSource->GetResult(&fragCode);
-				vertBinSource.Release();
-				fragBinSource.Release();
-				utils.Release();
-				compiler.Release();
-				
-				std::vector<char> finalVertCode{};
-				std::vector<char> finalFragCode{};
-				
-				finalVertCode = { (char*)vertCode->GetBufferPointer(), (char*)vertCode->GetBufferPointer() + vertCode->GetBufferSize() };
-				finalFragCode = { (char*)fragCode->GetBufferPointer(), (char*)fragCode->GetBufferPointer() + fragCode->GetBufferSize() };
-
-				vertCode.Release();
-				fragCode.Release();
-
-				return { finalVertCode, finalFragCode };
+				return {
+					SpirvCache::GetOrCompile(vertKey, [&]() { return CompileShader(GetInstances().compiler, vertShaderSource, vertArgs, sizeof(vertArgs) / sizeof(LPCWSTR), "vertex", exitOnError); }),
+					SpirvCache::GetOrCompile(fragKey, [&]() { return CompileShader(GetInstances().compiler, fragShaderSource, fragArgs, sizeof(fragArgs) / sizeof(LPCWSTR), "fragment", exitOnError); })
+				};
 			}
 		}
 	}
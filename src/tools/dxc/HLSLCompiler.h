@@ -1,9 +1,9 @@
 #pragma once
 
-#include "tools\File.h"
+#include "tools/File.h"
 
 #include <atlbase.h>
-#include <dxc\dxcapi.h>
+#include <dxc/dxcapi.h>
 #include <array>
 
 
@@ -12,11 +12,14 @@ namespace IRun {
 		namespace DXC {
 			/// <summary>
 			/// Allows the compilation of HLSL to SPIRV 
+			/// Every thread keeps its own DXC library, compiler and utils so they are created once per thread instead of once per call
+			/// and several threads can compile at the same time.
 			/// </summary>
 			/// <param name="vertShaderFilename">The file path to the vertex HLSL code</param>
 			/// <param name="fragmentShaderFilename">The file path to the fragment HLSL code</param>
-			/// <returns>Array of SPRIV byte code the 1st index is the vertex shader code and the 2nd index is the fragment shader code. Must call CComPtr::Release when finished with buffer.</returns>
-			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename);
+			/// <param name="exitOnError">If false a shader that fails to read or compile is logged and returned empty instead of ending the application.</param>
+			/// <returns>Array of SPRIV byte code the 1st index is the vertex shader code and the 2nd index is the fragment shader code.</returns>
+			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename, bool exitOnError = true);
 		}
 	}
 }
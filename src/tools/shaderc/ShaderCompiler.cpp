@@ -1,5 +1,10 @@
 #include "ShaderCompiler.h"
 
+#include "tools/SpirvCache.h"
+#include "tools/Profiler.h"
+
+#include <glslang/build_info.h>
+
 namespace IRun {
 	namespace Tools {
 		namespace Shaders {
@@ -124,9 +129,10 @@ namespace IRun {
                 } };
 
 
-			std::vector<const char*> CompileToSpirvBinary(const std::string& fileName, ShaderType type, ShaderLanguage lang)
-			{
-				std::string sourceCode = ReadFile(fileName);
+            static std::vector<char> CompileGlslang(const std::string& fileName, const std::string& sourceCode, ShaderType type, ShaderLanguage lang, bool exitOnError)
+            {
+                // Runs only on a spirv cache miss.
+				IRUN_PROFILE_SCOPE("Glslang::Compile");
 
 				glslang_input_t input{};
 				input.language = (glslang_source_t)lang;
@@ -142,11 +148,27 @@ namespace IRun {
 				input.messages = GLSLANG_MSG_DEBUG_INFO_BIT;
                 input.resource = (glslang_resource_t*)&DefaultTBuiltInResource;
 
+                if (lang == ShaderLanguage::HLSL)
+                    input.messages = (glslang_messages_t)(input.messages | GLSLANG_MSG_READ_HLSL_BIT);
+
                 glslang_initialize_process();
 
                 glslang_shader_t* shader = glslang_shader_create(&input);
 
+                if (lang == ShaderLanguage::HLSL) {
+                    // Same entry point and define as the DXC compile, so the hlsl files know they are compiled for Vulkan.
+                    glslang_shader_set_entry_point(shader, "main");
+                    glslang_shader_set_preamble(shader, "#define KHR\n");
+                }
+
                 if (!glslang_shader_parse(shader, &input)) {
+                    if (!exitOnError) {
+                        // An empty result is never stored in the spirv cache.
+                        I_LOG_ERROR("Failed to compile shader (%s):\n\n%s", fileName.c_str(), glslang_shader_get_info_log(shader));
+                        glslang_shader_delete(shader);
+                        return { };
+                    }
+
                     I_DEBUG_LOG_FATAL_ERROR("Failed to compile shader (%s):\n\n%s\n\nAbort!", fileName.c_str(), glslang_shader_get_info_log(shader));
                     I_DEBUG_LOG_FATAL_ERROR("(Debug Log): Failed to compile shader (%s):\n\n%s\n\nAbort!", fileName.c_str(), glslang_shader_get_info_debug_log(shader));
                     exit(EXIT_FAILURE);
@@ -157,6 +179,13 @@ namespace IRun {
                 glslang_program_add_shader(program, shader);
 
                 if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT)) {
+                    if (!exitOnError) {
+                        I_LOG_ERROR("Failed to link shader (%s):\n\n%s", fileName.c_str(), glslang_program_get_info_log(program));
+                        glslang_program_delete(program);
+                        glslang_shader_delete(shader);
+                        return { };
+                    }
+
                     I_DEBUG_LOG_FATAL_ERROR("Failed to link shader (%s):\n\n%s\n\nAbort!", fileName.c_str(), glslang_shader_get_info_log(shader));
                     I_DEBUG_LOG_FATAL_ERROR("(Debug Log): Failed to link shader (%s):\n\n%s\n\nAbort!", fileName.c_str(), glslang_shader_get_info_debug_log(shader));
                     exit(EXIT_FAILURE);
@@ -172,11 +201,73 @@ namespace IRun {
 
                 glslang_shader_delete(shader);
 
-                std::vector<const char*> resultBin(glslang_program_SPIRV_get_size(program));
-                memcpy(resultBin.data(), glslang_program_SPIRV_get_ptr(program), resultBin.size());
+                // glslang returns the size in words.
+                const char* spirv = (const char*)glslang_program_SPIRV_get_ptr(program);
+                std::vector<char> resultBin(spirv, spirv + glslang_program_SPIRV_get_size(program) * sizeof(uint32_t));
 
                 glslang_program_delete(program);
 
+				return resultBin;
+            }
+
+            // Part of the spirv cache key so a new compiler never reuses spirv of an old one.
+            static const std::string& GetCompilerVersion() {
+                static const std::string version = "glslang " + std::to_string(GLSLANG_VERSION_MAJOR) + "." + std::to_string(GLSLANG_VERSION_MINOR) + "." + std::to_string(GLSLANG_VERSION_PATCH);
+                return version;
+            }
+
+            static std::vector<char> CompileCached(const std::string& fileName, const std::string& sourceCode, ShaderType type, ShaderLanguage lang, bool exitOnError)
+            {
+                std::string arguments = "vulkan 1.3 spv 1.6 460";
+                if (lang == ShaderLanguage::HLSL)
+                    arguments += " -D KHR";
+
+                SpirvCache::Key key{ fileName, sourceCode, "main", std::to_string((int)type) + " " + std::to_string((int)lang), arguments, GetCompilerVersion() };
+                return SpirvCache::GetOrCompile(key, [&]() { return CompileGlslang(fileName, sourceCode, type, lang, exitOnError); });
+            }
+
+			std::vector<uint32_t> CompileToSpirvBinaryUint32_t(const std::string& fileName, ShaderType type, ShaderLanguage lang)
+			{
+				IRUN_PROFILE_FUNCTION();
+
+				std::string sourceCode = ReadFile(fileName);
+
+                std::vector<char> spirv = CompileCached(fileName, sourceCode, type, lang, true);
+
+                std::vector<uint32_t> resultBin(spirv.size() / sizeof(uint32_t));
+                memcpy(resultBin.data(), spirv.data(), resultBin.size() * sizeof(uint32_t));
+
+				return resultBin;
+			}
+
+			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename, bool exitOnError)
+			{
+				IRUN_PROFILE_FUNCTION();
+
+				std::string vertShaderSource = ReadFile(vertShaderFilename);
+				std::string fragShaderSource = ReadFile(fragmentShaderFilename);
+
+				if (vertShaderSource == "" || fragShaderSource == "") {
+					if (!exitOnError)
+						return {};
+
+					I_LOG_FATAL_ERROR("Failed to read shader file(s): %s,\n%s\nAbort!", vertShaderFilename.c_str(), fragmentShaderFilename.c_str());
+					exit(EXIT_FAILURE);
+				}
+
+				return {
+					CompileCached(vertShaderFilename, vertShaderSource, ShaderType::Vertex, ShaderLanguage::HLSL, exitOnError),
+					CompileCached(fragmentShaderFilename, fragShaderSource, ShaderType::Fragment, ShaderLanguage::HLSL, exitOnError)
+				};
+			}
+
+			std::vector<const char*> CompileToSpirvBinary(const std::string& fileName, ShaderType type, ShaderLanguage lang)
+			{
+                std::vector<uint32_t> spirv = CompileToSpirvBinaryUint32_t(fileName, type, lang);
+
+                std::vector<const char*> resultBin(spirv.size());
+                memcpy(resultBin.data(), spirv.data(), resultBin.size());
+
 				return resultBin;
 			}
 		}
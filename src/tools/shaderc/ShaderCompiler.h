@@ -4,10 +4,11 @@
 #include <glslang/Include/glslang_c_interface.h>
 #include <glslang/Public/ResourceLimits.h>
 
+#include <array>
 #include <string>
 #include <vector>
 
-#include "tools\File.h"
+#include "tools/File.h"
 namespace IRun {
 	namespace Tools {
 		namespace Shaders {
@@ -24,6 +25,15 @@ namespace IRun {
 
 			std::vector<uint32_t> CompileToSpirvBinaryUint32_t(const std::string& fileName, ShaderType type, ShaderLanguage lang);
 			std::vector<const char*> CompileToSpirvBinary(const std::string& fileName, ShaderType type, ShaderLanguage lang);
+			/// <summary>
+			/// Compile HLSL to SPIRV with glslang, for platforms without DXC. Takes and returns the same as IRun::Tools::DXC::CompileHLSLtoSPRIV
+			/// and shares its spirv cache directory, the compiler version in the cache key keeps the two apart.
+			/// </summary>
+			/// <param name="vertShaderFilename">The file path to the vertex HLSL code</param>
+			/// <param name="fragmentShaderFilename">The file path to the fragment HLSL code</param>
+			/// <param name="exitOnError">If false a shader that fails to read or compile is logged and returned empty instead of ending the application.</param>
+			/// <returns>Array of SPRIV byte code the 1st index is the vertex shader code and the 2nd index is the fragment shader code.</returns>
+			std::array<std::vector<char>, 2> CompileHLSLtoSPRIV(const std::string& vertShaderFilename, const std::string& fragmentShaderFilename, bool exitOnError = true);
 				
 		}
 	}
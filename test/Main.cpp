@@ -112,7 +112,7 @@ int TestGL() {
     return EXIT_SUCCESS;
 }
 
-#include <ecs\Components.h>
+#include <ecs/Components.h>
 #include <renderer/vulkan/Renderer.h>
 #include <thread>
 
@@ -20,6 +20,7 @@ public:
         camera = IRun::Camera3D{ 90.0f, 1280.0f / 720.0f, glm::vec2{ 0.1f, 100.0f }, glm::vec3{ 0.0f, 0.0f, 3.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f } };
 
         renderer = { window, camera, helper, true };
+        renderer.SetJobSystem(&jobSystem);
 
         std::vector<IRun::Vertex> vertexData = {
             { { -0.5f, -0.5f,  0.0f }, { 0.0f, 1.0f } },  // Top Left:     0
@@ -33,24 +34,41 @@ public:
             2, 3, 0  // Bottom Right
         };
 
-        IRun::ECS::Entity entity = helper.create<IRun::ECS::VertexData, IRun::ECS::IndexData, IRun::ECS::Shader>(
-            {
-                vertexData
-            },
-            {
-                indexData
-            },
-            {
-                "shaders/vert.hlsl",
-                "shaders/frag.hlsl",
-                IRun::ShaderLanguage::HLSL
-            }
-        );
+        IRun::ECS::Shader quadShader = {
+            "shaders/vert.hlsl",
+            "shaders/frag.hlsl",
+            IRun::ShaderLanguage::HLSL
+        };
 
-        for (int i = 0; i < 1; i++) {
-            renderer.AddEntity(entity);
+        // Compile every shader up front instead of in AddEntity.
+        std::vector<uint32_t> pipelines = renderer.CreateGraphicsPipelines({ quadShader });
+
+        // Every quad shares one mesh so they are drawn with a single instanced draw call.
+        uint32_t quadMesh = renderer.CreateMesh({ vertexData }, { indexData });
+
+        for (int y = 0; y < 10; y++) {
+            for (int x = 0; x < 10; x++) {
+                IRun::ECS::Entity entity = helper.create<IRun::ECS::Mesh, IRun::ECS::Shader, IRun::ECS::Transform>(
+                    {
+                        quadMesh
+                    },
+                    quadShader,
+                    {
+                        { (float)x - 4.5f, (float)y - 4.5f, 0.0f },
+                        { 0.4f, 0.4f, 0.4f },
+                        { 0.0f, 0.0f, 0.0f }
+                    }
+                );
+
+                renderer.AddEntity(entity);
+            }
         }
 
+        renderer.DestroyMesh(quadMesh);
+
+        for (uint32_t pipeline : pipelines)
+            renderer.DestroyGraphicsPipeline(pipeline);
+
         window.SetUserPointer(this);
 
         window.SetMouseMoveCallback(MouseMoveCallback);
@@ -79,8 +97,16 @@ public:
     const glm::vec3 cameraUp = { 0.0f, 1.0f, 0.0f };
 
     virtual void OnUpdate(double deltaTimeMs) override {
+        const IRun::Vk::FrameTimings& timings = renderer.GetFrameTimings();
+
         std::wstring title{ L"Delta Time (ms): " };
         title.append(std::to_wstring(deltaTimeMs));
+        title.append(L" Cpu (ms): ");
+        title.append(std::to_wstring(timings.cpuMs));
+        title.append(L" Gpu (ms): ");
+        title.append(std::to_wstring(timings.gpuMs));
+        title.append(L" Present (ms): ");
+        title.append(std::to_wstring(timings.presentIntervalMs));
         window.SetTitle(title);
 
         if (window.IsKeyDown(IWindow::Key::W))
@@ -3,15 +3,21 @@ cbuffer MVP
 {
     matrix<float, 4, 4> proj;
     matrix<float, 4, 4> view;
-    matrix<float, 4, 4> model;
 };
 
+// Model matrix of every entity, indexed with transformIndex.
+[[vk::binding(1, 0)]]
+StructuredBuffer<matrix<float, 4, 4> > transforms;
+
 struct VSInput
 {
     [[vk::location(0)]]  
     float3 position : POSITION0;
     [[vk::location(1)]]   
     float2 uv : TEXCOORD0;
+
+    [[vk::location(2)]]
+    uint transformIndex : TRANSFORM_INDEX;
 };
 
 struct VSOutput
@@ -25,7 +31,7 @@ struct VSOutput
 VSOutput main( in VSInput input ) 
 {
     VSOutput output = (VSOutput) 0;
-    output.position = mul(proj, mul(view, mul(model, float4(input.position, 1.0f))));
+    output.position = mul(proj, mul(view, mul(transforms[input.transformIndex], float4(input.position, 1.0f))));
     output.uv = input.uv;
 	return output;
 }
\ No newline at end of file